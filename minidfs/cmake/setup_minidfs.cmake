@@ -47,4 +47,24 @@ target_include_directories(minidfs
 target_link_libraries(minidfs PUBLIC
     protobuf::libprotobuf
     gRPC::grpc++
-)
\ No newline at end of file
+)
+
+# --- 5. Optional chunk codecs ---
+# Each one found is compiled into dfs/chunk_codec.cpp; peers negotiate which they share.
+find_package(zstd CONFIG QUIET)
+if(zstd_FOUND)
+    target_compile_definitions(minidfs PRIVATE MINIDFS_ZSTD=1)
+    target_link_libraries(minidfs PRIVATE $<IF:$<TARGET_EXISTS:zstd::libzstd_shared>,zstd::libzstd_shared,zstd::libzstd_static>)
+endif()
+
+find_package(lz4 CONFIG QUIET)
+if(lz4_FOUND)
+    target_compile_definitions(minidfs PRIVATE MINIDFS_LZ4=1)
+    target_link_libraries(minidfs PRIVATE lz4::lz4)
+endif()
+
+find_package(ZLIB QUIET)
+if(ZLIB_FOUND)
+    target_compile_definitions(minidfs PRIVATE MINIDFS_ZLIB=1)
+    target_link_libraries(minidfs PRIVATE ZLIB::ZLIB)
+endif()
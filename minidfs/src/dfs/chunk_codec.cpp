@@ -0,0 +1,231 @@
+#include "dfs/chunk_codec.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include "dfs/storage/crc32c.h"
+
+#ifdef MINIDFS_ZSTD
+#include <zstd.h>
+#endif
+#ifdef MINIDFS_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef MINIDFS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+uint64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+#ifdef MINIDFS_ZSTD
+struct ZstdFree {
+    void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); }
+    void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+// contexts hold the codec's working memory; one per thread saves reallocating it per chunk
+ZSTD_CCtx* ThreadCCtx() {
+    thread_local std::unique_ptr<ZSTD_CCtx, ZstdFree> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+
+ZSTD_DCtx* ThreadDCtx() {
+    thread_local std::unique_ptr<ZSTD_DCtx, ZstdFree> ctx(ZSTD_createDCtx());
+    return ctx.get();
+}
+#endif
+
+int ClampLevel(minidfs::Codec codec, int level) {
+    switch (codec) {
+#ifdef MINIDFS_ZSTD
+    case minidfs::CODEC_ZSTD:
+        return level == 0 ? ZSTD_CLEVEL_DEFAULT : std::clamp(level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+#endif
+#ifdef MINIDFS_LZ4
+    // negative levels trade ratio for speed (LZ4 acceleration), positive ones pick LZ4HC
+    case minidfs::CODEC_LZ4:
+        return std::clamp(level, -65537, LZ4HC_CLEVEL_MAX);
+#endif
+#ifdef MINIDFS_ZLIB
+    // deflate's own default (6) is too slow to keep up with a link; 1 is the default here
+    case minidfs::CODEC_DEFLATE:
+        return level == 0 ? Z_BEST_SPEED : std::clamp(level, Z_BEST_SPEED, Z_BEST_COMPRESSION);
+#endif
+    default:
+        return 0;
+    }
+}
+
+// Compresses size bytes into out, which is sized to the result; 0 on failure.
+size_t CompressInto(minidfs::Codec codec, int level, const char* data, size_t size, std::string* out) {
+    switch (codec) {
+#ifdef MINIDFS_ZSTD
+    case minidfs::CODEC_ZSTD: {
+        out->resize(ZSTD_compressBound(size));
+        size_t n = ZSTD_compressCCtx(ThreadCCtx(), out->data(), out->size(), data, size, level);
+        return ZSTD_isError(n) ? 0 : n;
+    }
+#endif
+#ifdef MINIDFS_LZ4
+    case minidfs::CODEC_LZ4: {
+        out->resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(size))));
+        int n = level > 0
+            ? LZ4_compress_HC(data, out->data(), static_cast<int>(size), static_cast<int>(out->size()), level)
+            : LZ4_compress_fast(data, out->data(), static_cast<int>(size), static_cast<int>(out->size()), 1 - level);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+#endif
+#ifdef MINIDFS_ZLIB
+    case minidfs::CODEC_DEFLATE: {
+        uLongf n = compressBound(static_cast<uLong>(size));
+        out->resize(n);
+        int rc = compress2(reinterpret_cast<Bytef*>(out->data()), &n, reinterpret_cast<const Bytef*>(data), static_cast<uLong>(size), level);
+        return rc == Z_OK ? static_cast<size_t>(n) : 0;
+    }
+#endif
+    default:
+        return 0;
+    }
+}
+
+// Decompresses into out, already sized to the expected raw length.
+bool DecompressInto(minidfs::Codec codec, const std::string& data, std::string* out) {
+    switch (codec) {
+#ifdef MINIDFS_ZSTD
+    case minidfs::CODEC_ZSTD: {
+        size_t n = ZSTD_decompressDCtx(ThreadDCtx(), out->data(), out->size(), data.data(), data.size());
+        return !ZSTD_isError(n) && n == out->size();
+    }
+#endif
+#ifdef MINIDFS_LZ4
+    case minidfs::CODEC_LZ4: {
+        int n = LZ4_decompress_safe(data.data(), out->data(), static_cast<int>(data.size()), static_cast<int>(out->size()));
+        return n >= 0 && static_cast<size_t>(n) == out->size();
+    }
+#endif
+#ifdef MINIDFS_ZLIB
+    case minidfs::CODEC_DEFLATE: {
+        uLongf n = static_cast<uLongf>(out->size());
+        int rc = uncompress(reinterpret_cast<Bytef*>(out->data()), &n, reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()));
+        return rc == Z_OK && n == out->size();
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+double CodecStats::Ratio() const {
+    if (wire_bytes == 0) return 1.0;
+    return static_cast<double>(raw_bytes) / static_cast<double>(wire_bytes);
+}
+
+CodecStats CodecCounters::Stats() const {
+    CodecStats stats;
+    stats.compressed_chunks = compressed_chunks_.load();
+    stats.skipped_chunks = skipped_chunks_.load();
+    stats.raw_bytes = raw_bytes_.load();
+    stats.wire_bytes = wire_bytes_.load();
+    stats.compress_ns = compress_ns_.load();
+    stats.decompressed_chunks = decompressed_chunks_.load();
+    stats.decompress_ns = decompress_ns_.load();
+    return stats;
+}
+
+bool CodecSupported(minidfs::Codec codec) {
+    switch (codec) {
+#ifdef MINIDFS_ZSTD
+    case minidfs::CODEC_ZSTD:
+#endif
+#ifdef MINIDFS_LZ4
+    case minidfs::CODEC_LZ4:
+#endif
+#ifdef MINIDFS_ZLIB
+    case minidfs::CODEC_DEFLATE:
+#endif
+    case minidfs::CODEC_NONE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::vector<minidfs::Codec> SupportedCodecs() {
+    std::vector<minidfs::Codec> codecs;
+    for (minidfs::Codec codec : { minidfs::CODEC_ZSTD, minidfs::CODEC_LZ4, minidfs::CODEC_DEFLATE }) {
+        if (CodecSupported(codec)) codecs.push_back(codec);
+    }
+    return codecs;
+}
+
+ChunkCompressor::ChunkCompressor(CodecCounters* counters, minidfs::Codec codec, int level)
+    : counters_(counters), codec_(CodecSupported(codec) ? codec : minidfs::CODEC_NONE), level_(ClampLevel(codec_, level)) {
+}
+
+void ChunkCompressor::Compress(minidfs::FileBuffer* chunk, std::string* scratch) {
+    chunk->clear_codec();
+    chunk->clear_raw_size();
+    size_t raw = chunk->data().size();
+    if (codec_ == minidfs::CODEC_NONE || raw == 0) return;
+
+    counters_->raw_bytes_ += raw;
+    uint64_t index = chunks_++;
+    // incompressible data (media, archives) stops costing CPU after a few chunks
+    if (streak_.load() >= CODEC_SKIP_STREAK && index % CODEC_PROBE_INTERVAL != 0) {
+        counters_->skipped_chunks_++;
+        counters_->wire_bytes_ += raw;
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t packed = CompressInto(codec_, level_, chunk->data().data(), raw, scratch);
+    counters_->compress_ns_ += ElapsedNs(start);
+
+    if (packed == 0 || packed > raw - raw / CODEC_MIN_SAVING) {
+        streak_++;
+        counters_->skipped_chunks_++;
+        counters_->wire_bytes_ += raw;
+        return;
+    }
+    streak_ = 0;
+    scratch->resize(packed);
+    chunk->mutable_data()->swap(*scratch);
+    chunk->set_codec(codec_);
+    chunk->set_raw_size(static_cast<uint32_t>(raw));
+    counters_->compressed_chunks_++;
+    counters_->wire_bytes_ += packed;
+}
+
+grpc::Status UnpackChunk(minidfs::FileBuffer* chunk, size_t max_raw_size, std::string* scratch, CodecCounters* counters) {
+    if (chunk->codec() != minidfs::CODEC_NONE) {
+        if (!CodecSupported(chunk->codec())) {
+            return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "Unsupported codec");
+        }
+        if (chunk->raw_size() > max_raw_size) {
+            return grpc::Status(grpc::StatusCode::DATA_LOSS, "Chunk decompresses past the chunk size limit");
+        }
+        auto start = std::chrono::steady_clock::now();
+        scratch->resize(chunk->raw_size());
+        bool ok = DecompressInto(chunk->codec(), chunk->data(), scratch);
+        counters->decompress_ns_ += ElapsedNs(start);
+        if (!ok) {
+            return grpc::Status(grpc::StatusCode::DATA_LOSS, "Chunk failed to decompress");
+        }
+        chunk->mutable_data()->swap(*scratch);
+        chunk->clear_codec();
+        chunk->clear_raw_size();
+        counters->decompressed_chunks_++;
+    }
+    // chunks from peers that predate checksums carry none and pass unchecked
+    if (chunk->has_crc32c() && Crc32c(chunk->data().data(), chunk->data().size()) != chunk->crc32c()) {
+        return grpc::Status(grpc::StatusCode::DATA_LOSS, "Chunk checksum mismatch");
+    }
+    return grpc::Status::OK;
+}
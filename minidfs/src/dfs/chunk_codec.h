@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <grpcpp/support/status.h>
+#include "proto_src/minidfs.pb.h"
+
+// Which codecs are built in depends on the libraries CMake found: MINIDFS_ZSTD (zstd),
+// MINIDFS_LZ4 (lz4) and MINIDFS_ZLIB (zlib, for CODEC_DEFLATE).
+
+// A compressed chunk is only sent if it saves at least 1/CODEC_MIN_SAVING of the raw bytes.
+#define CODEC_MIN_SAVING 8
+// After CODEC_SKIP_STREAK chunks in a row fail to shrink, a stream only tries every
+// CODEC_PROBE_INTERVAL-th chunk until one does again.
+#define CODEC_SKIP_STREAK 4
+#define CODEC_PROBE_INTERVAL 16
+
+struct CodecStats {
+    uint64_t compressed_chunks = 0;
+    uint64_t skipped_chunks = 0;        // sent raw: did not shrink, or not tried during a skip streak
+    uint64_t raw_bytes = 0;             // offered for compression
+    uint64_t wire_bytes = 0;            // what went out for them, compressed or not
+    uint64_t compress_ns = 0;           // time inside the compressor; codec calls are pure CPU work
+    uint64_t decompressed_chunks = 0;
+    uint64_t decompress_ns = 0;
+
+    // raw_bytes / wire_bytes, 1.0 before anything was sent
+    double Ratio() const;
+};
+
+class CodecCounters {
+public:
+    CodecStats Stats() const;
+
+private:
+    friend class ChunkCompressor;
+    friend grpc::Status UnpackChunk(minidfs::FileBuffer*, size_t, std::string*, CodecCounters*);
+
+    std::atomic<uint64_t> compressed_chunks_{0};
+    std::atomic<uint64_t> skipped_chunks_{0};
+    std::atomic<uint64_t> raw_bytes_{0};
+    std::atomic<uint64_t> wire_bytes_{0};
+    std::atomic<uint64_t> compress_ns_{0};
+    std::atomic<uint64_t> decompressed_chunks_{0};
+    std::atomic<uint64_t> decompress_ns_{0};
+};
+
+bool CodecSupported(minidfs::Codec codec);
+
+// Every codec this build can compress and decompress, CODEC_NONE excluded.
+std::vector<minidfs::Codec> SupportedCodecs();
+
+// The sending side of one compressed stream. Compress may run for different chunks of the
+// stream on several threads at once, as long as each call brings its own scratch.
+class ChunkCompressor {
+public:
+    // level 0 takes the codec's default; out-of-range levels are clamped.
+    ChunkCompressor(CodecCounters* counters, minidfs::Codec codec, int level);
+
+    // Replaces chunk's data with its compressed form and sets codec and raw_size when that
+    // saves enough; otherwise marks the chunk CODEC_NONE and leaves the data alone. The old
+    // payload buffer is swapped into scratch, so pooled capacity keeps circulating.
+    void Compress(minidfs::FileBuffer* chunk, std::string* scratch);
+
+private:
+    CodecCounters* counters_;
+    minidfs::Codec codec_;
+    int level_;
+    std::atomic<uint32_t> streak_{0};
+    std::atomic<uint64_t> chunks_{0};
+};
+
+// The receiving side: decompresses chunk's data in place (through scratch) and verifies its
+// CRC-32C. UNIMPLEMENTED for a codec this build lacks, DATA_LOSS for a chunk that fails to
+// decompress, claims more than max_raw_size bytes, or does not match its checksum.
+grpc::Status UnpackChunk(minidfs::FileBuffer* chunk, size_t max_raw_size, std::string* scratch, CodecCounters* counters);
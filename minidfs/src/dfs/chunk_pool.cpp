@@ -0,0 +1,54 @@
+#include "dfs/chunk_pool.h"
+#include <algorithm>
+#include "dfs/file_manager.h"
+
+double ChunkPoolStats::AllocationsPerGB() const {
+    if (bytes == 0) return 0.0;
+    return static_cast<double>(allocations) / (static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0));
+}
+
+void ChunkPool::Releaser::operator()(minidfs::FileBuffer* chunk) const {
+    pool->Release(chunk);
+}
+
+ChunkPool::Chunk ChunkPool::Acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!idle_.empty()) {
+            minidfs::FileBuffer* chunk = idle_.back().release();
+            idle_.pop_back();
+            reuses_++;
+            return Chunk(chunk, Releaser{ this });
+        }
+    }
+    allocations_++;
+    return Chunk(new minidfs::FileBuffer(), Releaser{ this });
+}
+
+char* ChunkPool::Reserve(minidfs::FileBuffer* chunk, size_t size) {
+    std::string* data = chunk->mutable_data();
+    if (data->capacity() < size) {
+        allocations_++;
+        data->reserve(std::max<size_t>(size, CHUNK_SIZE));
+    }
+    data->resize(size);
+    return data->data();
+}
+
+ChunkPoolStats ChunkPool::Stats() const {
+    ChunkPoolStats stats;
+    stats.allocations = allocations_.load();
+    stats.reuses = reuses_.load();
+    stats.bytes = bytes_.load();
+    return stats;
+}
+
+void ChunkPool::Release(minidfs::FileBuffer* chunk) {
+    // Clear() keeps the payload string's capacity for the next user
+    chunk->Clear();
+    std::unique_ptr<minidfs::FileBuffer> owned(chunk);
+    std::lock_guard<std::mutex> lock(mu_);
+    if (idle_.size() < CHUNK_POOL_MAX_IDLE) {
+        idle_.push_back(std::move(owned));
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "proto_src/minidfs.pb.h"
+
+// Idle FileBuffers kept for reuse; chunks beyond this in use at once are freed on release.
+#define CHUNK_POOL_MAX_IDLE 256
+
+struct ChunkPoolStats {
+    uint64_t allocations = 0;   // FileBuffers created, or payloads grown, because nothing idle fit
+    uint64_t reuses = 0;        // acquires served by an idle FileBuffer
+    uint64_t bytes = 0;         // payload bytes moved through pooled chunks
+
+    double AllocationsPerGB() const;
+};
+
+// Recycles FileBuffer messages, payload capacity included, across chunks and streams. A chunk
+// is filled in place through Reserve and handed to gRPC as it is, so a steady transfer makes no
+// heap allocation for its chunks. It still copies: gRPC serializes the payload into its own
+// send buffer (the mmap fetch path is what avoids that). The server reports Stats in
+// GetServerInfo.
+class ChunkPool {
+public:
+    struct Releaser {
+        ChunkPool* pool = nullptr;
+        void operator()(minidfs::FileBuffer* chunk) const;
+    };
+    using Chunk = std::unique_ptr<minidfs::FileBuffer, Releaser>;
+
+    ChunkPool() = default;
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    // The pool must outlive every chunk it hands out.
+    Chunk Acquire();
+
+    // Sizes chunk's payload to size bytes and returns it for filling in place; shrink it
+    // afterwards with mutable_data()->resize(). Allocation-free once the chunk has held size bytes.
+    char* Reserve(minidfs::FileBuffer* chunk, size_t size);
+
+    void CountBytes(uint64_t bytes) { bytes_ += bytes; }
+
+    ChunkPoolStats Stats() const;
+
+private:
+    void Release(minidfs::FileBuffer* chunk);
+
+    std::mutex mu_;
+    std::vector<std::unique_ptr<minidfs::FileBuffer>> idle_;
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> reuses_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
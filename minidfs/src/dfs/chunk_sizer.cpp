@@ -0,0 +1,46 @@
+#include "dfs/chunk_sizer.h"
+#include <algorithm>
+#include "dfs/file_manager.h"
+
+size_t MaxChunkSize(size_t max_message_size) {
+    if (max_message_size <= CHUNK_HEADER_RESERVE + MIN_CHUNK_SIZE) return MIN_CHUNK_SIZE;
+    return max_message_size - CHUNK_HEADER_RESERVE;
+}
+
+size_t NegotiateChunkSize(size_t requested, size_t max_chunk_size) {
+    if (requested == 0) requested = CHUNK_SIZE;
+    return std::clamp<size_t>(requested, MIN_CHUNK_SIZE, std::max<size_t>(max_chunk_size, MIN_CHUNK_SIZE));
+}
+
+ChunkSizer::ChunkSizer(size_t initial, size_t max_chunk_size, bool adaptive)
+    : size_(NegotiateChunkSize(initial, max_chunk_size)),
+      max_size_(std::max<size_t>(max_chunk_size, MIN_CHUNK_SIZE)),
+      adaptive_(adaptive) {
+}
+
+void ChunkSizer::Record(size_t bytes, std::chrono::steady_clock::duration elapsed) {
+    if (!adaptive_) return;
+    samples_++;
+    window_bytes_ += bytes;
+    window_time_ += elapsed;
+    if (samples_ < CHUNK_SAMPLE_WINDOW) return;
+
+    using namespace std::chrono;
+    double seconds = std::max(duration<double>(window_time_).count(), 1e-6);
+    double rate = static_cast<double>(window_bytes_) / seconds;
+    auto latency = window_time_ / samples_;
+    auto target = milliseconds(CHUNK_TARGET_LATENCY_MS);
+
+    if (latency > target) {
+        // a slow link: smaller chunks keep each one's latency, and what a broken stream loses, bounded
+        size_ = std::max<size_t>(size_ / 2, MIN_CHUNK_SIZE);
+    } else if (latency * 2 <= target && (last_rate_ == 0.0 || rate > last_rate_ * 1.1)) {
+        // room to grow, and the last step up paid for itself
+        size_ = std::min(size_ * 2, max_size_);
+    }
+
+    last_rate_ = rate;
+    samples_ = 0;
+    window_bytes_ = 0;
+    window_time_ = {};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// gRPC's default receive limit. Server and client both configure it explicitly, and no chunk
+// payload may grow past it less CHUNK_HEADER_RESERVE.
+#define MAX_MESSAGE_SIZE (4 * 1024 * 1024)
+// Room kept in each message for everything but the payload: ids, path, offsets and framing.
+#define CHUNK_HEADER_RESERVE (16 * 1024)
+#define MIN_CHUNK_SIZE (16 * 1024)
+
+// Adaptive sizing: chunks grow while they take well under CHUNK_TARGET_LATENCY_MS each and
+// growing still raises throughput, and shrink once they take longer. Decisions are made over
+// windows of CHUNK_SAMPLE_WINDOW chunks.
+#define CHUNK_TARGET_LATENCY_MS 50
+#define CHUNK_SAMPLE_WINDOW 8
+
+// Largest payload that fits in a message of max_message_size bytes.
+size_t MaxChunkSize(size_t max_message_size);
+
+// The chunk size a stream runs at: requested (0 = CHUNK_SIZE) clamped to what both ends accept.
+size_t NegotiateChunkSize(size_t requested, size_t max_chunk_size);
+
+// Picks the payload size of each chunk a stream sends. A fixed sizer keeps its initial size; an
+// adaptive one is fed the time every chunk took to go out, and doubles or halves its size
+// between MIN_CHUNK_SIZE and max_chunk_size. Not thread-safe; one per stream.
+class ChunkSizer {
+public:
+    ChunkSizer(size_t initial, size_t max_chunk_size, bool adaptive);
+
+    size_t Size() const { return size_; }
+
+    // elapsed is from handing the chunk to the stream until the stream took it, so it covers
+    // serialization, flow control stalls and, once the window is full, the round trip.
+    void Record(size_t bytes, std::chrono::steady_clock::duration elapsed);
+
+private:
+    size_t size_;
+    size_t max_size_;
+    bool adaptive_;
+    size_t samples_ = 0;
+    uint64_t window_bytes_ = 0;
+    std::chrono::steady_clock::duration window_time_{};
+    // bytes per second over the previous window, 0 before the first
+    double last_rate_ = 0.0;
+};
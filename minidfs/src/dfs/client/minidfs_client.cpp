@@ -1,6 +1,13 @@
 #include "minidfs_client.h"
+#include "dfs/storage/cdc_chunker.h"
+#include "dfs/storage/chunk_store.h"
+#include "dfs/storage/crc32c.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <latch>
+#include <vector>
 
 MiniDFSClient::MiniDFSClient(std::shared_ptr<grpc::Channel> channel, const std::string& mount_path, const std::string& client_id)
     : stub_(minidfs::MiniDFSService::NewStub(channel)), mount_path_(mount_path), client_id_(client_id) {
@@ -13,15 +20,102 @@ std::string MiniDFSClient::GetClientMountPath() const {
     return mount_path_;
 }
 
+void MiniDFSClient::SetInlineLocking(bool enabled) {
+    inline_locking_ = enabled;
+}
+
+ChunkPoolStats MiniDFSClient::GetChunkPoolStats() const {
+    return chunk_pool_.Stats();
+}
+
+void MiniDFSClient::SetHeaderOnceStreams(bool enabled) {
+    header_once_ = enabled;
+}
+
+void MiniDFSClient::SetChunkSize(size_t chunk_size, bool adaptive) {
+    chunk_size_ = chunk_size;
+    adaptive_chunks_ = adaptive;
+}
+
+void MiniDFSClient::SetMaxMessageSize(size_t bytes) {
+    max_message_size_ = bytes;
+}
+
+void MiniDFSClient::SetChunkOptions(minidfs::FetchFileReq* request) const {
+    request->set_chunk_size(static_cast<uint32_t>(chunk_size_));
+    request->set_max_chunk_size(static_cast<uint32_t>(MaxChunkSize(max_message_size_)));
+    request->set_adaptive_chunks(adaptive_chunks_);
+    // servers without the codec ignore it and send raw chunks
+    request->set_codec(codec_);
+    request->set_codec_level(codec_level_);
+}
+
+void MiniDFSClient::SetCompression(minidfs::Codec codec, int level) {
+    codec_ = CodecSupported(codec) ? codec : minidfs::CODEC_NONE;
+    codec_level_ = level;
+}
+
+CodecStats MiniDFSClient::GetCodecStats() const {
+    return codec_counters_.Stats();
+}
+
+DeltaStats MiniDFSClient::GetDeltaStats() const {
+    std::lock_guard<std::mutex> lock(delta_mu_);
+    return delta_stats_;
+}
+
+void MiniDFSClient::SetServerInfoTtl(std::chrono::milliseconds ttl) {
+    std::lock_guard<std::mutex> lock(server_info_mu_);
+    server_info_ttl_ = ttl;
+}
+
+size_t MiniDFSClient::UploadMaxChunkSize() {
+    size_t limit = MaxChunkSize(max_message_size_);
+    minidfs::ServerInfo info;
+    // servers too old to say are held to the default chunk size
+    if (!LoadServerInfo(&info) || info.max_chunk_size() == 0) return std::min<size_t>(limit, CHUNK_SIZE);
+    return std::min<size_t>(limit, info.max_chunk_size());
+}
+
+minidfs::Codec MiniDFSClient::UploadCodec() {
+    if (codec_ == minidfs::CODEC_NONE) return codec_;
+
+    minidfs::ServerInfo info;
+    if (!LoadServerInfo(&info)) return minidfs::CODEC_NONE;
+    for (int codec : info.codecs()) {
+        if (codec == codec_) return codec_;
+    }
+    return minidfs::CODEC_NONE;
+}
+
+bool MiniDFSClient::LoadServerInfo(minidfs::ServerInfo* info) {
+    std::lock_guard<std::mutex> lock(server_info_mu_);
+    auto now = std::chrono::steady_clock::now();
+    if (!server_info_ || now - server_info_time_ >= server_info_ttl_) {
+        minidfs::ServerInfoReq request;
+        minidfs::ServerInfo response;
+        grpc::ClientContext context;
+        grpc::Status status = stub_->GetServerInfo(&context, request, &response);
+        // an older server answers UNIMPLEMENTED and is taken to support nothing optional;
+        // other failures are retried next time
+        if (!status.ok() && status.error_code() != grpc::StatusCode::UNIMPLEMENTED) return false;
+        server_info_ = response;
+        server_info_time_ = now;
+    }
+    *info = *server_info_;
+    return true;
+}
+
 /* =========================
    Distributed file lock
    ========================= */
 
-grpc::StatusCode MiniDFSClient::GetReadLock(const std::string& file_path) {
+grpc::StatusCode MiniDFSClient::GetReadLock(const std::string& file_path, uint64_t lock_token) {
     minidfs::FileLockReq request;
     request.set_client_id(client_id_);
     request.set_file_path(file_path);
     request.set_op(minidfs::FileOpType::READ);
+    request.set_lock_token(lock_token);
 
     minidfs::FileLockRes response;
     grpc::ClientContext context;
@@ -78,9 +172,11 @@ grpc::StatusCode MiniDFSClient::RemoveFile(const std::string& file_path) {
    ========================= */
 
 grpc::StatusCode MiniDFSClient::StoreFile(const std::string& file_path) {
-    grpc::StatusCode lock_status = GetWriteLock(file_path, true);
-    if (lock_status != grpc::StatusCode::OK) {
-        return lock_status;
+    if (!inline_locking_) {
+        grpc::StatusCode lock_status = GetWriteLock(file_path, true);
+        if (lock_status != grpc::StatusCode::OK) {
+            return lock_status;
+        }
     }
 
     std::shared_ptr<ClientFileSession> session = AcquireClientFileSession(file_path);
@@ -88,6 +184,7 @@ grpc::StatusCode MiniDFSClient::StoreFile(const std::string& file_path) {
 
     std::ifstream infile(file_path, std::ios::binary);
     if (!infile) {
+        ReleaseClientFileSession(file_path);
         return grpc::StatusCode::NOT_FOUND;
     }
 
@@ -95,18 +192,51 @@ grpc::StatusCode MiniDFSClient::StoreFile(const std::string& file_path) {
     minidfs::StoreFileRes response;
     auto writer = stub_->StoreFile(&context, &response);
 
-    char buffer[CHUNK_SIZE];
+    // one chunk, read into in place, carries the whole file
+    ChunkPool::Chunk chunk = chunk_pool_.Acquire();
+    ChunkSizer sizer(chunk_size_, UploadMaxChunkSize(), adaptive_chunks_);
+    ChunkCompressor compressor(&codec_counters_, UploadCodec(), codec_level_);
+    std::string scratch;
     uint64_t offset = 0;
+    bool first = true;
+    bool open = true;
+
+    // header-once streams name the file in a message of their own and then send bare data
+    if (header_once_) {
+        minidfs::StreamHeader* header = chunk->mutable_header();
+        header->set_version(FILE_STREAM_VERSION);
+        header->set_client_id(client_id_);
+        header->set_file_path(file_path);
+        header->set_acquire_lock(inline_locking_);
+        open = writer->Write(*chunk);
+        chunk->clear_header();
+        first = false;
+    }
 
-    while (infile.read(buffer, sizeof(buffer)) || infile.gcount() > 0) {
-        minidfs::FileBuffer chunk;
-        chunk.set_client_id(client_id_);
-        chunk.set_file_path(file_path);
-        chunk.set_offset(offset);
-        chunk.set_data(buffer, infile.gcount());
-
-        if (!writer->Write(chunk)) break;
-        offset += infile.gcount();
+    while (open) {
+        size_t want = sizer.Size();
+        infile.read(chunk_pool_.Reserve(chunk.get(), want), want);
+        size_t got = static_cast<size_t>(infile.gcount());
+        // the first message always goes out, even for an empty file, so an inline lock request reaches the server
+        if (got == 0 && !first) break;
+        chunk->mutable_data()->resize(got);
+        chunk->set_crc32c(Crc32c(chunk->data().data(), got));
+        compressor.Compress(chunk.get(), &scratch);
+
+        if (!header_once_) {
+            chunk->set_client_id(client_id_);
+            chunk->set_file_path(file_path);
+            chunk->set_offset(offset);
+            chunk->set_acquire_lock(first && inline_locking_);
+        }
+        first = false;
+
+        auto write_started = std::chrono::steady_clock::now();
+        if (!writer->Write(*chunk)) break;
+        sizer.Record(got, std::chrono::steady_clock::now() - write_started);
+        chunk_pool_.CountBytes(got);
+        offset += got;
+        if (got == 0) break;
     }
 
     writer->WritesDone();
@@ -117,44 +247,696 @@ grpc::StatusCode MiniDFSClient::StoreFile(const std::string& file_path) {
     return status.error_code();
 }
 
+DeltaPacker::DeltaPacker(grpc::ClientWriter<minidfs::DeltaChunk>* writer, const minidfs::DeltaHeader& header, size_t max_literal)
+    : writer_(writer), max_literal_(std::max<size_t>(max_literal, 1)) {
+    *chunk_.mutable_header() = header;
+}
+
+bool DeltaPacker::Literal(const char* data, size_t size) {
+    while (size > 0 && open_) {
+        size_t room = static_cast<size_t>(std::min<uint64_t>(max_literal_ - literal_, DELTA_MAX_MESSAGE_OUTPUT - output_));
+        if (room == 0) {
+            Send();
+            continue;
+        }
+        size_t take = std::min(size, room);
+        chunk_.add_ops()->set_literal(data, take);
+        literal_ += take;
+        output_ += take;
+        literal_bytes_ += take;
+        data += take;
+        size -= take;
+    }
+    return open_;
+}
+
+bool DeltaPacker::Copy(uint64_t block, uint32_t blocks, uint64_t block_size) {
+    while (blocks > 0 && open_) {
+        uint64_t room = (DELTA_MAX_MESSAGE_OUTPUT - output_) / block_size;
+        if (room == 0) {
+            Send();
+            continue;
+        }
+        uint32_t take = static_cast<uint32_t>(std::min<uint64_t>(blocks, room));
+        minidfs::DeltaOp* op = chunk_.add_ops();
+        op->set_block(block);
+        op->set_blocks(take);
+        output_ += take * block_size;
+        block += take;
+        blocks -= take;
+    }
+    return open_;
+}
+
+bool DeltaPacker::Chunk(const std::string& hash, uint32_t size) {
+    if (output_ + size > DELTA_MAX_MESSAGE_OUTPUT) Send();
+    minidfs::DeltaOp* op = chunk_.add_ops();
+    op->set_chunk(hash);
+    op->set_chunk_size(size);
+    output_ += size;
+    return open_;
+}
+
+bool DeltaPacker::Finish(const std::string& file_hash) {
+    chunk_.set_file_hash(file_hash);
+    return Send();
+}
+
+bool DeltaPacker::Send() {
+    if (open_) {
+        wire_bytes_ += chunk_.ByteSizeLong();
+        open_ = writer_->Write(chunk_);
+    }
+    chunk_.Clear();
+    literal_ = 0;
+    output_ = 0;
+    return open_;
+}
+
+grpc::StatusCode MiniDFSClient::StoreFileDelta(const std::string& file_path) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(file_path, ec);
+    if (ec) return grpc::StatusCode::NOT_FOUND;
+
+    if (size >= DELTA_MIN_FILE_SIZE) {
+        minidfs::FileSignatureReq request;
+        request.set_client_id(client_id_);
+        request.set_file_path(file_path);
+        minidfs::FileSignature signature;
+        grpc::ClientContext context;
+        // NOT_FOUND (a new file), UNIMPLEMENTED (an older server) and the rest go up whole
+        grpc::Status status = stub_->GetFileSignature(&context, request, &signature);
+        if (status.ok()) {
+            minidfs::DeltaHeader header;
+            header.set_client_id(client_id_);
+            header.set_file_path(file_path);
+            header.set_block_size(signature.block_size());
+            header.set_base_size(signature.file_size());
+            status = UploadDelta(file_path, size, header, signature.ByteSizeLong(),
+                [&](std::ifstream& in, DeltaPacker& packer, std::string* file_hash) {
+                    IncrementalHash hash;
+                    size_t max_literal = packer.MaxLiteral();
+                    bool encoded = ComputeDelta(in, signature, max_literal, &hash, [&](minidfs::DeltaOp& op) {
+                        if (op.blocks() == 0) return packer.Literal(op.literal().data(), op.literal().size());
+                        return packer.Copy(op.block(), op.blocks(), signature.block_size());
+                    });
+                    *file_hash = hash.Final();
+                    return encoded;
+                });
+            // FAILED_PRECONDITION: the server's copy is not the one it signed any more
+            if (status.error_code() != grpc::StatusCode::FAILED_PRECONDITION) {
+                return status.error_code();
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(delta_mu_);
+        delta_stats_.full_uploads++;
+    }
+    return StoreFile(file_path);
+}
+
+grpc::StatusCode MiniDFSClient::StoreFileDedup(const std::string& file_path) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(file_path, ec);
+    if (ec) return grpc::StatusCode::NOT_FOUND;
+
+    minidfs::ServerInfo info;
+    if (size >= DELTA_MIN_FILE_SIZE && LoadServerInfo(&info) && info.chunk_store()) {
+        grpc::Status status = UploadDedup(file_path, size);
+        // FAILED_PRECONDITION: nothing to reuse, or the chunk store dropped a chunk meanwhile
+        if (status.error_code() != grpc::StatusCode::FAILED_PRECONDITION) {
+            return status.error_code();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(delta_mu_);
+        delta_stats_.full_uploads++;
+    }
+    return StoreFile(file_path);
+}
+
+grpc::Status MiniDFSClient::UploadDedup(const std::string& file_path, uint64_t size) {
+    struct LocalChunk {
+        uint64_t offset;
+        uint32_t size;
+        std::string hash;
+        bool stored;
+    };
+    std::vector<LocalChunk> chunks;
+    IncrementalHash hash;
+    {
+        std::ifstream infile(file_path, std::ios::binary);
+        if (!infile) return grpc::Status(grpc::StatusCode::NOT_FOUND, "File not found");
+        uint64_t offset = 0;
+        bool split = SplitChunks(infile, [&](const char* data, size_t chunk_size) {
+            hash.Update(data, chunk_size);
+            chunks.push_back({offset, static_cast<uint32_t>(chunk_size), ChunkHash(data, chunk_size), true});
+            offset += chunk_size;
+            return true;
+        });
+        if (!split) return grpc::Status(grpc::StatusCode::INTERNAL, "Failed to read file");
+    }
+    // hashed before the upload reads the file again; if it changes in between, the server
+    // refuses the result and the file goes up whole
+    std::string file_hash = hash.Final();
+
+    uint64_t negotiated_bytes = 0;
+    size_t stored = chunks.size();
+    for (size_t first = 0; first < chunks.size(); first += FIND_CHUNKS_PAGE) {
+        size_t last = std::min(chunks.size(), first + FIND_CHUNKS_PAGE);
+        minidfs::FindChunksReq request;
+        for (size_t i = first; i < last; i++) {
+            request.add_hashes(chunks[i].hash);
+        }
+        minidfs::FindChunksRes response;
+        grpc::ClientContext context;
+        grpc::Status status = stub_->FindChunks(&context, request, &response);
+        if (!status.ok()) return status;
+        negotiated_bytes += request.ByteSizeLong() + response.ByteSizeLong();
+        for (uint32_t missing : response.missing()) {
+            if (missing < last - first && chunks[first + missing].stored) {
+                chunks[first + missing].stored = false;
+                stored--;
+            }
+        }
+    }
+    if (stored == 0) {
+        return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Server has none of the chunks");
+    }
+
+    minidfs::DeltaHeader header;
+    header.set_client_id(client_id_);
+    header.set_file_path(file_path);
+    return UploadDelta(file_path, size, header, negotiated_bytes,
+        [&](std::ifstream& in, DeltaPacker& packer, std::string* out_hash) {
+            std::string buffer;
+            for (const LocalChunk& chunk : chunks) {
+                if (chunk.stored) {
+                    if (!packer.Chunk(chunk.hash, chunk.size)) return false;
+                    continue;
+                }
+                buffer.resize(chunk.size);
+                in.seekg(static_cast<std::streamoff>(chunk.offset));
+                if (!in.read(buffer.data(), chunk.size) || !packer.Literal(buffer.data(), chunk.size)) return false;
+            }
+            *out_hash = file_hash;
+            return true;
+        });
+}
+
+grpc::Status MiniDFSClient::UploadDelta(const std::string& file_path, uint64_t size, const minidfs::DeltaHeader& header,
+    uint64_t negotiated_bytes, const std::function<bool(std::ifstream&, DeltaPacker&, std::string*)>& encode)
+{
+    std::shared_ptr<ClientFileSession> session = AcquireClientFileSession(file_path);
+    std::lock_guard<std::mutex> session_lock(session->mu);
+
+    std::ifstream infile(file_path, std::ios::binary);
+    if (!infile) {
+        ReleaseClientFileSession(file_path);
+        return grpc::Status(grpc::StatusCode::NOT_FOUND, "File not found");
+    }
+
+    grpc::ClientContext context;
+    minidfs::StoreFileRes response;
+    auto writer = stub_->StoreFileDelta(&context, &response);
+    DeltaPacker packer(writer.get(), header, std::min(chunk_size_, UploadMaxChunkSize()));
+
+    std::string file_hash;
+    if (encode(infile, packer, &file_hash)) {
+        packer.Finish(file_hash);
+    } else if (packer.Open()) {
+        // the local file could not be read; the server must not commit what it got so far
+        context.TryCancel();
+    }
+    writer->WritesDone();
+    infile.close();
+
+    grpc::Status status = writer->Finish();
+    ReleaseClientFileSession(file_path);
+    if (status.ok()) {
+        std::lock_guard<std::mutex> lock(delta_mu_);
+        delta_stats_.delta_uploads++;
+        delta_stats_.file_bytes += size;
+        delta_stats_.wire_bytes += negotiated_bytes + packer.WireBytes();
+        delta_stats_.reused_bytes += size - std::min<uint64_t>(size, packer.LiteralBytes());
+    }
+    return status;
+}
+
+// DATA_LOSS is a chunk damaged on the way; the server kept nothing of it.
+static bool IsRetryableUpload(grpc::StatusCode code) {
+    return code == grpc::StatusCode::UNAVAILABLE || code == grpc::StatusCode::DEADLINE_EXCEEDED
+        || code == grpc::StatusCode::ABORTED || code == grpc::StatusCode::CANCELLED
+        || code == grpc::StatusCode::RESOURCE_EXHAUSTED || code == grpc::StatusCode::DATA_LOSS;
+}
+
+grpc::StatusCode MiniDFSClient::StoreFileResumable(const std::string& file_path, int max_attempts) {
+    return StoreFileStriped(file_path, 1, max_attempts);
+}
+
+// The file's size and mtime ticks; false if it cannot be stat'ed.
+static bool StatSource(const std::string& file_path, uint64_t* size, int64_t* version) {
+    std::error_code ec;
+    *size = fs::file_size(file_path, ec);
+    if (ec) return false;
+    *version = static_cast<int64_t>(fs::last_write_time(file_path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+grpc::StatusCode MiniDFSClient::StoreFileStriped(const std::string& file_path, uint32_t stripes, int max_attempts) {
+    uint64_t size = 0;
+    int64_t version = 0;
+    if (!StatSource(file_path, &size, &version)) return grpc::StatusCode::NOT_FOUND;
+
+    std::shared_ptr<ClientFileSession> session = AcquireClientFileSession(file_path);
+    std::lock_guard<std::mutex> session_lock(session->mu);
+
+    minidfs::UploadStatus status;
+    grpc::Status rpc_status;
+    for (int attempt = 0; attempt < max_attempts; attempt++) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(UPLOAD_RETRY_BACKOFF_MS << (attempt - 1)));
+
+            // edited since the session started: resuming would append new bytes to old ones
+            uint64_t current_size = 0;
+            int64_t current_version = 0;
+            if (!StatSource(file_path, &current_size, &current_version)) break;
+            if (current_size != size || current_version != version) {
+                size = current_size;
+                version = current_version;
+                status.Clear();
+            }
+        }
+
+        if (status.upload_id().empty()) {
+            // hands back the session an earlier, interrupted call left behind for this file
+            minidfs::StartUploadReq request;
+            request.set_client_id(client_id_);
+            request.set_file_path(file_path);
+            request.set_size(size);
+            request.set_source_version(version);
+            request.set_stripes(stripes);
+
+            grpc::ClientContext context;
+            rpc_status = stub_->StartUpload(&context, request, &status);
+            if (!rpc_status.ok()) {
+                if (!IsRetryableUpload(rpc_status.error_code())) break;
+                continue;
+            }
+        }
+
+        rpc_status = UploadStripes(file_path, &status);
+        if (rpc_status.ok() && status.complete()) break;
+        if (!rpc_status.ok() && !IsRetryableUpload(rpc_status.error_code())) break;
+
+        // a stream broke somewhere: resume from what the server actually kept
+        minidfs::UploadStatusReq request;
+        request.set_upload_id(status.upload_id());
+        minidfs::UploadStatus current;
+        grpc::ClientContext context;
+        grpc::Status query = stub_->GetUploadStatus(&context, request, &current);
+        if (query.ok()) {
+            status = current;
+        } else if (query.error_code() == grpc::StatusCode::NOT_FOUND) {
+            status.Clear();
+        }
+    }
+
+    ReleaseClientFileSession(file_path);
+    if (!rpc_status.ok()) return rpc_status.error_code();
+    return status.complete() ? grpc::StatusCode::OK : grpc::StatusCode::ABORTED;
+}
+
+grpc::Status MiniDFSClient::UploadStripes(const std::string& file_path, minidfs::UploadStatus* status) {
+    int stripes = std::max(1, status->stripe_committed_size());
+    std::vector<uint64_t> begin(stripes);
+    std::vector<uint64_t> end(stripes);
+    std::vector<int> pending;
+    for (int i = 0; i < stripes; i++) {
+        begin[i] = status->stripe_committed_size() > 0 ? status->stripe_committed(i) : status->committed();
+        end[i] = i + 1 == stripes ? status->size() : std::min(status->size(), (i + 1) * status->stripe_size());
+        if (begin[i] < end[i]) pending.push_back(i);
+    }
+    // everything already arrived but was never committed: an empty stream finishes it
+    if (pending.empty()) pending.push_back(0);
+    // servers that predate chunk negotiation report 0 and take gRPC's default limit
+    size_t max_chunk = status->max_chunk_size() > 0 ? status->max_chunk_size() : MaxChunkSize(MAX_MESSAGE_SIZE);
+
+    std::vector<grpc::Status> results(stripes);
+    std::vector<minidfs::UploadStatus> responses(stripes);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < pending.size(); i++) {
+        int stripe = pending[i];
+        workers.emplace_back([&, stripe]() {
+            results[stripe] = UploadRange(file_path, status->upload_id(), stripe, begin[stripe], end[stripe], max_chunk, &responses[stripe]);
+        });
+    }
+    int first = pending[0];
+    results[first] = UploadRange(file_path, status->upload_id(), first, begin[first], end[first], max_chunk, &responses[first]);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // the stream that carried the last missing bytes is the one that committed the file
+    for (int stripe : pending) {
+        if (results[stripe].ok() && responses[stripe].complete()) {
+            *status = responses[stripe];
+            return grpc::Status::OK;
+        }
+    }
+    for (int stripe : pending) {
+        if (!results[stripe].ok()) return results[stripe];
+    }
+    return grpc::Status::OK;
+}
+
+grpc::Status MiniDFSClient::UploadRange(const std::string& file_path, const std::string& upload_id, uint32_t stripe,
+    uint64_t offset, uint64_t end, size_t max_chunk_size, minidfs::UploadStatus* response)
+{
+    std::ifstream infile(file_path, std::ios::binary);
+    if (!infile) return grpc::Status(grpc::StatusCode::NOT_FOUND, "Local file not found");
+    infile.seekg(static_cast<std::streamoff>(offset));
+
+    grpc::ClientContext context;
+    auto writer = stub_->UploadChunks(&context, response);
+
+    ChunkPool::Chunk chunk = chunk_pool_.Acquire();
+    ChunkSizer sizer(chunk_size_, max_chunk_size, adaptive_chunks_);
+    ChunkCompressor compressor(&codec_counters_, UploadCodec(), codec_level_);
+    std::string scratch;
+    bool first = true;
+
+    while (true) {
+        // never past the range the session assigned, even if the file grew since
+        size_t want = static_cast<size_t>(std::min<uint64_t>(sizer.Size(), end - std::min(offset, end)));
+        infile.read(chunk_pool_.Reserve(chunk.get(), want), want);
+        size_t got = static_cast<size_t>(infile.gcount());
+        // the first message carries the upload id, so it goes out even with nothing left to send
+        if (got == 0 && !first) break;
+        chunk->mutable_data()->resize(got);
+        chunk->set_crc32c(Crc32c(chunk->data().data(), got));
+        compressor.Compress(chunk.get(), &scratch);
+
+        if (first) {
+            chunk->set_upload_id(upload_id);
+            chunk->set_stripe(stripe);
+            chunk->set_client_id(client_id_);
+            chunk->set_file_path(file_path);
+            first = false;
+        } else {
+            chunk->clear_upload_id();
+            chunk->clear_stripe();
+            chunk->clear_client_id();
+            chunk->clear_file_path();
+        }
+        chunk->set_offset(offset);
+
+        auto write_started = std::chrono::steady_clock::now();
+        if (!writer->Write(*chunk)) break;
+        sizer.Record(got, std::chrono::steady_clock::now() - write_started);
+        chunk_pool_.CountBytes(got);
+        offset += got;
+        if (got == 0) break;
+    }
+
+    writer->WritesDone();
+    return writer->Finish();
+}
+
 /* =========================
    Fetch file (READ)
    ========================= */
 
 grpc::StatusCode MiniDFSClient::FetchFile(const std::string& file_path) {
-    grpc::StatusCode lock_status = GetReadLock(file_path);
-    if (lock_status != grpc::StatusCode::OK) {
-        return lock_status;
+    return FetchFileRange(file_path, 0, 0, true);
+}
+
+grpc::StatusCode MiniDFSClient::FetchFile(const std::string& file_path, uint64_t offset, uint64_t length) {
+    return FetchFileRange(file_path, offset, length, false);
+}
+
+grpc::StatusCode MiniDFSClient::FetchFileRange(const std::string& file_path, uint64_t offset, uint64_t length, bool whole_file) {
+    if (!inline_locking_) {
+        grpc::StatusCode lock_status = GetReadLock(file_path);
+        if (lock_status != grpc::StatusCode::OK) {
+            return lock_status;
+        }
     }
 
     std::shared_ptr<ClientFileSession> session = AcquireClientFileSession(file_path);
     std::lock_guard<std::mutex> session_lock(session->mu);
 
-    std::ofstream outfile(file_path, std::ios::binary | std::ios::trunc);
-    if (!outfile.is_open()) {
-        ReleaseClientFileSession(file_path);
-        return grpc::StatusCode::INTERNAL;
+    minidfs::FetchFileReq request;
+    request.set_file_path(file_path);
+    request.set_client_id(client_id_);
+    request.set_acquire_lock(inline_locking_);
+    SetChunkOptions(&request);
+    request.set_offset(offset);
+    request.set_length(length);
+
+    grpc::ClientContext context;
+    auto reader = stub_->FetchFile(&context, request);
+
+    // opened on the first chunk so a refused lock leaves the local copy untouched
+    std::fstream outfile;
+    auto open_outfile = [&]() {
+        if (whole_file) {
+            outfile.open(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            return outfile.is_open();
+        }
+        // a range lands inside whatever is already there
+        outfile.open(file_path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!outfile.is_open()) {
+            outfile.clear();
+            outfile.open(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+        return outfile.is_open();
+    };
+
+    bool local_error = false;
+    grpc::Status unpacked;
+    std::string scratch;
+    ChunkPool::Chunk chunk = chunk_pool_.Acquire();
+    while (reader->Read(chunk.get())) {
+        unpacked = UnpackChunk(chunk.get(), MaxChunkSize(max_message_size_), &scratch, &codec_counters_);
+        if (!unpacked.ok()) {
+            context.TryCancel();
+            break;
+        }
+        if (!outfile.is_open() && !open_outfile()) {
+            local_error = true;
+            context.TryCancel();
+            break;
+        }
+        outfile.seekp(static_cast<std::streamoff>(chunk->offset()));
+        outfile.write(chunk->data().data(), chunk->data().size());
+        chunk_pool_.CountBytes(chunk->data().size());
+    }
+
+    grpc::Status status = reader->Finish();
+    if (status.ok() && !local_error && !outfile.is_open() && whole_file) {
+        // empty file: nothing was streamed
+        local_error = !open_outfile();
+    }
+    if (outfile.is_open()) {
+        outfile.close();
+        local_error = local_error || outfile.fail();
+    }
+
+    ReleaseClientFileSession(file_path);
+    if (!unpacked.ok()) return unpacked.error_code();
+    if (local_error) return grpc::StatusCode::INTERNAL;
+    return status.error_code();
+}
+
+grpc::StatusCode MiniDFSClient::FetchFileParallel(const std::string& file_path, uint32_t streams) {
+    if (!inline_locking_) {
+        grpc::StatusCode lock_status = GetReadLock(file_path);
+        if (lock_status != grpc::StatusCode::OK) {
+            return lock_status;
+        }
     }
 
+    std::shared_ptr<ClientFileSession> session = AcquireClientFileSession(file_path);
+    std::lock_guard<std::mutex> session_lock(session->mu);
+
+    // the head goes out before the size is known; a single stream simply takes everything
+    const uint64_t head = streams == 1 ? 0 : FETCH_STREAM_MIN_SIZE;
+
     minidfs::FetchFileReq request;
     request.set_file_path(file_path);
     request.set_client_id(client_id_);
+    request.set_acquire_lock(inline_locking_);
+    SetChunkOptions(&request);
+    request.set_length(head);
 
     grpc::ClientContext context;
     auto reader = stub_->FetchFile(&context, request);
 
-    minidfs::FileBuffer chunk;
-    while (reader->Read(&chunk)) {
-        outfile.write(chunk.data().data(), chunk.data().size());
+    std::fstream outfile;
+    bool local_error = false;
+    bool first = true;
+    uint64_t size = 0;
+    uint64_t lock_token = 0;
+
+    std::vector<uint64_t> begin;
+    std::vector<std::unique_ptr<grpc::ClientContext>> contexts;
+    std::vector<grpc::Status> results;
+    std::vector<std::thread> workers;
+
+    grpc::Status unpacked;
+    std::string scratch;
+    ChunkPool::Chunk chunk = chunk_pool_.Acquire();
+    while (reader->Read(chunk.get())) {
+        unpacked = UnpackChunk(chunk.get(), MaxChunkSize(max_message_size_), &scratch, &codec_counters_);
+        if (!unpacked.ok()) {
+            context.TryCancel();
+            break;
+        }
+        if (first) {
+            first = false;
+            size = chunk->file_size();
+            lock_token = chunk->lock_token();
+
+            // preallocated up front so every range lands in place, whatever order they finish in
+            std::error_code ec;
+            outfile.open(file_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            if (outfile.is_open()) fs::resize_file(file_path, size, ec);
+            if (!outfile.is_open() || ec) {
+                local_error = true;
+                context.TryCancel();
+                break;
+            }
+
+            if (head > 0 && size > head) {
+                uint64_t wanted = streams > 0 ? streams : (size + FETCH_STREAM_MIN_SIZE - 1) / FETCH_STREAM_MIN_SIZE;
+                uint64_t tail_streams = std::clamp<uint64_t>(wanted, 2, FETCH_MAX_STREAMS) - 1;
+                tail_streams = std::min(tail_streams, size - head);
+                uint64_t range = (size - head) / tail_streams;
+                for (uint64_t i = 0; i < tail_streams; i++) {
+                    begin.push_back(head + i * range);
+                }
+                begin.push_back(size);
+                contexts.resize(tail_streams);
+                results.resize(tail_streams);
+
+                // the head stream is left unread until every tail stream holds its own read lock,
+                // so they nest under the head's hold (by its lock_token, even past a queued
+                // writer) and see the same version of the file
+                std::latch started(static_cast<std::ptrdiff_t>(tail_streams));
+                for (uint64_t i = 0; i < tail_streams; i++) {
+                    contexts[i] = std::make_unique<grpc::ClientContext>();
+                    workers.emplace_back([&, i]() {
+                        results[i] = FetchRangeInto(file_path, begin[i], begin[i + 1], size, lock_token, contexts[i].get(),
+                            [&]() { started.count_down(); });
+                    });
+                }
+                started.wait();
+            }
+        }
+        outfile.seekp(static_cast<std::streamoff>(chunk->offset()));
+        outfile.write(chunk->data().data(), chunk->data().size());
+        chunk_pool_.CountBytes(chunk->data().size());
     }
 
-    outfile.close();
-
     grpc::Status status = reader->Finish();
+    if (!unpacked.ok()) status = unpacked;
+    if (!status.ok() || local_error) {
+        for (auto& worker_context : contexts) {
+            worker_context->TryCancel();
+        }
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (const grpc::Status& result : results) {
+        if (status.ok() && !result.ok()) status = result;
+    }
+
+    if (status.ok() && !local_error && first) {
+        // empty file: nothing was streamed
+        outfile.open(file_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        local_error = !outfile.is_open();
+    }
+    if (outfile.is_open()) {
+        outfile.close();
+        local_error = local_error || outfile.fail();
+    }
+
     ReleaseClientFileSession(file_path);
+    if (local_error) return grpc::StatusCode::INTERNAL;
     return status.error_code();
 }
 
+grpc::Status MiniDFSClient::FetchRangeInto(const std::string& file_path, uint64_t offset, uint64_t end, uint64_t file_size,
+    uint64_t lock_token, grpc::ClientContext* context, const std::function<void()>& on_first)
+{
+    bool first = true;
+    auto signal_first = [&]() {
+        if (first) {
+            first = false;
+            on_first();
+        }
+    };
+
+    if (!inline_locking_) {
+        grpc::StatusCode lock_status = GetReadLock(file_path, lock_token);
+        if (lock_status != grpc::StatusCode::OK) {
+            signal_first();
+            return grpc::Status(lock_status, "Read lock refused");
+        }
+    }
+
+    std::fstream outfile(file_path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!outfile.is_open()) {
+        signal_first();
+        return grpc::Status(grpc::StatusCode::INTERNAL, "Local file not writable");
+    }
+
+    minidfs::FetchFileReq request;
+    request.set_file_path(file_path);
+    request.set_client_id(client_id_);
+    request.set_acquire_lock(inline_locking_);
+    request.set_lock_token(lock_token);
+    SetChunkOptions(&request);
+    request.set_offset(offset);
+    request.set_length(end - offset);
+
+    auto reader = stub_->FetchFile(context, request);
+
+    grpc::Status mismatch;
+    std::string scratch;
+    ChunkPool::Chunk chunk = chunk_pool_.Acquire();
+    while (reader->Read(chunk.get())) {
+        if (first && chunk->file_size() != file_size) {
+            // the file changed between the head stream and this one
+            mismatch = grpc::Status(grpc::StatusCode::ABORTED, "File changed during parallel fetch");
+            context->TryCancel();
+            break;
+        }
+        grpc::Status unpacked = UnpackChunk(chunk.get(), MaxChunkSize(max_message_size_), &scratch, &codec_counters_);
+        if (!unpacked.ok()) {
+            mismatch = unpacked;
+            context->TryCancel();
+            break;
+        }
+        signal_first();
+        outfile.seekp(static_cast<std::streamoff>(chunk->offset()));
+        outfile.write(chunk->data().data(), chunk->data().size());
+        chunk_pool_.CountBytes(chunk->data().size());
+    }
+    signal_first();
+
+    grpc::Status status = reader->Finish();
+    outfile.close();
+    if (!mismatch.ok()) return mismatch;
+    if (status.ok() && outfile.fail()) return grpc::Status(grpc::StatusCode::INTERNAL, "Local write failed");
+    return status;
+}
+
 /* =========================
    Metadata
    ========================= */
@@ -168,6 +950,46 @@ grpc::StatusCode MiniDFSClient::ListFiles(const std::string& path, minidfs::List
     return status.error_code();
 }
 
+grpc::StatusCode MiniDFSClient::ListFilesStream(const std::string& path, uint32_t page_size,
+    const std::function<void(const minidfs::ListFilesRes&)>& on_page)
+{
+    minidfs::ListFilesReq request;
+    request.set_path(path);
+    request.set_page_size(page_size);
+
+    grpc::ClientContext context;
+    auto reader = stub_->ListFilesStream(&context, request);
+
+    minidfs::ListFilesRes page;
+    while (reader->Read(&page)) {
+        on_page(page);
+    }
+
+    grpc::Status status = reader->Finish();
+    return status.error_code();
+}
+
+grpc::StatusCode MiniDFSClient::WalkTree(const std::string& path, uint32_t max_depth, const std::string& name_glob,
+    int64_t modified_since, const std::function<void(const minidfs::ListFilesRes&)>& on_page)
+{
+    minidfs::WalkTreeReq request;
+    request.set_path(path);
+    request.set_max_depth(max_depth);
+    request.set_name_glob(name_glob);
+    request.set_modified_since(modified_since);
+
+    grpc::ClientContext context;
+    auto reader = stub_->WalkTree(&context, request);
+
+    minidfs::ListFilesRes page;
+    while (reader->Read(&page)) {
+        on_page(page);
+    }
+
+    grpc::Status status = reader->Finish();
+    return status.error_code();
+}
+
 /* =========================
    Local file session mgmt
    ========================= */
@@ -4,20 +4,74 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <filesystem>
+#include <fstream>
+#include <optional>
 #include <unordered_map>
 #include <grpcpp/grpcpp.h>
 #include "minidfs.grpc.pb.h"
+#include "dfs/chunk_codec.h"
+#include "dfs/chunk_pool.h"
+#include "dfs/chunk_sizer.h"
+#include "dfs/file_delta.h"
 #include "dfs/file_manager.h"
 
 namespace fs = std::filesystem;
 
+// StoreFileResumable retry policy; the delay doubles after every failed attempt.
+#define UPLOAD_MAX_ATTEMPTS 5
+#define UPLOAD_RETRY_BACKOFF_MS 200
+
+// FetchFileParallel picks one stream per FETCH_STREAM_MIN_SIZE bytes, up to FETCH_MAX_STREAMS.
+#define FETCH_STREAM_MIN_SIZE (8 * 1024 * 1024)
+#define FETCH_MAX_STREAMS 8
+
+// Chunk hashes StoreFileDedup asks about per FindChunks call.
+#define FIND_CHUNKS_PAGE 4096
+
+// How long a GetServerInfo answer is trusted before it is asked for again, so an upgraded or
+// reconfigured server is noticed without a new client.
+#define SERVER_INFO_TTL_MS (60 * 1000)
+
 struct ClientFileSession {
     std::atomic<int> refs;
     std::mutex mu;
     std::atomic<int64_t> version;
 };
 
+// Packs delta ops into StoreFileDelta messages, sending each one before it would carry more
+// than max_literal literal bytes or rebuild more than DELTA_MAX_MESSAGE_OUTPUT. The first
+// message carries header. Every call returns false once the server has ended the stream.
+class DeltaPacker {
+public:
+    DeltaPacker(grpc::ClientWriter<minidfs::DeltaChunk>* writer, const minidfs::DeltaHeader& header, size_t max_literal);
+
+    bool Literal(const char* data, size_t size);
+    bool Copy(uint64_t block, uint32_t blocks, uint64_t block_size);
+    bool Chunk(const std::string& hash, uint32_t size);
+    // Sends the last message, with the hash of the whole file.
+    bool Finish(const std::string& file_hash);
+
+    bool Open() const { return open_; }
+    size_t MaxLiteral() const { return max_literal_; }
+    uint64_t WireBytes() const { return wire_bytes_; }
+    uint64_t LiteralBytes() const { return literal_bytes_; }
+
+private:
+    bool Send();
+
+    grpc::ClientWriter<minidfs::DeltaChunk>* writer_;
+    size_t max_literal_;
+    minidfs::DeltaChunk chunk_;
+    size_t literal_ = 0;        // in chunk_
+    uint64_t output_ = 0;       // bytes chunk_ rebuilds
+    uint64_t wire_bytes_ = 0;
+    uint64_t literal_bytes_ = 0;
+    bool open_ = true;
+};
+
 class MiniDFSClient {
 public:
 
@@ -26,22 +80,153 @@ public:
 
     grpc::StatusCode ListFiles(const std::string& path, minidfs::ListFilesRes* response);
 
-    grpc::StatusCode GetReadLock(const std::string& file_path);
+    // Streams the listing in pages of at most page_size entries (0 = server default);
+    // on_page runs for each page as soon as it arrives.
+    grpc::StatusCode ListFilesStream(const std::string& path, uint32_t page_size,
+        const std::function<void(const minidfs::ListFilesRes&)>& on_page);
+
+    // Lists the whole tree under path in one call. max_depth 0 is unlimited, an empty
+    // name_glob matches everything and modified_since 0 disables the mtime filter.
+    grpc::StatusCode WalkTree(const std::string& path, uint32_t max_depth, const std::string& name_glob,
+        int64_t modified_since, const std::function<void(const minidfs::ListFilesRes&)>& on_page);
+
+    // lock_token is one a FetchFile stream of the same fetch received; with it the lock is
+    // shared with that stream even while a writer is queued.
+    grpc::StatusCode GetReadLock(const std::string& file_path, uint64_t lock_token = 0);
     grpc::StatusCode GetWriteLock(const std::string& file_path, bool create);  
     
     grpc::StatusCode RemoveFile(const std::string& file_path);
     grpc::StatusCode StoreFile(const std::string& file_path);
+    // Uploads through a server-tracked session. When the stream breaks, the server is asked
+    // how much it already has and only the rest is sent again, up to max_attempts times.
+    // The server file is replaced only once every byte has arrived.
+    grpc::StatusCode StoreFileResumable(const std::string& file_path, int max_attempts = UPLOAD_MAX_ATTEMPTS);
+    // StoreFileResumable, with the file split into up to stripes byte ranges that are sent on
+    // parallel streams and committed together. Worth it for large files, where a single
+    // stream is held back by per-stream flow control and one thread's serialization.
+    grpc::StatusCode StoreFileStriped(const std::string& file_path, uint32_t stripes, int max_attempts = UPLOAD_MAX_ATTEMPTS);
+    // Uploads a file the server already has as an rsync-style delta: the server signs its copy
+    // in blocks, and only bytes that match none of them are sent, with the rest copied from
+    // that copy. Falls back to StoreFile for files the server lacks, files under
+    // DELTA_MIN_FILE_SIZE, older servers, and a copy that changed after it was signed. The
+    // stream always takes its locks on the server, whatever SetInlineLocking says.
+    grpc::StatusCode StoreFileDelta(const std::string& file_path);
+    // Uploads a file in content-defined chunks (cdc_chunker.h), sending only those the
+    // server's chunk store lacks, whatever file they were stored for; the rest are referenced
+    // by hash. Falls back to StoreFile for files under DELTA_MIN_FILE_SIZE, servers without a
+    // chunk store, files that share no chunk with it, and chunks dropped meanwhile.
+    grpc::StatusCode StoreFileDedup(const std::string& file_path);
+    // Chunks are checked against their CRC-32C as they arrive (uploads send one too); a
+    // damaged chunk ends the fetch with DATA_LOSS.
     grpc::StatusCode FetchFile(const std::string& file_path);
+    // Fetches length bytes from offset (0 = to the end) into the same offset of the local
+    // file, leaving the rest of it untouched; creates the local file if needed.
+    grpc::StatusCode FetchFile(const std::string& file_path, uint64_t offset, uint64_t length);
+    // Downloads the whole file as disjoint byte ranges on up to streams parallel streams
+    // (0 = picked from the file size), each written at its offset of a local file that is
+    // preallocated to the full size. The first stream fetches the head of the file and reports
+    // its size; the remaining ranges are requested once that arrives.
+    grpc::StatusCode FetchFileParallel(const std::string& file_path, uint32_t streams = 0);
 
     std::string GetClientMountPath() const;
+
+    // When enabled, StoreFile/FetchFile take their lock inside the transfer stream
+    // instead of with a separate GetFileLock round trip. Off by default so older
+    // servers keep working.
+    void SetInlineLocking(bool enabled);
+
+    // When enabled, StoreFile sends client_id and the path once, in a header message, instead
+    // of on every chunk. Off by default: servers that predate FILE_STREAM_VERSION 1 ignore the
+    // header.
+    void SetHeaderOnceStreams(bool enabled);
+
+    // Buffer reuse across every transfer this client has run.
+    ChunkPoolStats GetChunkPoolStats() const;
+
+    // Payload bytes per chunk for transfers started afterwards (0 = CHUNK_SIZE). Uploads pick
+    // it themselves; downloads ask the server for it, which clamps it to its own limit. With
+    // adaptive set, the sending side grows chunks on fast links and shrinks them on slow ones.
+    void SetChunkSize(size_t chunk_size, bool adaptive = false);
+
+    // The receive limit the channel was created with (GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH);
+    // no chunk grows past it. StoreFile also assumes the server accepts messages this large.
+    void SetMaxMessageSize(size_t bytes);
+
+    // Compresses transfers started afterwards with codec at level (0 = the codec's default),
+    // per chunk and only where it shrinks the chunk. Downloads ask the server for it; uploads
+    // use it once the server has listed it in GetServerInfo, and go out raw otherwise.
+    // Codecs this build lacks leave compression off.
+    void SetCompression(minidfs::Codec codec, int level = 0);
+
+    // Compression ratio and codec time over every transfer this client has run.
+    CodecStats GetCodecStats() const;
+
+    // What StoreFileDelta and StoreFileDedup sent, over every call on this client.
+    DeltaStats GetDeltaStats() const;
+
+    // How long the server's GetServerInfo answer is reused; 0 asks before every transfer
+    // that needs it.
+    void SetServerInfoTtl(std::chrono::milliseconds ttl);
     
 private:
+    // Sends every stripe that is still missing bytes, each on its own thread and stream;
+    // status is replaced with the server's reply once one of them commits the file.
+    grpc::Status UploadStripes(const std::string& file_path, minidfs::UploadStatus* status);
+
+    grpc::Status UploadRange(const std::string& file_path, const std::string& upload_id, uint32_t stripe,
+        uint64_t offset, uint64_t end, size_t max_chunk_size, minidfs::UploadStatus* response);
+
+    // Streams one StoreFileDelta call. encode reads the local file, adds its ops to the packer
+    // and sets the file's hash; negotiated_bytes is what it took to plan them.
+    grpc::Status UploadDelta(const std::string& file_path, uint64_t size, const minidfs::DeltaHeader& header,
+        uint64_t negotiated_bytes, const std::function<bool(std::ifstream&, DeltaPacker&, std::string*)>& encode);
+
+    grpc::Status UploadDedup(const std::string& file_path, uint64_t size);
+
+    grpc::StatusCode FetchFileRange(const std::string& file_path, uint64_t offset, uint64_t length, bool whole_file);
+
+    // One tail range of FetchFileParallel, sharing the head stream's read lock through
+    // lock_token. on_first runs once, when the stream's first chunk arrives or the stream
+    // ends without one.
+    grpc::Status FetchRangeInto(const std::string& file_path, uint64_t offset, uint64_t end, uint64_t file_size,
+        uint64_t lock_token, grpc::ClientContext* context, const std::function<void()>& on_first);
+
+    // Fills in the chunk size and codec negotiation fields of a FetchFile request.
+    void SetChunkOptions(minidfs::FetchFileReq* request) const;
+
+    // The server's GetServerInfo answer, asked for again once it is older than the TTL;
+    // false if the server could not be reached.
+    bool LoadServerInfo(minidfs::ServerInfo* info);
+
+    // The largest chunk StoreFile and StoreFileDelta send: this client's own limit, capped by
+    // the max_chunk_size the server reports, or CHUNK_SIZE when it reports none.
+    size_t UploadMaxChunkSize();
+
+    // The codec uploads use: the configured one if the server supports it, else CODEC_NONE.
+    // Goes by the server's cached GetServerInfo answer.
+    minidfs::Codec UploadCodec();
+
     std::shared_ptr<ClientFileSession> AcquireClientFileSession(const std::string& file_path);
     void ReleaseClientFileSession(const std::string& file_path);
     
     std::unique_ptr<minidfs::MiniDFSService::Stub> stub_;
     std::string mount_path_;
     std::string client_id_;
+    bool inline_locking_ = false;
+    bool header_once_ = false;
+    size_t chunk_size_ = CHUNK_SIZE;
+    bool adaptive_chunks_ = false;
+    size_t max_message_size_ = MAX_MESSAGE_SIZE;
+    minidfs::Codec codec_ = minidfs::CODEC_NONE;
+    int codec_level_ = 0;
+    CodecCounters codec_counters_;
+    std::mutex server_info_mu_;
+    std::optional<minidfs::ServerInfo> server_info_;
+    std::chrono::steady_clock::time_point server_info_time_;
+    std::chrono::milliseconds server_info_ttl_{SERVER_INFO_TTL_MS};
+    mutable std::mutex delta_mu_;
+    DeltaStats delta_stats_;
+    ChunkPool chunk_pool_;
 
     std::thread file_update_thread_;
     std::unique_ptr<grpc::ClientContext> sync_context_;
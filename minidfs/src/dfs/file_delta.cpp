@@ -0,0 +1,234 @@
+#include "dfs/file_delta.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <openssl/evp.h>
+
+// ComputeDelta reads the new file in pieces of this size.
+#define DELTA_READ_SIZE (256 * 1024)
+// log2 of the bits in ComputeDelta's weak checksum filter.
+#define DELTA_FILTER_BITS 20
+
+void RollingChecksum::Init(const char* data, size_t size) {
+    a_ = 0;
+    b_ = 0;
+    size_ = size;
+    for (size_t i = 0; i < size; i++) {
+        unsigned char byte = static_cast<unsigned char>(data[i]);
+        a_ += byte;
+        b_ += static_cast<uint32_t>(size - i) * byte;
+    }
+}
+
+size_t DeltaBlockSize(uint64_t file_size) {
+    uint64_t size = static_cast<uint64_t>(std::sqrt(static_cast<double>(file_size)));
+    size = std::max<uint64_t>(size, (file_size + DELTA_MAX_BLOCKS - 1) / DELTA_MAX_BLOCKS);
+    size = (size + 63) & ~uint64_t(63);
+    return static_cast<size_t>(std::clamp<uint64_t>(size, DELTA_MIN_BLOCK_SIZE, DELTA_MAX_BLOCK_SIZE));
+}
+
+void BlockDigest(const char* data, size_t size, char* out) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    if (EVP_Digest(data, size, digest, &digest_len, EVP_sha256(), nullptr) != 1) {
+        digest_len = 0;
+    }
+    // a failed digest matches nothing a working one produced, barring a 2^-128 chance
+    std::memset(digest + digest_len, 0, sizeof(digest) - digest_len);
+    std::memcpy(out, digest, DELTA_STRONG_SIZE);
+}
+
+bool ComputeSignature(std::istream& in, uint64_t size, minidfs::FileSignature* signature) {
+    size_t block_size = DeltaBlockSize(size);
+    uint64_t blocks = (size + block_size - 1) / block_size;
+    if (blocks > DELTA_MAX_BLOCKS) return false;
+
+    signature->set_file_size(size);
+    signature->set_block_size(static_cast<uint32_t>(block_size));
+    signature->mutable_weak()->Reserve(static_cast<int>(blocks));
+    std::string* strong = signature->mutable_strong();
+    strong->resize(blocks * DELTA_STRONG_SIZE);
+
+    std::vector<char> buffer(block_size);
+    RollingChecksum sum;
+    for (uint64_t block = 0; block < blocks; block++) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(block_size, size - block * block_size));
+        if (!in.read(buffer.data(), want)) return false;
+        sum.Init(buffer.data(), want);
+        signature->add_weak(sum.Value());
+        BlockDigest(buffer.data(), want, strong->data() + block * DELTA_STRONG_SIZE);
+    }
+    return true;
+}
+
+namespace {
+
+uint32_t FilterSlot(uint32_t weak) {
+    return (weak * 0x9E3779B1u) >> (32 - DELTA_FILTER_BITS);
+}
+
+// The new file's bytes from the start of the pending literal on; everything before it has
+// been emitted and is dropped on the next refill.
+struct DeltaWindow {
+    std::vector<char> buf;
+    size_t pos = 0;         // start of the block-sized window being matched
+    size_t literal = 0;     // start of the bytes not yet emitted
+    bool eof = false;
+};
+
+}
+
+bool ComputeDelta(std::istream& in, const minidfs::FileSignature& signature, size_t max_literal,
+    IncrementalHash* hash, const std::function<bool(minidfs::DeltaOp&)>& emit)
+{
+    const size_t block_size = signature.block_size();
+    uint32_t blocks = static_cast<uint32_t>(signature.weak_size());
+    if (block_size == 0 || signature.strong().size() != size_t(blocks) * DELTA_STRONG_SIZE
+        || signature.file_size() > uint64_t(blocks) * block_size) {
+        blocks = 0;     // nothing usable to match against; the whole file goes out as literal
+    }
+    max_literal = std::max<size_t>(max_literal, 1);
+    const size_t last_size = blocks ? static_cast<size_t>(signature.file_size() - uint64_t(blocks - 1) * block_size) : 0;
+    // a short last block can only match the very end of the file, so it stays out of the index
+    const uint32_t rolling_blocks = (blocks && last_size < block_size) ? blocks - 1 : blocks;
+
+    std::vector<uint64_t> filter;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> index;
+    if (rolling_blocks) {
+        filter.assign((size_t(1) << DELTA_FILTER_BITS) / 64, 0);
+        index.reserve(rolling_blocks);
+        for (uint32_t block = 0; block < rolling_blocks; block++) {
+            uint32_t weak = signature.weak(block);
+            uint32_t slot = FilterSlot(weak);
+            filter[slot / 64] |= uint64_t(1) << (slot % 64);
+            index[weak].push_back(block);
+        }
+    }
+
+    auto strong_matches = [&](uint32_t block, const char* digest) {
+        return std::memcmp(signature.strong().data() + size_t(block) * DELTA_STRONG_SIZE, digest, DELTA_STRONG_SIZE) == 0;
+    };
+
+    DeltaWindow w;
+    minidfs::DeltaOp op;
+    bool copy_pending = false;
+
+    auto flush_copy = [&]() {
+        if (!copy_pending) return true;
+        copy_pending = false;
+        return emit(op);
+    };
+    auto add_copy = [&](uint32_t block) {
+        if (copy_pending && op.block() + op.blocks() == block) {
+            op.set_blocks(op.blocks() + 1);
+            return true;
+        }
+        if (!flush_copy()) return false;
+        op.Clear();
+        op.set_block(block);
+        op.set_blocks(1);
+        copy_pending = true;
+        return true;
+    };
+    auto flush_literal = [&](size_t end) {
+        if (end == w.literal) return true;
+        if (!flush_copy()) return false;
+        while (w.literal < end) {
+            size_t size = std::min(end - w.literal, max_literal);
+            op.Clear();
+            op.set_literal(w.buf.data() + w.literal, size);
+            if (!emit(op)) return false;
+            w.literal += size;
+        }
+        return true;
+    };
+    auto refill = [&]() {
+        w.buf.erase(w.buf.begin(), w.buf.begin() + w.literal);
+        w.pos -= w.literal;
+        w.literal = 0;
+        size_t old_size = w.buf.size();
+        w.buf.resize(old_size + DELTA_READ_SIZE);
+        in.read(w.buf.data() + old_size, DELTA_READ_SIZE);
+        size_t got = static_cast<size_t>(in.gcount());
+        w.buf.resize(old_size + got);
+        hash->Update(w.buf.data() + old_size, got);
+        if (got < DELTA_READ_SIZE) w.eof = true;
+        return !in.bad();
+    };
+
+    RollingChecksum sum;
+    bool rolling = false;
+    int64_t last_match = -1;
+    char digest[DELTA_STRONG_SIZE];
+    while (true) {
+        // one byte past the window, so a miss can roll forward without another check
+        if (w.buf.size() - w.pos <= block_size && !w.eof) {
+            if (!refill()) return false;
+            continue;
+        }
+        if (w.buf.size() - w.pos < block_size || rolling_blocks == 0) break;
+
+        const char* window = w.buf.data() + w.pos;
+        if (!rolling) {
+            sum.Init(window, block_size);
+            rolling = true;
+        }
+
+        int64_t match = -1;
+        uint32_t weak = sum.Value();
+        uint32_t slot = FilterSlot(weak);
+        if (filter[slot / 64] & (uint64_t(1) << (slot % 64))) {
+            auto it = index.find(weak);
+            if (it != index.end()) {
+                BlockDigest(window, block_size, digest);
+                // the block after the last match is the likeliest, and extends the same copy
+                uint32_t next = static_cast<uint32_t>(last_match + 1);
+                if (last_match >= 0 && next < rolling_blocks && signature.weak(next) == weak && strong_matches(next, digest)) {
+                    match = next;
+                } else {
+                    for (uint32_t block : it->second) {
+                        if (strong_matches(block, digest)) {
+                            match = block;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (match >= 0) {
+            if (!flush_literal(w.pos) || !add_copy(static_cast<uint32_t>(match))) return false;
+            w.pos += block_size;
+            w.literal = w.pos;
+            last_match = match;
+            rolling = false;
+            continue;
+        }
+
+        if (w.pos + block_size < w.buf.size()) {
+            sum.Roll(static_cast<unsigned char>(window[0]), static_cast<unsigned char>(window[block_size]));
+        }
+        w.pos++;
+        if (w.pos - w.literal >= max_literal && !flush_literal(w.pos)) return false;
+    }
+
+    // drain the input when there was nothing to match against
+    while (!w.eof) {
+        if (!refill() || !flush_literal(w.buf.size())) return false;
+    }
+
+    size_t end = w.buf.size();
+    if (blocks && last_size < block_size && end - w.literal >= last_size) {
+        const char* tail = w.buf.data() + end - last_size;
+        RollingChecksum tail_sum;
+        tail_sum.Init(tail, last_size);
+        BlockDigest(tail, last_size, digest);
+        if (tail_sum.Value() == signature.weak(blocks - 1) && strong_matches(blocks - 1, digest)) {
+            if (!flush_literal(end - last_size) || !add_copy(blocks - 1)) return false;
+            w.literal = end;
+        }
+    }
+    return flush_literal(end) && flush_copy();
+}
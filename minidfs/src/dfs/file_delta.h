@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include "proto_src/minidfs.pb.h"
+#include "dfs/storage/file_hash.h"
+
+// Signature blocks are about sqrt(file size) bytes, kept within these bounds.
+#define DELTA_MIN_BLOCK_SIZE (2 * 1024)
+#define DELTA_MAX_BLOCK_SIZE (1024 * 1024)
+// Files that would need more blocks than this are not signed; they go up whole.
+#define DELTA_MAX_BLOCKS (64 * 1024)
+// Bytes of each block's SHA-256 kept in a signature.
+#define DELTA_STRONG_SIZE 16
+// Upper bound on the bytes one DeltaChunk rebuilds, literal and copied together.
+#define DELTA_MAX_MESSAGE_OUTPUT (8 * 1024 * 1024)
+// Below this a delta cannot save enough to pay for the signature round trip.
+#define DELTA_MIN_FILE_SIZE (64 * 1024)
+
+struct DeltaStats {
+    uint64_t delta_uploads = 0;
+    uint64_t full_uploads = 0;      // sent whole: new or small files, older servers, stale signatures
+    uint64_t file_bytes = 0;        // size of the files sent as deltas
+    uint64_t wire_bytes = 0;        // their signatures, chunk lookups and delta messages, serialized
+    uint64_t reused_bytes = 0;      // bytes of them the server already had
+};
+
+// rsync's rolling checksum over a fixed-size window: two 16-bit running sums that can be
+// slid forward one byte at a time.
+class RollingChecksum {
+public:
+    void Init(const char* data, size_t size);
+
+    // Slides the window one byte: out leaves at the front, in joins at the back.
+    void Roll(unsigned char out, unsigned char in) {
+        a_ += in - out;
+        b_ += a_ - static_cast<uint32_t>(size_) * out;
+    }
+
+    uint32_t Value() const {
+        return (a_ & 0xffff) | (b_ << 16);
+    }
+
+private:
+    uint32_t a_ = 0;
+    uint32_t b_ = 0;
+    size_t size_ = 0;
+};
+
+size_t DeltaBlockSize(uint64_t file_size);
+
+// Truncated SHA-256 of one block; writes DELTA_STRONG_SIZE bytes.
+void BlockDigest(const char* data, size_t size, char* out);
+
+// Signs size bytes read from in. false on a read error, or when the file is too large to sign.
+bool ComputeSignature(std::istream& in, uint64_t size, minidfs::FileSignature* signature);
+
+// Reads in to the end and describes it against signature, calling emit for every op in file
+// order. Runs of matching blocks are merged into one copy; literal ops carry at most
+// max_literal bytes. Every byte read is also fed to hash. false on a read error or when emit
+// returns false.
+bool ComputeDelta(std::istream& in, const minidfs::FileSignature& signature, size_t max_literal,
+    IncrementalHash* hash, const std::function<bool(minidfs::DeltaOp&)>& emit);
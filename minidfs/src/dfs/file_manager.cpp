@@ -1,24 +1,162 @@
 #include "dfs/file_manager.h"
+#include "dfs/storage/chunk_store.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
-#include <openssl/evp.h>
+#ifdef MINIDFS_POSIX_IO
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
 
 namespace fs = std::filesystem;
 
-bool FileManager::AcquireWriteLock(const std::string& client_id, const std::string& file_path, bool create) {
-    std::unique_lock<std::mutex> lock(file_lock_mu_);
-    auto& fl = file_locks_[file_path];
-    if (!fl) fl = std::make_unique<FileLock>();
+#ifdef MINIDFS_POSIX_IO
+static bool PwriteAll(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
 
-    fl->pending_writers++;
-    fl->cv.wait(lock, [&] {
-        return fl->readers == 0 && !fl->has_writer;
-        });
-    fl->pending_writers--;
+static bool PreadFull(int fd, char* out, size_t size, uint64_t offset, size_t* bytes_read) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = ::pread(fd, out + total, size - total, static_cast<off_t>(offset + total));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) break;
+        total += static_cast<size_t>(n);
+    }
+    *bytes_read = total;
+    return true;
+}
+
+static int DataSync(int fd) {
+#ifdef __APPLE__
+    return ::fsync(fd);
+#else
+    return ::fdatasync(fd);
+#endif
+}
+#endif
+
+FileSession::~FileSession() {
+#ifdef MINIDFS_POSIX_IO
+    if (fd >= 0) ::close(fd);
+#endif
+}
+
+FileManager::FileManager(IoBackend backend) {
+    SetIoBackend(backend);
+}
+
+void FileManager::SetIoBackend(IoBackend backend) {
+#ifdef MINIDFS_URING_IO
+    if (backend == IoBackend::URING) {
+        // the engine is created once and kept; sessions opened under it may outlive a backend switch
+        std::lock_guard<std::mutex> lock(uring_mu_);
+        if (!uring_) uring_ = UringEngine::Create(URING_QUEUE_DEPTH);
+        if (!uring_) {
+            std::cerr << "io_uring backend unavailable, falling back to posix" << std::endl;
+            backend = IoBackend::POSIX;
+        }
+    }
+#else
+    if (backend == IoBackend::URING) backend = IoBackend::POSIX;
+#endif
+#ifndef MINIDFS_POSIX_IO
+    if (backend == IoBackend::POSIX) backend = IoBackend::FSTREAM;
+#endif
+    io_backend_ = backend;
+}
+
+IoBackend FileManager::GetIoBackend() const {
+    return io_backend_.load();
+}
+
+void FileManager::SetSyncOnRelease(bool enabled) {
+    sync_on_release_ = enabled;
+}
+
+void FileManager::SetChunkStore(ChunkStore* store) {
+    chunk_store_ = store;
+}
+
+bool FileManager::SyncFile(const std::string& client_id, const std::string& file_path) {
+    std::shared_ptr<FileSession> session = FindSession(client_id, file_path, true);
+    if (!session) return false;
+
+#ifdef MINIDFS_POSIX_IO
+    if (session->fd >= 0) return DataSync(session->fd) == 0;
+#endif
+
+    std::lock_guard<std::mutex> lock(session->io_mu);
+    if (!session->write_handle || !session->write_handle->is_open()) return false;
+    session->write_handle->flush();
+    return !session->write_handle->fail();
+}
+
+LockShard& FileManager::GetShard(const std::string& file_path) {
+    return lock_shards_[std::hash<std::string>{}(file_path) % LOCK_SHARD_COUNT];
+}
+
+std::shared_ptr<FileLock> FileManager::GetOrCreateFileLock(const std::string& file_path) {
+    LockShard& shard = GetShard(file_path);
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto& fl = shard.file_locks[file_path];
+    if (!fl) fl = std::make_shared<FileLock>();
+    return fl;
+}
+
+std::shared_ptr<FileLock> FileManager::FindFileLock(const std::string& file_path) {
+    LockShard& shard = GetShard(file_path);
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto it = shard.file_locks.find(file_path);
+    if (it == shard.file_locks.end()) return nullptr;
+    return it->second;
+}
+
+std::shared_ptr<FileSession> FileManager::FindSession(const std::string& client_id, const std::string& file_path, bool is_writer) {
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl) return nullptr;
+
+    std::lock_guard<std::mutex> lock(fl->mu);
+    auto it = fl->sessions.find(client_id);
+    if (it == fl->sessions.end() || it->second->is_writer != is_writer) return nullptr;
+    return it->second;
+}
+
+void FileManager::EraseIfIdle(const std::string& file_path, const std::shared_ptr<FileLock>& fl) {
+    LockShard& shard = GetShard(file_path);
+    std::lock_guard<std::mutex> shard_lock(shard.mu);
+    auto it = shard.file_locks.find(file_path);
+    if (it == shard.file_locks.end() || it->second != fl) return;
+
+    // Anyone still waiting on (or about to wait on) this lock holds a reference,
+    // so only the map entry and the caller's copy may remain.
+    if (fl.use_count() > 2) return;
+
+    std::lock_guard<std::mutex> lock(fl->mu);
+    if (fl->sessions.empty() && fl->waiters.empty() && fl->readers == 0 && fl->pending_writers == 0 && !fl->has_writer) {
+        shard.file_locks.erase(it);
+    }
+}
 
-    auto session = std::make_unique<FileSession>();
+// Caller holds fl.mu and has already waited for the lock to be free.
+bool FileManager::OpenWriteSession(FileLock& fl, const std::string& client_id, const std::string& file_path, bool create) {
+    auto session = std::make_shared<FileSession>();
     session->client_id = client_id;
     session->is_writer = true;
 
@@ -27,6 +165,22 @@ bool FileManager::AcquireWriteLock(const std::string& client_id, const std::stri
         fs::create_directories(parent);
     }
 
+#ifdef MINIDFS_POSIX_IO
+    IoBackend backend = io_backend_;
+    if (backend == IoBackend::POSIX || backend == IoBackend::URING) {
+        session->fd = ::open(file_path.c_str(), O_RDWR | O_CLOEXEC);
+        if (session->fd < 0 && create) {
+            session->fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        }
+        if (session->fd < 0 && create) return false;
+        session->uring = backend == IoBackend::URING && session->fd >= 0;
+
+        fl.has_writer = true;
+        fl.sessions[client_id] = std::move(session);
+        return true;
+    }
+#endif
+
     session->write_handle = std::make_unique<std::fstream>(
         file_path, std::ios::in | std::ios::out | std::ios::binary
     );
@@ -37,75 +191,255 @@ bool FileManager::AcquireWriteLock(const std::string& client_id, const std::stri
 
     if (!session->write_handle->is_open() && create) return false;
 
-    fl->has_writer = true;
-    fl->sessions[client_id] = std::move(session);
+    fl.has_writer = true;
+    fl.sessions[client_id] = std::move(session);
+    return true;
+}
+
+// Caller holds fl.mu. Takes another hold on client_id's read session if it already has one.
+// Past a queued writer only with the session's lock_token: the fetch that opened the session
+// keeps its first hold until its other streams have nested, so they must not wait, but any
+// other request from the client would keep the writer out indefinitely.
+bool FileManager::NestReadSession(FileLock& fl, const std::string& client_id, uint64_t lock_token) {
+    auto it = fl.sessions.find(client_id);
+    if (it == fl.sessions.end() || it->second->is_writer) return false;
+    if (fl.pending_writers > 0 && (lock_token == 0 || lock_token != it->second->lock_token)) return false;
+    it->second->holds++;
+    fl.readers++;
+    return true;
+}
+
+// Caller holds fl.mu and has already waited for the lock to be free.
+bool FileManager::OpenReadSession(FileLock& fl, const std::string& client_id, const std::string& file_path) {
+    if (NestReadSession(fl, client_id, 0)) return true;
+    if (!fs::exists(file_path)) return false;
+
+    auto session = std::make_shared<FileSession>();
+    session->client_id = client_id;
+    session->is_writer = false;
+    session->lock_token = next_lock_token_++;
+
+#ifdef MINIDFS_POSIX_IO
+    IoBackend backend = io_backend_;
+    if (backend == IoBackend::POSIX || backend == IoBackend::URING) {
+        session->fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (session->fd < 0) return false;
+        session->uring = backend == IoBackend::URING;
+
+        fl.readers++;
+        fl.sessions[client_id] = std::move(session);
+        return true;
+    }
+#endif
+
+    session->read_handle = std::make_unique<std::ifstream>(file_path, std::ios::binary);
+
+    if (!session->read_handle->is_open()) return false;
+
+    fl.readers++;
+    fl.sessions[client_id] = std::move(session);
     return true;
 }
 
+// Caller holds fl.mu. Hands the lock to queued async waiters (writers first, like the
+// blocking path) and wakes blocked threads. Callbacks are collected into grants so they
+// run after fl.mu is dropped.
+void FileManager::WakeWaiters(FileLock& fl, const std::string& file_path, std::vector<LockGrant>& grants) {
+    while (!fl.has_writer && !fl.waiters.empty()) {
+        auto writer_it = std::find_if(fl.waiters.begin(), fl.waiters.end(),
+            [](const std::shared_ptr<LockWaiter>& w) { return w->is_writer; });
+
+        if (writer_it != fl.waiters.end()) {
+            if (fl.readers > 0) break;
+            std::shared_ptr<LockWaiter> w = *writer_it;
+            fl.waiters.erase(writer_it);
+            fl.pending_writers--;
+            grants.emplace_back(w, OpenWriteSession(fl, w->client_id, file_path, w->create));
+            continue;
+        }
+
+        // only readers queued; a blocked writer thread still has priority over them
+        if (fl.pending_writers > 0) break;
+        while (!fl.waiters.empty()) {
+            std::shared_ptr<LockWaiter> w = fl.waiters.front();
+            fl.waiters.pop_front();
+            grants.emplace_back(w, OpenReadSession(fl, w->client_id, file_path));
+        }
+    }
+    fl.cv.notify_all();
+}
+
+void FileManager::CompleteGrants(std::vector<LockGrant>& grants) {
+    for (auto& [waiter, granted] : grants) {
+        waiter->on_complete(granted);
+    }
+}
+
+bool FileManager::AcquireWriteLock(const std::string& client_id, const std::string& file_path, bool create) {
+    std::shared_ptr<FileLock> fl = GetOrCreateFileLock(file_path);
+    std::vector<LockGrant> grants;
+    bool ok;
+    {
+        std::unique_lock<std::mutex> lock(fl->mu);
+
+        fl->pending_writers++;
+        fl->cv.wait(lock, [&] {
+            return fl->readers == 0 && !fl->has_writer;
+            });
+        fl->pending_writers--;
+
+        ok = OpenWriteSession(*fl, client_id, file_path, create);
+        if (!ok) WakeWaiters(*fl, file_path, grants);
+    }
+    CompleteGrants(grants);
+    return ok;
+}
+
 void FileManager::ReleaseWriteLock(const std::string& client_id, const std::string& file_path) {
-    std::unique_lock<std::mutex> lock(file_lock_mu_);
-    auto it = file_locks_.find(file_path);
-    if (it == file_locks_.end()) return;
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl) return;
+
+    if (sync_on_release_) {
+        SyncFile(client_id, file_path);
+    }
 
-    FileLock* fl = it->second.get();
-    if (fl->sessions.erase(client_id) > 0) {
+    std::vector<LockGrant> grants;
+    {
+        std::lock_guard<std::mutex> lock(fl->mu);
+        auto it = fl->sessions.find(client_id);
+        if (it == fl->sessions.end() || !it->second->is_writer) return;
+        fl->sessions.erase(it);
         fl->has_writer = false;
-        fl->cv.notify_all();
+        WakeWaiters(*fl, file_path, grants);
     }
+    CompleteGrants(grants);
+    EraseIfIdle(file_path, fl);
 }
 
-bool FileManager::AcquireReadLock(const std::string& client_id, const std::string& file_path) {
-    std::unique_lock<std::mutex> lock(file_lock_mu_);
-    auto& fl = file_locks_[file_path];
-    if (!fl) fl = std::make_unique<FileLock>();
+bool FileManager::AcquireReadLock(const std::string& client_id, const std::string& file_path, uint64_t lock_token) {
+    std::shared_ptr<FileLock> fl = GetOrCreateFileLock(file_path);
+    std::unique_lock<std::mutex> lock(fl->mu);
+    if (NestReadSession(*fl, client_id, lock_token)) return true;
 
     fl->cv.wait(lock, [&] {
         return !fl->has_writer && fl->pending_writers == 0;
         });
 
-    if (!fs::exists(file_path)) return false;
+    return OpenReadSession(*fl, client_id, file_path);
+}
 
-    auto session = std::make_unique<FileSession>();
-    session->client_id = client_id;
-    session->is_writer = false;
-    session->read_handle = std::make_unique<std::ifstream>(file_path, std::ios::binary);
+void FileManager::ReleaseReadLock(const std::string& client_id, const std::string& file_path) {
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl) return;
+
+    std::vector<LockGrant> grants;
+    {
+        std::lock_guard<std::mutex> lock(fl->mu);
+        auto it = fl->sessions.find(client_id);
+        if (it == fl->sessions.end() || it->second->is_writer) return;
+        if (--it->second->holds == 0) fl->sessions.erase(it);
+        fl->readers--;
+        if (fl->readers == 0) {
+            WakeWaiters(*fl, file_path, grants);
+        }
+    }
+    CompleteGrants(grants);
+    EraseIfIdle(file_path, fl);
+}
 
-    if (!session->read_handle->is_open()) return false;
+std::shared_ptr<LockWaiter> FileManager::AcquireWriteLockAsync(const std::string& client_id, const std::string& file_path, bool create, std::function<void(bool)> on_complete) {
+    std::shared_ptr<FileLock> fl = GetOrCreateFileLock(file_path);
+    std::vector<LockGrant> grants;
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(fl->mu);
+        if (fl->readers > 0 || fl->has_writer) {
+            auto waiter = std::make_shared<LockWaiter>();
+            waiter->client_id = client_id;
+            waiter->is_writer = true;
+            waiter->create = create;
+            waiter->on_complete = std::move(on_complete);
+            fl->pending_writers++;
+            fl->waiters.push_back(waiter);
+            return waiter;
+        }
 
-    fl->readers++;
-    fl->sessions[client_id] = std::move(session);
-    return true;
+        ok = OpenWriteSession(*fl, client_id, file_path, create);
+        if (!ok) WakeWaiters(*fl, file_path, grants);
+    }
+    CompleteGrants(grants);
+    on_complete(ok);
+    return nullptr;
 }
 
-void FileManager::ReleaseReadLock(const std::string& client_id, const std::string& file_path) {
-    std::unique_lock<std::mutex> lock(file_lock_mu_);
-    auto it = file_locks_.find(file_path);
-    if (it == file_locks_.end()) return;
+std::shared_ptr<LockWaiter> FileManager::AcquireReadLockAsync(const std::string& client_id, const std::string& file_path, std::function<void(bool)> on_complete, uint64_t lock_token) {
+    std::shared_ptr<FileLock> fl = GetOrCreateFileLock(file_path);
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(fl->mu);
+        bool nested = NestReadSession(*fl, client_id, lock_token);
+        if (!nested && (fl->has_writer || fl->pending_writers > 0)) {
+            auto waiter = std::make_shared<LockWaiter>();
+            waiter->client_id = client_id;
+            waiter->on_complete = std::move(on_complete);
+            fl->waiters.push_back(waiter);
+            return waiter;
+        }
 
-    FileLock* fl = it->second.get();
-    if (fl->sessions.erase(client_id) > 0) {
-        fl->readers--;
-        if (fl->readers == 0) {
-            fl->cv.notify_all();
+        ok = nested || OpenReadSession(*fl, client_id, file_path);
+    }
+    on_complete(ok);
+    return nullptr;
+}
+
+uint64_t FileManager::ReadLockToken(const std::string& client_id, const std::string& file_path) {
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl) return 0;
+
+    std::lock_guard<std::mutex> lock(fl->mu);
+    auto it = fl->sessions.find(client_id);
+    if (it == fl->sessions.end() || it->second->is_writer) return 0;
+    return it->second->lock_token;
+}
+
+bool FileManager::CancelLockWaiter(const std::string& file_path, const std::shared_ptr<LockWaiter>& waiter) {
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl || !waiter) return false;
+
+    std::vector<LockGrant> grants;
+    {
+        std::lock_guard<std::mutex> lock(fl->mu);
+        auto it = std::find(fl->waiters.begin(), fl->waiters.end(), waiter);
+        if (it == fl->waiters.end()) return false;
+        fl->waiters.erase(it);
+        if (waiter->is_writer) {
+            fl->pending_writers--;
+            WakeWaiters(*fl, file_path, grants);
         }
     }
+    CompleteGrants(grants);
+    return true;
 }
 
 void FileManager::ReleaseAllLocks() {
-    std::lock_guard<std::mutex> lock(file_lock_mu_);
-    file_locks_.clear();
+    for (auto& shard : lock_shards_) {
+        std::lock_guard<std::mutex> lock(shard.mu);
+        shard.file_locks.clear();
+    }
 }
 
 bool FileManager::WriteFile(const std::string& client_id, const std::string& file_path, uint64_t offset, const void* data, size_t size) {
-    std::lock_guard<std::mutex> lock(file_lock_mu_);
-
-    auto it = file_locks_.find(file_path);
-    if (it == file_locks_.end()) return false;
+    std::shared_ptr<FileSession> session = FindSession(client_id, file_path, true);
+    if (!session) return false;
 
-    auto sess_it = it->second->sessions.find(client_id);
-    if (sess_it == it->second->sessions.end() || !sess_it->second->is_writer) return false;
+#ifdef MINIDFS_POSIX_IO
+    if (session->fd >= 0) {
+        return PwriteAll(session->fd, static_cast<const char*>(data), size, offset);
+    }
+#endif
 
-    auto& handle = sess_it->second->write_handle;
+    std::lock_guard<std::mutex> lock(session->io_mu);
+    auto& handle = session->write_handle;
     if (!handle || !handle->is_open()) return false;
 
     handle->seekp(offset, std::ios::beg);
@@ -115,48 +449,176 @@ bool FileManager::WriteFile(const std::string& client_id, const std::string& fil
     return !handle->fail();
 }
 
-bool FileManager::ReadFile(const std::string& client_id, const std::string& file_path, uint64_t offset, void* out_data, size_t* bytes_read) {
-    std::lock_guard<std::mutex> lock(file_lock_mu_);
-
-    auto it = file_locks_.find(file_path);
-    if (it == file_locks_.end()) return false;
+bool FileManager::ReadFile(const std::string& client_id, const std::string& file_path, uint64_t offset, void* out_data, size_t* bytes_read, size_t size) {
+    std::shared_ptr<FileSession> session = FindSession(client_id, file_path, false);
+    if (!session) return false;
 
-    auto sess_it = it->second->sessions.find(client_id);
-    if (sess_it == it->second->sessions.end() || sess_it->second->is_writer) return false;
+#ifdef MINIDFS_POSIX_IO
+    if (session->fd >= 0) {
+        return PreadFull(session->fd, static_cast<char*>(out_data), size, offset, bytes_read);
+    }
+#endif
 
-    auto& handle = sess_it->second->read_handle;
+    std::lock_guard<std::mutex> lock(session->io_mu);
+    auto& handle = session->read_handle;
     if (!handle || !handle->is_open()) return false;
 
     handle->clear();
     handle->seekg(offset, std::ios::beg);
-    handle->read(static_cast<char*>(out_data), CHUNK_SIZE);
+    handle->read(static_cast<char*>(out_data), size);
     *bytes_read = static_cast<size_t>(handle->gcount());
 
     return true;
 }
 
-FileStatus FileManager::RemoveFile(const std::string& client_id, const std::string& file_path) {
-    std::cout << "Removing file at: " << file_path << std::endl;
-    std::lock_guard<std::mutex> lock(file_lock_mu_);
+void FileManager::WriteFileAsync(const std::string& client_id, const std::string& file_path, uint64_t offset, const void* data, size_t size, std::function<void(bool)> done) {
+#ifdef MINIDFS_URING_IO
+    std::shared_ptr<FileSession> session = FindSession(client_id, file_path, true);
+    if (session && session->uring && size > 0) {
+        const char* bytes = static_cast<const char*>(data);
+        // the lambda's session reference keeps the fd open until the kernel is done with it
+        bool queued = uring_->SubmitWrite(session->fd, bytes, size, offset,
+            [session, bytes, size, offset, done](int res) {
+                // an opcode or flag this kernel's ring refuses: the write itself may well work
+                if (res == -EINVAL || res == -EOPNOTSUPP) {
+                    done(PwriteAll(session->fd, bytes, size, offset));
+                    return;
+                }
+                if (res < 0) {
+                    done(false);
+                    return;
+                }
+                size_t written = static_cast<size_t>(res);
+                // short writes are rare; finish them synchronously rather than resubmitting
+                done(written == size || PwriteAll(session->fd, bytes + written, size - written, offset + written));
+            });
+        if (queued) return;
+    }
+#endif
+    done(WriteFile(client_id, file_path, offset, data, size));
+}
 
-    auto it = file_locks_.find(file_path);
-    if (it == file_locks_.end()) return FileStatus::FILE_LOCKED;
+void FileManager::ReadFileAsync(const std::string& client_id, const std::string& file_path, uint64_t offset, void* out_data, size_t size, std::function<void(bool, size_t)> done) {
+#ifdef MINIDFS_URING_IO
+    std::shared_ptr<FileSession> session = FindSession(client_id, file_path, false);
+    if (session && session->uring) {
+        char* out = static_cast<char*>(out_data);
+        bool queued = uring_->SubmitRead(session->fd, out, size, offset,
+            [session, out, size, offset, done](int res) {
+                if (res == -EINVAL || res == -EOPNOTSUPP) {
+                    size_t bytes_read = 0;
+                    bool ok = PreadFull(session->fd, out, size, offset, &bytes_read);
+                    done(ok, ok ? bytes_read : 0);
+                    return;
+                }
+                if (res < 0) {
+                    done(false, 0);
+                    return;
+                }
+                size_t total = static_cast<size_t>(res);
+                if (total > 0 && total < size) {
+                    size_t rest = 0;
+                    if (!PreadFull(session->fd, out + total, size - total, offset + total, &rest)) {
+                        done(false, 0);
+                        return;
+                    }
+                    total += rest;
+                }
+                done(true, total);
+            });
+        if (queued) return;
+    }
+#endif
+    size_t bytes_read = 0;
+    bool ok = ReadFile(client_id, file_path, offset, out_data, &bytes_read, size);
+    done(ok, bytes_read);
+}
 
-    FileLock* fl = it->second.get();
-    auto session_it = fl->sessions.find(client_id);
-    if (session_it == fl->sessions.end() || !session_it->second->is_writer) return FileStatus::FILE_LOCKED;
-    if (fl->readers > 0) return FileStatus::FILE_LOCKED;
+std::shared_ptr<const MappedFile> FileManager::MapFile(const std::string& client_id, const std::string& file_path) {
+    std::shared_ptr<FileSession> session = FindSession(client_id, file_path, false);
+    if (!session) return nullptr;
 
-    fl->sessions.clear();
+    // the session's own fd, when it has one, is the very file the lock was taken on
+    std::lock_guard<std::mutex> lock(session->io_mu);
+    if (!session->mapping) {
+        session->mapping = MappedFile::Map(session->fd, file_path);
+    }
+    return session->mapping;
+}
 
-	if (!fs::exists(file_path)) return FileStatus::FILE_NOT_FOUND;
+FileStatus FileManager::RemoveFile(const std::string& client_id, const std::string& file_path) {
+    std::cout << "Removing file at: " << file_path << std::endl;
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl) return FileStatus::FILE_LOCKED;
+
+    FileStatus status;
+    std::vector<LockGrant> grants;
+    {
+        std::lock_guard<std::mutex> lock(fl->mu);
+        auto session_it = fl->sessions.find(client_id);
+        if (session_it == fl->sessions.end() || !session_it->second->is_writer) return FileStatus::FILE_LOCKED;
+        if (fl->readers > 0) return FileStatus::FILE_LOCKED;
+
+        fl->sessions.clear();
+        fl->has_writer = false;
+
+        if (!fs::exists(file_path)) {
+            status = FileStatus::FILE_NOT_FOUND;
+        } else {
+            std::error_code ec;
+            bool removed = fs::remove(file_path, ec);
+            status = (!ec && removed) ? FileStatus::FILE_OK : FileStatus::FILE_ERROR;
+        }
+        if (status == FileStatus::FILE_OK) {
+            if (ChunkStore* store = chunk_store_.load()) store->Forget(file_path);
+        }
+        WakeWaiters(*fl, file_path, grants);
+    }
+    CompleteGrants(grants);
+    EraseIfIdle(file_path, fl);
+    return status;
+}
+
+bool FileManager::ReplaceFile(const std::string& client_id, const std::string& file_path, const std::string& source_path) {
+    std::shared_ptr<FileLock> fl = FindFileLock(file_path);
+    if (!fl) return false;
+
+    std::lock_guard<std::mutex> lock(fl->mu);
+    auto it = fl->sessions.find(client_id);
+    if (it == fl->sessions.end() || !it->second->is_writer) return false;
+
+    FileSession& session = *it->second;
+    {
+        std::lock_guard<std::mutex> io_lock(session.io_mu);
+        session.write_handle.reset();
+#ifdef MINIDFS_POSIX_IO
+        if (session.fd >= 0) {
+            ::close(session.fd);
+            session.fd = -1;
+        }
+#endif
+    }
 
     std::error_code ec;
-    bool removed = fs::remove(file_path, ec);
-    file_locks_.erase(it);
+    fs::rename(source_path, file_path, ec);
+    if (!ec) {
+        if (ChunkStore* store = chunk_store_.load()) store->Ingest(file_path);
+        return true;
+    }
 
-    if (ec) return FileStatus::FILE_ERROR;
-    return removed ? FileStatus::FILE_OK : FileStatus::FILE_ERROR;
+    // across filesystems: copy next to the target first so the final step is still a rename
+    ec.clear();
+    std::string staged = file_path + ".minidfs-tmp";
+    fs::copy_file(source_path, staged, fs::copy_options::overwrite_existing, ec);
+    if (!ec) fs::rename(staged, file_path, ec);
+    if (ec) {
+        std::error_code rm_ec;
+        fs::remove(staged, rm_ec);
+        return false;
+    }
+    fs::remove(source_path, ec);
+    if (ChunkStore* store = chunk_store_.load()) store->Ingest(file_path);
+    return true;
 }
 
 fs::path FileManager::ResolvePath(const std::string& mount_path, const std::string& virtual_path) {
@@ -188,36 +650,17 @@ fs::path FileManager::VirtualPath(const std::string& mount_path, const std::stri
 }
 
 std::string FileManager::GetFileHash(const std::string& file_path) {
+    // uploads record their digest as they stream in; only fall back to reading the file
+    std::string stored = LoadStoredHash(file_path);
+    if (!stored.empty()) return stored;
+
     std::ifstream file(file_path, std::ios::binary);
     if (!file) return "";
 
-    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
-    const EVP_MD* md = EVP_sha256();
-
-    if (EVP_DigestInit_ex(mdctx, md, nullptr) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        return "";
-    }
-
+    IncrementalHash hash;
     char buffer[32768];
     while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
-        if (EVP_DigestUpdate(mdctx, buffer, file.gcount()) != 1) {
-            EVP_MD_CTX_free(mdctx);
-            return "";
-        }
-    }
-
-    unsigned char hash[EVP_MAX_MD_SIZE];
-    unsigned int hash_len = 0;
-    if (EVP_DigestFinal_ex(mdctx, hash, &hash_len) != 1) {
-        EVP_MD_CTX_free(mdctx);
-        return "";
-    }
-
-    EVP_MD_CTX_free(mdctx);
-    std::stringstream ss;
-    for (unsigned int i = 0; i < hash_len; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+        if (!hash.Update(buffer, static_cast<size_t>(file.gcount()))) return "";
     }
-    return ss.str();
-}
\ No newline at end of file
+    return hash.Final();
+}
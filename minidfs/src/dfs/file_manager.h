@@ -1,7 +1,12 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <filesystem>
@@ -11,8 +16,23 @@
 #include <sstream>
 #include <vector>
 #include "proto_src/minidfs.pb.h"
+#include "dfs/storage/file_hash.h"
+#include "dfs/storage/mapped_file.h"
+#include "dfs/storage/uring_engine.h"
 
-#define CHUNK_SIZE 40 * 1024
+// Default payload bytes per transfer chunk; streams can negotiate another size (see chunk_sizer.h).
+#define CHUNK_SIZE (40 * 1024)
+// Newest StoreFile stream format this build speaks (FileBuffer.header); streams without a
+// header are version 0.
+#define FILE_STREAM_VERSION 1
+#define LOCK_SHARD_COUNT 64
+#define URING_QUEUE_DEPTH 256
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MINIDFS_POSIX_IO 1
+#endif
+
+class ChunkStore;
 
 enum class FileStatus {
     FILE_OK,
@@ -21,52 +41,166 @@ enum class FileStatus {
     FILE_ERROR
 };
 
+enum class IoBackend {
+    FSTREAM,    // std::fstream, flushed to the OS after every chunk
+    POSIX,      // raw fd with pread/pwrite, no per-chunk flush; durability via SyncFile
+    URING       // POSIX fds with chunk I/O submitted through io_uring; falls back to POSIX
+};
+
 struct FileSession {
+    ~FileSession();
+
     std::string client_id;
     bool is_writer = false;
+    // read locks nest: a client already reading can take the lock again (parallel range
+    // streams do), and the session lives until every hold is released
+    uint32_t holds = 1;
+    // read sessions: holds that pass it may nest even while a writer is queued
+    uint64_t lock_token = 0;
+    // guards the stream handles below; chunk I/O only ever holds this, never the FileLock or shard mutex
+    std::mutex io_mu;
     std::unique_ptr<std::fstream> write_handle;
     std::unique_ptr<std::ifstream> read_handle;
+    // POSIX backend: positional I/O needs no seek state, so fd access skips io_mu
+    int fd = -1;
+    // URING backend: the *Async calls submit on this session's fd instead of running inline
+    bool uring = false;
+    // created by MapFile on first use and shared by every hold on the session
+    std::shared_ptr<const MappedFile> mapping;
+};
+
+// A lock request parked on a FileLock instead of a blocked thread. Whoever
+// removes it from the queue (a grant or CancelLockWaiter) owns completing it.
+struct LockWaiter {
+    std::string client_id;
+    bool is_writer = false;
+    bool create = false;
+    std::function<void(bool granted)> on_complete;
 };
 
 struct FileLock {
+    std::mutex mu;
     std::condition_variable cv;
     uint64_t readers = 0;
     uint64_t pending_writers = 0;
     bool has_writer = false;
-    std::unordered_map<std::string, std::unique_ptr<FileSession>> sessions;
+    std::unordered_map<std::string, std::shared_ptr<FileSession>> sessions;
+    std::deque<std::shared_ptr<LockWaiter>> waiters;
+};
+
+// One stripe of the lock table. The shard mutex only protects the map itself;
+// each FileLock carries its own mutex so unrelated files never contend.
+struct LockShard {
+    std::mutex mu;
+    std::unordered_map<std::string, std::shared_ptr<FileLock>> file_locks;
 };
 
 
 class FileManager {
 public:
+    explicit FileManager(IoBackend backend = IoBackend::FSTREAM);
+
+    // Applies to sessions opened afterwards. POSIX falls back to FSTREAM and URING to POSIX
+    // where unavailable.
+    void SetIoBackend(IoBackend backend);
+
+    IoBackend GetIoBackend() const;
+
+    // fdatasync a writer's file in ReleaseWriteLock, before the lock is handed on.
+    void SetSyncOnRelease(bool enabled);
+
+    // Hands every file committed by ReplaceFile to store, and tells it about removals. The
+    // store must outlive this FileManager or be unset first; nullptr detaches it.
+    void SetChunkStore(ChunkStore* store);
+
+    // Makes everything written so far by client_id durable.
+    bool SyncFile(const std::string& client_id, const std::string& file_path);
 
     bool AcquireWriteLock(const std::string& client_id, const std::string& file_path, bool create);
 
     void ReleaseWriteLock(const std::string& client_id, const std::string& file_path);
 
-    bool AcquireReadLock(const std::string& client_id, const std::string& file_path);
+    // A client that already holds a read lock on the file takes it again at once, unless a
+    // writer is queued: then only a request passing the session's lock_token nests, and any
+    // other waits its turn behind the writer.
+    bool AcquireReadLock(const std::string& client_id, const std::string& file_path, uint64_t lock_token = 0);
 
     void ReleaseReadLock(const std::string& client_id, const std::string& file_path);
+
+    // Non-blocking variants: on_complete runs once the lock is granted or fails. If that
+    // happens immediately it runs inline and nullptr is returned; otherwise the returned
+    // waiter stays queued until a release grants it or CancelLockWaiter removes it.
+    std::shared_ptr<LockWaiter> AcquireWriteLockAsync(const std::string& client_id, const std::string& file_path, bool create, std::function<void(bool)> on_complete);
+
+    std::shared_ptr<LockWaiter> AcquireReadLockAsync(const std::string& client_id, const std::string& file_path, std::function<void(bool)> on_complete, uint64_t lock_token = 0);
+
+    // The lock_token of client_id's read session on the file; 0 without one.
+    uint64_t ReadLockToken(const std::string& client_id, const std::string& file_path);
+
+    // Returns true if the waiter was still queued; its on_complete will then never run.
+    bool CancelLockWaiter(const std::string& file_path, const std::shared_ptr<LockWaiter>& waiter);
     
     bool WriteFile(const std::string& client_id, const std::string &file_path, uint64_t offset, const void* data, size_t size);
 
-    bool ReadFile(const std::string& client_id, const std::string& file_path, uint64_t offset, void* out_data, size_t* bytes_read);
+    // Reads up to size bytes; fewer only at the end of the file.
+    bool ReadFile(const std::string& client_id, const std::string& file_path, uint64_t offset, void* out_data, size_t* bytes_read, size_t size = CHUNK_SIZE);
+
+    // Completion-based chunk I/O. On a URING session the transfer is queued on the ring and
+    // done runs on the engine's reaper thread; every other backend (or a saturated ring)
+    // completes inline on the caller's thread before returning.
+    void WriteFileAsync(const std::string& client_id, const std::string& file_path, uint64_t offset, const void* data, size_t size, std::function<void(bool ok)> done);
+
+    void ReadFileAsync(const std::string& client_id, const std::string& file_path, uint64_t offset, void* out_data, size_t size, std::function<void(bool ok, size_t bytes_read)> done);
+
+    // Maps the file client_id holds a read lock on. The session keeps the mapping until the
+    // lock is released; callers that hand out pointers into it keep their own reference past
+    // that. nullptr without a read session, for an empty file, or where mmap is unavailable.
+    // The server never truncates a file in place (uploads are renamed over it), so the pages
+    // stay valid; a file shrunk behind its back would fault.
+    std::shared_ptr<const MappedFile> MapFile(const std::string& client_id, const std::string& file_path);
 
     FileStatus RemoveFile(const std::string& client_id, const std::string& file_path);
+
+    // Atomically moves source_path over file_path while client_id holds its write lock; readers
+    // that already opened the old file keep reading it. The writer's own handles are closed
+    // first (Windows refuses to replace an open file). Across filesystems the source is copied
+    // beside the target and renamed from there.
+    bool ReplaceFile(const std::string& client_id, const std::string& file_path, const std::string& source_path);
     
     static std::filesystem::path ResolvePath(const std::string& mount_path, const std::string& file_path);
 
 	static std::filesystem::path ResolveAbsolutePath(const std::string& mount_path, const std::string& file_path);
 
+    // Serves the digest StoreFile saved with the file when it is still current.
     static std::string GetFileHash(const std::string& file_path);
 
     static std::filesystem::path VirtualPath(const std::string& mount_path, const std::string& file_path);
 
 private:
     void ReleaseAllLocks();
-        
-    std::mutex file_lock_mu_;
-    std::unordered_map<std::string, std::unique_ptr<FileLock>> file_locks_;
+
+    LockShard& GetShard(const std::string& file_path);
+    std::shared_ptr<FileLock> GetOrCreateFileLock(const std::string& file_path);
+    std::shared_ptr<FileLock> FindFileLock(const std::string& file_path);
+    std::shared_ptr<FileSession> FindSession(const std::string& client_id, const std::string& file_path, bool is_writer);
+    void EraseIfIdle(const std::string& file_path, const std::shared_ptr<FileLock>& fl);
+
+    using LockGrant = std::pair<std::shared_ptr<LockWaiter>, bool>;
+    bool OpenWriteSession(FileLock& fl, const std::string& client_id, const std::string& file_path, bool create);
+    bool NestReadSession(FileLock& fl, const std::string& client_id, uint64_t lock_token);
+    bool OpenReadSession(FileLock& fl, const std::string& client_id, const std::string& file_path);
+    void WakeWaiters(FileLock& fl, const std::string& file_path, std::vector<LockGrant>& grants);
+    static void CompleteGrants(std::vector<LockGrant>& grants);
+
+    std::array<LockShard, LOCK_SHARD_COUNT> lock_shards_;
+    std::atomic<IoBackend> io_backend_;
+    std::atomic<bool> sync_on_release_{false};
+    std::atomic<ChunkStore*> chunk_store_{nullptr};
+    std::atomic<uint64_t> next_lock_token_{1};
+#ifdef MINIDFS_URING_IO
+    std::mutex uring_mu_;
+    std::unique_ptr<UringEngine> uring_;
+#endif
 
 
     friend class MiniDFSSingleClientTest;
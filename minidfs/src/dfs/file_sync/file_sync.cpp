@@ -10,7 +10,8 @@ namespace minidfs {
     void FileSync::on_file_created(const std::string& path, bool is_dir) {
         try {
             std::cout << path << std::endl;
-            client_->StoreFile(path);
+            // a copy of something the server holds only sends what it lacks
+            client_->StoreFileDedup(path);
         } catch (const std::exception& error) {
             std::cerr << "Error in on_file_created: " << error.what() << std::endl;
             return;
@@ -27,9 +28,9 @@ namespace minidfs {
         
     }
     void FileSync::on_file_modified(const std::string& path, bool is_dir) {
-        //TODO: check actual modifications, compare crc, etc
         std::cout << "File modified: " << path << ", is_dir: " << is_dir << std::endl;
-        client_->StoreFile(path);
+        // only the changed blocks go over the wire
+        client_->StoreFileDelta(path);
     }
     void FileSync::on_file_renamed(const std::string& path, bool is_dir) {
         //TODO: handle rename properly
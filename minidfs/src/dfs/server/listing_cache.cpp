@@ -0,0 +1,84 @@
+#include "listing_cache.h"
+
+ListingCache::ListingCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+void ListingCache::SetMaxBytes(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    max_bytes_ = max_bytes;
+    EvictToFit();
+}
+
+std::shared_ptr<const minidfs::ListFilesRes> ListingCache::Get(const std::string& dir_key, int64_t dir_mtime_ns,
+    const std::function<bool(const minidfs::ListFilesRes&)>& is_current)
+{
+    std::shared_ptr<const minidfs::ListFilesRes> listing;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = index_.find(dir_key);
+        if (it == index_.end() || it->second->dir_mtime_ns != dir_mtime_ns) {
+            misses_++;
+            return nullptr;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        listing = it->second->listing;
+    }
+
+    // the caller refills it, and the fresh listing replaces this one
+    if (is_current && !is_current(*listing)) {
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    return listing;
+}
+
+void ListingCache::Put(const std::string& dir_key, int64_t dir_mtime_ns, uint64_t fill_generation,
+    std::shared_ptr<const minidfs::ListFilesRes> listing)
+{
+    // the message plus its key and bookkeeping, close enough for a budget
+    size_t bytes = listing->SpaceUsedLong() + dir_key.size() + sizeof(Entry);
+
+    std::lock_guard<std::mutex> lock(mu_);
+    if (generation_.load() != fill_generation || bytes > max_bytes_) return;
+
+    auto it = index_.find(dir_key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front(Entry{ dir_key, dir_mtime_ns, bytes, std::move(listing) });
+    index_[dir_key] = lru_.begin();
+    bytes_ += bytes;
+    EvictToFit();
+}
+
+void ListingCache::Invalidate(const std::string& dir_key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    // bumped even when nothing is cached, so an in-flight fill of this directory is discarded
+    generation_++;
+    auto it = index_.find(dir_key);
+    if (it == index_.end()) return;
+    bytes_ -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+}
+
+void ListingCache::EvictToFit() {
+    while (bytes_ > max_bytes_ && !lru_.empty()) {
+        bytes_ -= lru_.back().bytes;
+        index_.erase(lru_.back().dir_key);
+        lru_.pop_back();
+    }
+}
+
+size_t ListingCache::Bytes() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return bytes_;
+}
+
+size_t ListingCache::Entries() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return lru_.size();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "proto_src/minidfs.pb.h"
+
+#define LISTING_CACHE_MAX_BYTES (64 * 1024 * 1024)
+
+// Recent ListFiles responses keyed by virtual directory path, evicted least recently used
+// once their combined size passes a byte cap. The server drops entries whenever it changes
+// a directory itself; each entry also remembers its directory's mtime, so entries added or
+// removed behind the server's back are noticed too. Files edited in place leave that mtime
+// alone, so callers pass Get a check of every entry's size and mtime against the disk.
+// Safe to use from any thread.
+class ListingCache {
+public:
+    explicit ListingCache(size_t max_bytes = LISTING_CACHE_MAX_BYTES);
+
+    // A cap of 0 disables caching. Shrinking it evicts immediately.
+    void SetMaxBytes(size_t max_bytes);
+
+    // Returns nullptr unless there is an entry for dir_key taken at dir_mtime_ns that
+    // is_current (when given) accepts. is_current runs without the cache locked.
+    std::shared_ptr<const minidfs::ListFilesRes> Get(const std::string& dir_key, int64_t dir_mtime_ns,
+        const std::function<bool(const minidfs::ListFilesRes&)>& is_current = nullptr);
+
+    // Call before reading the directory and pass the result to Put, so a listing that raced
+    // with an invalidation is never stored.
+    uint64_t BeginFill() const { return generation_.load(); }
+
+    void Put(const std::string& dir_key, int64_t dir_mtime_ns, uint64_t fill_generation,
+        std::shared_ptr<const minidfs::ListFilesRes> listing);
+
+    void Invalidate(const std::string& dir_key);
+
+    size_t Bytes();
+    size_t Entries();
+    uint64_t Hits() const { return hits_.load(); }
+    uint64_t Misses() const { return misses_.load(); }
+
+private:
+    struct Entry {
+        std::string dir_key;
+        int64_t dir_mtime_ns;
+        size_t bytes;
+        std::shared_ptr<const minidfs::ListFilesRes> listing;
+    };
+
+    // Caller holds mu_.
+    void EvictToFit();
+
+    std::mutex mu_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    // front is most recently used
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
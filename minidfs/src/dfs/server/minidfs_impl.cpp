@@ -1,17 +1,40 @@
 
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <chrono>
+#include <algorithm>
+#include <optional>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 #include "minidfs_impl.h"
+#include "dfs/storage/crc32c.h"
 
 namespace fs = std::filesystem;
 
-MiniDFSImpl::MiniDFSImpl(const std::string& mount_path) {
-    file_manager_ = std::unique_ptr<FileManager>(new FileManager());
+MiniDFSImpl::MiniDFSImpl(const std::string& mount_path, IoBackend io_backend) {
+    chunk_store_ = std::unique_ptr<ChunkStore>(new ChunkStore(ChunkStore::RootFor(mount_path), mount_path));
+    file_manager_ = std::unique_ptr<FileManager>(new FileManager(io_backend));
     pubsub_manager_ = std::unique_ptr<PubSubManager>(new PubSubManager());
+    hash_cache_ = std::unique_ptr<HashCache>(new HashCache(HashCache::IndexPathFor(mount_path)));
+    listing_cache_ = std::unique_ptr<ListingCache>(new ListingCache());
+    upload_manager_ = std::unique_ptr<UploadManager>(new UploadManager(UploadManager::StateDirFor(mount_path)));
+    chunk_pool_ = std::unique_ptr<ChunkPool>(new ChunkPool());
+    size_t walk_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, WALK_TREE_MAX_THREADS);
+    walk_pool_ = std::unique_ptr<ThreadPool>(new ThreadPool(walk_threads));
     mount_path_ = mount_path;
     version_ = 0;
 }
 
+void MiniDFSImpl::SetChunkStore(bool enabled) {
+    if (enabled && chunk_store_->Enable()) {
+        file_manager_->SetChunkStore(chunk_store_.get());
+        return;
+    }
+    file_manager_->SetChunkStore(nullptr);
+    chunk_store_->Disable();
+}
+
 grpc::ServerUnaryReactor* MiniDFSImpl::ListFiles(
     grpc::CallbackServerContext* context,
     const minidfs::ListFilesReq* request,
@@ -22,54 +45,287 @@ grpc::ServerUnaryReactor* MiniDFSImpl::ListFiles(
         Reactor(MiniDFSImpl* service, const minidfs::ListFilesReq* req, minidfs::ListFilesRes* res) 
             : service_(service)
         {
-            try {
-                // VirtualPath will validate and strip mount prefix
-                fs::path virtual_path = FileManager::VirtualPath(service_->mount_path_, req->path());
-
-                // Now resolve back to full path
-                fs::path dir_path = FileManager::ResolvePath(service_->mount_path_, virtual_path.string());
-
-                std::cout << "Listing files in directory: " << dir_path.generic_string() << std::endl;
+            fs::path dir_path;
+            fs::path virtual_dir;
+            grpc::Status status = service_->ResolveListDirectory(req->path(), &dir_path, &virtual_dir);
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
 
-                if (!fs::exists(dir_path)) {
-                    Finish(grpc::Status(grpc::StatusCode::NOT_FOUND, "Directory not found"));
-                    return;
-                }
-                if (!fs::is_directory(dir_path)) {
-                    Finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Path is not a directory"));
+            std::string dir_key = virtual_dir.generic_string();
+            std::error_code ec;
+            int64_t dir_mtime = static_cast<int64_t>(fs::last_write_time(dir_path, ec).time_since_epoch().count());
+            if (!ec) {
+                auto is_current = [&dir_path](const minidfs::ListFilesRes& listing) {
+                    return ListingIsCurrent(dir_path, listing);
+                };
+                if (auto cached = service_->listing_cache_->Get(dir_key, dir_mtime, is_current)) {
+                    res->CopyFrom(*cached);
+                    Finish(grpc::Status::OK);
                     return;
                 }
+            }
+            uint64_t generation = service_->listing_cache_->BeginFill();
 
-                for (const auto& entry : fs::directory_iterator(dir_path)) {
-                    //REMEMBER: add back VIRTUAL paths only, not local entry.path()
-                    minidfs::FileInfo* file_info = res->add_files();
-                    file_info->set_file_path(FileManager::VirtualPath(service_->mount_path_, entry.path().generic_string()).generic_string());
-                    file_info->set_is_dir(entry.is_directory());
-                    if (!entry.is_directory()) {
-                        file_info->set_hash(FileManager::GetFileHash(entry.path().generic_string()));
-                    }
-                }
+            std::vector<DirEntryInfo> entries;
+            if (!ScanDirectory(dir_path.generic_string(), &entries)) {
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to read directory"));
+                return;
+            }
+
+            res->mutable_files()->Reserve(static_cast<int>(entries.size()));
+            for (const DirEntryInfo& entry : entries) {
+                service_->FillFileInfo(dir_path, virtual_dir, entry, res->add_files());
+            }
+            if (!ec) {
+                service_->listing_cache_->Put(dir_key, dir_mtime, generation, std::make_shared<minidfs::ListFilesRes>(*res));
+            }
+            Finish(grpc::Status::OK);
+        }
+        void OnDone() override {
+            delete this;
+        }
+    private:
+        MiniDFSImpl* service_;
+    };
+
+    return new Reactor(this, request, response);
+}
+
+grpc::ServerWriteReactor<minidfs::ListFilesRes>* MiniDFSImpl::ListFilesStream(
+    grpc::CallbackServerContext* context,
+    const minidfs::ListFilesReq* request)
+{
+    class Reactor : public grpc::ServerWriteReactor<minidfs::ListFilesRes> {
+    public:
+        Reactor(MiniDFSImpl* service, const minidfs::ListFilesReq* req)
+            : service_(service)
+        {
+            page_size_ = req->page_size() == 0 ? LIST_FILES_PAGE_SIZE : std::min<size_t>(req->page_size(), LIST_FILES_MAX_PAGE_SIZE);
+
+            grpc::Status status = service_->ResolveListDirectory(req->path(), &dir_path_, &virtual_dir_);
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
+
+            scanner_ = std::make_unique<DirScanner>(dir_path_.generic_string());
+            NextPage();
+        }
+
+        void OnWriteDone(bool ok) override {
+            if (!ok) {
+                Finish(grpc::Status::OK);
+                return;
+            }
+            NextPage();
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+
+    private:
+        // Only one page of entries is ever held; the next is read once this one is sent.
+        void NextPage() {
+            entries_.clear();
+            page_.Clear();
+            scanner_->Next(&entries_, page_size_);
+            if (scanner_->Failed()) {
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to read directory"));
+                return;
+            }
+            // an empty directory still gets one (empty) page, so clients always see a response
+            if (entries_.empty() && sent_any_) {
                 Finish(grpc::Status::OK);
+                return;
+            }
 
+            for (const DirEntryInfo& entry : entries_) {
+                service_->FillFileInfo(dir_path_, virtual_dir_, entry, page_.add_files());
             }
-            catch (const std::invalid_argument& e) {
-                Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what()));
+            sent_any_ = true;
+            StartWrite(&page_);
+        }
+
+        MiniDFSImpl* service_;
+        size_t page_size_;
+        fs::path dir_path_;
+        fs::path virtual_dir_;
+        std::unique_ptr<DirScanner> scanner_;
+        std::vector<DirEntryInfo> entries_;
+        minidfs::ListFilesRes page_;
+        bool sent_any_ = false;
+    };
+
+    return new Reactor(this, request);
+}
+
+grpc::ServerWriteReactor<minidfs::ListFilesRes>* MiniDFSImpl::WalkTree(
+    grpc::CallbackServerContext* context,
+    const minidfs::WalkTreeReq* request)
+{
+    class Reactor : public grpc::ServerWriteReactor<minidfs::ListFilesRes> {
+    public:
+        Reactor(MiniDFSImpl* service, const minidfs::WalkTreeReq* req)
+            : service_(service)
+        {
+            page_size_ = req->page_size() == 0 ? LIST_FILES_PAGE_SIZE : std::min<size_t>(req->page_size(), LIST_FILES_MAX_PAGE_SIZE);
+
+            fs::path dir_path;
+            fs::path virtual_dir;
+            grpc::Status status = service_->ResolveListDirectory(req->path(), &dir_path, &virtual_dir);
+            if (!status.ok()) {
+                Finish(status);
                 return;
             }
-            catch (const std::exception& e) {
-                Finish(grpc::Status(grpc::StatusCode::INTERNAL, e.what()));
+
+            TreeWalkOptions options;
+            options.max_depth = req->max_depth();
+            options.name_glob = req->name_glob();
+            options.modified_since = req->modified_since();
+
+            // a few pages in flight keep the pool busy while the current page is on the wire
+            walk_ = TreeWalk::Start(service_->walk_pool_.get(), dir_path, virtual_dir, options, 4 * page_size_,
+                [service](const fs::path& dir, const fs::path& vdir, const DirEntryInfo& entry, minidfs::FileInfo* info) {
+                    service->FillFileInfo(dir, vdir, entry, info);
+                },
+                [this] { NextPage(); });
+            NextPage();
+        }
+
+        void OnWriteDone(bool ok) override {
+            if (!ok) {
+                walk_->Cancel();
+                Finish(grpc::Status::OK);
                 return;
             }
-            
+            NextPage();
+        }
+
+        void OnCancel() override {
+            if (walk_) walk_->Cancel();
         }
+
         void OnDone() override {
+            if (walk_) walk_->Cancel();
             delete this;
         }
+
     private:
+        // Runs on a gRPC thread or, when the walk had nothing ready, on a pool thread.
+        void NextPage() {
+            std::vector<minidfs::FileInfo> batch;
+            bool done = false;
+            if (!walk_->TakeBatch(&batch, page_size_, &done)) return;
+
+            if (batch.empty() && done) {
+                if (walk_->Failed()) {
+                    Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to read directory"));
+                } else if (!sent_any_) {
+                    // an empty tree still gets one (empty) page, like ListFilesStream
+                    sent_any_ = true;
+                    page_.Clear();
+                    StartWrite(&page_);
+                } else {
+                    Finish(grpc::Status::OK);
+                }
+                return;
+            }
+
+            page_.Clear();
+            page_.mutable_files()->Reserve(static_cast<int>(batch.size()));
+            for (auto& info : batch) {
+                *page_.add_files() = std::move(info);
+            }
+            sent_any_ = true;
+            StartWrite(&page_);
+        }
+
         MiniDFSImpl* service_;
+        size_t page_size_;
+        std::shared_ptr<TreeWalk> walk_;
+        minidfs::ListFilesRes page_;
+        bool sent_any_ = false;
     };
 
-    return new Reactor(this, request, response);
+    return new Reactor(this, request);
+}
+
+grpc::Status MiniDFSImpl::ResolveListDirectory(const std::string& request_path, fs::path* dir_path, fs::path* virtual_dir) {
+    try {
+        // VirtualPath will validate and strip mount prefix
+        fs::path virtual_path = FileManager::VirtualPath(mount_path_, request_path);
+
+        // Now resolve back to full path
+        *dir_path = FileManager::ResolvePath(mount_path_, virtual_path.string());
+
+        std::cout << "Listing files in directory: " << dir_path->generic_string() << std::endl;
+
+        if (!fs::exists(*dir_path)) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Directory not found");
+        }
+        if (!fs::is_directory(*dir_path)) {
+            return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Path is not a directory");
+        }
+
+        //REMEMBER: add back VIRTUAL paths only, not local entry paths
+        *virtual_dir = FileManager::VirtualPath(mount_path_, dir_path->generic_string());
+        return grpc::Status::OK;
+    }
+    catch (const std::invalid_argument& e) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+    }
+    catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, e.what());
+    }
+}
+
+void MiniDFSImpl::InvalidateListings(const fs::path& local_file_path) {
+    fs::path virtual_path;
+    try {
+        virtual_path = FileManager::VirtualPath(mount_path_, local_file_path.generic_string());
+    }
+    catch (const std::exception&) {
+        return;
+    }
+
+    // the mount root itself is keyed by the empty path
+    fs::path dir = virtual_path.parent_path();
+    while (true) {
+        listing_cache_->Invalidate(dir.generic_string());
+        if (dir.empty()) break;
+        dir = dir.parent_path();
+    }
+}
+
+bool MiniDFSImpl::ListingIsCurrent(const fs::path& dir_path, const minidfs::ListFilesRes& listing) {
+    for (const minidfs::FileInfo& file : listing.files()) {
+        DirEntryInfo entry;
+        std::string local_path = (dir_path / fs::path(file.file_path()).filename()).generic_string();
+        if (!StatEntry(local_path, &entry) || entry.is_dir != file.is_dir()
+            || entry.size != file.size() || entry.mtime_ns != file.mtime()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MiniDFSImpl::FillFileInfo(const fs::path& dir_path, const fs::path& virtual_dir, const DirEntryInfo& entry, minidfs::FileInfo* file_info) {
+    file_info->set_file_path((virtual_dir / entry.name).generic_string());
+    file_info->set_is_dir(entry.is_dir);
+    file_info->set_size(entry.size);
+    file_info->set_mtime(entry.mtime_ns);
+    if (entry.is_dir) return;
+
+    std::string local_path = (dir_path / entry.name).generic_string();
+    if (entry.ino != 0) {
+        HashCacheKey key{ entry.dev, entry.ino, entry.size, entry.mtime_ns };
+        file_info->set_hash(hash_cache_->GetFileHash(local_path, key));
+    } else {
+        file_info->set_hash(hash_cache_->GetFileHash(local_path));
+    }
 }
 
 grpc::ServerUnaryReactor* MiniDFSImpl::GetFileLock(
@@ -79,27 +335,22 @@ grpc::ServerUnaryReactor* MiniDFSImpl::GetFileLock(
 {
     class Reactor final : public grpc::ServerUnaryReactor {
     public:
-        Reactor(MiniDFSImpl* service, const minidfs::FileLockReq* req, minidfs::FileLockRes* res) 
-            : service_(service)
+        Reactor(MiniDFSImpl* service, grpc::CallbackServerContext* ctx, const minidfs::FileLockReq* req, minidfs::FileLockRes* res) 
+            : service_(service), res_(res)
         {
-            bool ok = false;
             file_path_ = FileManager::ResolvePath(service_->mount_path_, req->file_path());
             client_id_ = req->client_id();
-            
-            if (req->op() == minidfs::FileOpType::READ) {
-                ok = service_->file_manager_->AcquireReadLock(client_id_, file_path_.generic_string());
-            } else if (req->op() == minidfs::FileOpType::WRITE) {
-                ok = service_->file_manager_->AcquireWriteLock(client_id_, file_path_.generic_string(), true);
-            } else if (req->op() == minidfs::FileOpType::DEL) {
-				ok = service_->file_manager_->AcquireWriteLock(client_id_, file_path_.generic_string(), false);
-            }
-            
-            if (ok) {
-                res->set_success(true);
-                Finish(grpc::Status::OK);
-            } else {
-                res->set_success(false);
-                Finish(grpc::Status(grpc::StatusCode::ABORTED, "File is locked by another client"));
+
+            waiter_ = service_->RequestFileLock(ctx, &alarm_, client_id_, file_path_.generic_string(), req->op(),
+                [this](const grpc::Status& status) {
+                    res_->set_success(status.ok());
+                    Finish(status);
+                }, req->lock_token());
+        }
+
+        void OnCancel() override {
+            if (waiter_ && service_->file_manager_->CancelLockWaiter(file_path_.generic_string(), waiter_)) {
+                Finish(grpc::Status::CANCELLED);
             }
         }
 
@@ -109,11 +360,56 @@ grpc::ServerUnaryReactor* MiniDFSImpl::GetFileLock(
 
     private:
         MiniDFSImpl* service_;
+        minidfs::FileLockRes* res_;
         fs::path file_path_;
         std::string client_id_;
+        std::shared_ptr<LockWaiter> waiter_;
+        grpc::Alarm alarm_;
     };
 
-    return new Reactor(this, request, response);
+    return new Reactor(this, context, request, response);
+}
+
+std::shared_ptr<LockWaiter> MiniDFSImpl::RequestFileLock(
+    grpc::CallbackServerContext* context,
+    grpc::Alarm* alarm,
+    const std::string& client_id,
+    const std::string& file_path,
+    minidfs::FileOpType op,
+    std::function<void(const grpc::Status&)> on_locked,
+    uint64_t lock_token)
+{
+    auto on_complete = [on_locked](bool ok) {
+        if (ok) {
+            on_locked(grpc::Status::OK);
+        } else {
+            on_locked(grpc::Status(grpc::StatusCode::ABORTED, "File is locked by another client"));
+        }
+    };
+
+    std::shared_ptr<LockWaiter> waiter;
+    if (op == minidfs::FileOpType::READ) {
+        waiter = file_manager_->AcquireReadLockAsync(client_id, file_path, on_complete, lock_token);
+    } else if (op == minidfs::FileOpType::WRITE) {
+        waiter = file_manager_->AcquireWriteLockAsync(client_id, file_path, true, on_complete);
+    } else if (op == minidfs::FileOpType::DEL) {
+        waiter = file_manager_->AcquireWriteLockAsync(client_id, file_path, false, on_complete);
+    } else {
+        on_complete(false);
+    }
+
+    if (!waiter) return nullptr;
+
+    // Queued behind another holder: no thread waits, the alarm only bounds how long we stay queued.
+    auto deadline = std::min(context->deadline(),
+        std::chrono::system_clock::now() + std::chrono::milliseconds(LOCK_WAIT_TIMEOUT_MS));
+    FileManager* fm = file_manager_.get();
+    alarm->Set(deadline, [fm, file_path, waiter, on_locked](bool fired) {
+        if (fired && fm->CancelLockWaiter(file_path, waiter)) {
+            on_locked(grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED, "Timed out waiting for file lock"));
+        }
+    });
+    return waiter;
 }
 
 
@@ -133,6 +429,8 @@ grpc::ServerUnaryReactor* MiniDFSImpl::RemoveFile(
             file_path_ = FileManager::ResolvePath(service_->mount_path_, req_->file_path());
 
             FileStatus status = service_->file_manager_->RemoveFile(req->client_id(), file_path_.generic_string());
+            // before Finish, so the caller's next ListFiles already reflects the removal
+            service_->InvalidateListings(file_path_);
 
             switch (status) {
                 case FileStatus::FILE_LOCKED:
@@ -181,133 +479,1153 @@ grpc::ServerReadReactor<minidfs::FileBuffer>* MiniDFSImpl::StoreFile(
     grpc::CallbackServerContext* context,
     minidfs::StoreFileRes* response)
 {
+    // Chunks are staged in a private file and only moved over the target once the stream
+    // ends cleanly, so an aborted upload never tears or truncates the previous version.
     class Reactor : public grpc::ServerReadReactor<minidfs::FileBuffer> {
     public:
-        Reactor(MiniDFSImpl* service, minidfs::StoreFileRes* res)
-            : service_(service), response_(res), offset_(0)
+        Reactor(MiniDFSImpl* service, grpc::CallbackServerContext* ctx, minidfs::StoreFileRes* res)
+            : service_(service), context_(ctx), response_(res), current_(service->chunk_pool_->Acquire()), offset_(0)
         {
-            StartRead(&current_);
+            StartRead(current_.get());
         }
 
         void OnReadDone(bool ok) override {
             if (!ok) {
-                response_->set_success(true);
-                response_->set_msg("File stored successfully");
-                service_->file_manager_->ReleaseWriteLock(client_id_, file_path_.generic_string());
-                service_->IncrementVersion();
-                service_->pubsub_manager_->Publish(client_id_, file_path_.generic_string(), minidfs::FileUpdateType::MODIFIED);
-                
-                Finish(grpc::Status::OK);
+                ReleaseStaging();
+                if (context_->IsCancelled()) {
+                    Finish(grpc::Status::CANCELLED);
+                    return;
+                }
+                if (staging_path_.empty()) {
+                    response_->set_success(true);
+                    response_->set_msg("File stored successfully");
+                    Finish(grpc::Status::OK);
+                    return;
+                }
+                if (lock_held_) {
+                    Commit();
+                    return;
+                }
+                // inline locking waits for the target only now, so reads go on during the upload;
+                // DEL locks without creating the target, which the commit is about to replace
+                auto waiter = service_->RequestFileLock(context_, &alarm_, client_id_, file_path_.generic_string(),
+                    minidfs::FileOpType::DEL, [this](const grpc::Status& status) { OnLocked(status); });
+                std::lock_guard<std::mutex> lock(waiter_mu_);
+                waiter_ = std::move(waiter);
                 return;
             }
             
-            if (file_path_.empty()) {
-                file_path_ = FileManager::ResolvePath(
-                    service_->mount_path_, current_.file_path());
-                client_id_ = current_.client_id();
+            if (staging_path_.empty()) {
+                // version 0 streams name the file on every chunk; only the first is looked at
+                if (current_->has_header()) {
+                    const minidfs::StreamHeader& header = current_->header();
+                    if (header.version() > FILE_STREAM_VERSION) {
+                        Finish(grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "Unsupported stream format version"));
+                        return;
+                    }
+                    file_path_ = FileManager::ResolvePath(service_->mount_path_, header.file_path());
+                    client_id_ = header.client_id();
+                    lock_held_ = !header.acquire_lock();
+                } else {
+                    file_path_ = FileManager::ResolvePath(
+                        service_->mount_path_, current_->file_path());
+                    client_id_ = current_->client_id();
+                    // legacy clients already took the write lock through GetFileLock
+                    lock_held_ = !current_->acquire_lock();
+                }
+
+                staging_path_ = service_->upload_manager_->NewStagingPath();
+                // uncontended: nobody else knows this path
+                if (!service_->file_manager_->AcquireWriteLock(client_id_, staging_path_, true)) {
+                    staging_path_.clear();
+                    Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to stage upload"));
+                    return;
+                }
+                staging_locked_ = true;
             }
 
-            const char* data = static_cast<const char*>(current_.data().data());
-            size_t data_size = current_.data().size();
+            WriteCurrent();
+        }
 
-            bool write_ok = service_->file_manager_->WriteFile(
-                current_.client_id(), file_path_.generic_string(), 
-                offset_, data, data_size);
-            if (!write_ok) {
-                Finish(grpc::Status(grpc::StatusCode::DATA_LOSS, "Write failed"));
-                return;
+        void OnCancel() override {
+            // may race with the stream end that queued the lock request
+            std::shared_ptr<LockWaiter> waiter;
+            {
+                std::lock_guard<std::mutex> lock(waiter_mu_);
+                waiter = waiter_;
+            }
+            if (waiter && service_->file_manager_->CancelLockWaiter(file_path_.generic_string(), waiter)) {
+                Finish(grpc::Status::CANCELLED);
             }
-            offset_ += data_size;
-            StartRead(&current_);
-        }   
+        }
 
         void OnDone() override {
+            ReleaseStaging();
+            ReleaseLock();
+            if (!staging_path_.empty()) {
+                std::error_code ec;
+                fs::remove(staging_path_, ec);
+            }
             delete this;
         }
 
     private:
+        void OnLocked(const grpc::Status& status) {
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
+            lock_held_ = true;
+            Commit();
+        }
+
+        void WriteCurrent() {
+            grpc::Status unpacked = UnpackChunk(current_.get(), service_->GetMaxChunkSize(), &scratch_, &service_->codec_counters_);
+            if (!unpacked.ok()) {
+                Finish(unpacked);
+                return;
+            }
+            const char* data = static_cast<const char*>(current_->data().data());
+            size_t data_size = current_->data().size();
+            if (data_size == 0) {
+                // a header, or an empty file's only chunk
+                StartRead(current_.get());
+                return;
+            }
+
+            // current_ is left untouched until the write completes and the next read is started
+            service_->file_manager_->WriteFileAsync(
+                client_id_, staging_path_,
+                offset_, data, data_size, [this, data_size](bool write_ok) {
+                    if (!write_ok) {
+                        Finish(grpc::Status(grpc::StatusCode::DATA_LOSS, "Write failed"));
+                        return;
+                    }
+                    hash_.Update(current_->data().data(), data_size);
+                    service_->chunk_pool_->CountBytes(data_size);
+                    offset_ += data_size;
+                    StartRead(current_.get());
+                });
+        }
+
+        // Under the target's write lock. The staged file holds exactly the streamed bytes, so
+        // the streamed digest is recorded before the rename carries it over.
+        void Commit() {
+            SaveStoredHash(staging_path_, hash_.Final());
+            bool replaced = service_->file_manager_->ReplaceFile(client_id_, file_path_.generic_string(), staging_path_);
+            ReleaseLock();
+            if (!replaced) {
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to commit upload"));
+                return;
+            }
+            staging_path_.clear();
+
+            response_->set_success(true);
+            response_->set_msg("File stored successfully");
+            service_->IncrementVersion();
+            service_->pubsub_manager_->Publish(client_id_, file_path_.generic_string(), minidfs::FileUpdateType::MODIFIED);
+            Finish(grpc::Status::OK);
+        }
+
+        void ReleaseStaging() {
+            if (!staging_locked_) return;
+            staging_locked_ = false;
+            service_->file_manager_->ReleaseWriteLock(client_id_, staging_path_);
+        }
+
+        // A legacy GetFileLock may have created the target, so listings are invalidated on
+        // every release rather than only after a commit.
+        void ReleaseLock() {
+            if (!lock_held_) return;
+            lock_held_ = false;
+            service_->file_manager_->ReleaseWriteLock(client_id_, file_path_.generic_string());
+            service_->InvalidateListings(file_path_);
+        }
+
         MiniDFSImpl* service_;
+        grpc::CallbackServerContext* context_;
         minidfs::StoreFileRes* response_;
-        minidfs::FileBuffer current_;
+        ChunkPool::Chunk current_;
+        // decompression target; swapped with the chunk's payload, so both keep their capacity
+        std::string scratch_;
         uint64_t offset_;
+        IncrementalHash hash_;
         fs::path file_path_;
         std::string client_id_;
+        std::string staging_path_;
+        bool staging_locked_ = false;
+        bool lock_held_ = false;
+        std::mutex waiter_mu_;
+        std::shared_ptr<LockWaiter> waiter_;
+        grpc::Alarm alarm_;
     };
     
+    return new Reactor(this, context, response);
+}
+
+grpc::ServerUnaryReactor* MiniDFSImpl::GetFileSignature(
+    grpc::CallbackServerContext* context,
+    const minidfs::FileSignatureReq* request,
+    minidfs::FileSignature* response)
+{
+    // Read straight from the file, like GetFileHash: uploads replace files by rename, so an
+    // open handle always sees one whole version.
+    class Reactor final : public grpc::ServerUnaryReactor {
+    public:
+        Reactor(MiniDFSImpl* service, const minidfs::FileSignatureReq* req, minidfs::FileSignature* res) {
+            fs::path file_path = FileManager::ResolvePath(service->mount_path_, req->file_path());
+            std::error_code ec;
+            std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+            if (!fs::is_regular_file(file_path, ec) || !file) {
+                Finish(grpc::Status(grpc::StatusCode::NOT_FOUND, "File not found"));
+                return;
+            }
+            uint64_t size = static_cast<uint64_t>(file.tellg());
+            file.seekg(0);
+
+            size_t block_size = DeltaBlockSize(size);
+            if ((size + block_size - 1) / block_size > DELTA_MAX_BLOCKS) {
+                Finish(grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "File too large to sign"));
+                return;
+            }
+            if (!ComputeSignature(file, size, res)) {
+                res->Clear();
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to read file"));
+                return;
+            }
+            Finish(grpc::Status::OK);
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+    };
+
+    return new Reactor(this, request, response);
+}
+
+grpc::ServerUnaryReactor* MiniDFSImpl::FindChunks(
+    grpc::CallbackServerContext* context,
+    const minidfs::FindChunksReq* request,
+    minidfs::FindChunksRes* response)
+{
+    class Reactor final : public grpc::ServerUnaryReactor {
+    public:
+        Reactor(MiniDFSImpl* service, const minidfs::FindChunksReq* req, minidfs::FindChunksRes* res) {
+            if (!service->chunk_store_->Enabled()) {
+                Finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Chunk store is disabled"));
+                return;
+            }
+            for (int i = 0; i < req->hashes_size(); i++) {
+                if (!service->chunk_store_->Has(req->hashes(i))) {
+                    res->add_missing(static_cast<uint32_t>(i));
+                }
+            }
+            Finish(grpc::Status::OK);
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+    };
+
+    return new Reactor(this, request, response);
+}
+
+grpc::ServerReadReactor<minidfs::DeltaChunk>* MiniDFSImpl::StoreFileDelta(
+    grpc::CallbackServerContext* context,
+    minidfs::StoreFileRes* response)
+{
+    // The new version is rebuilt in a staging file from literal bytes, blocks copied out of
+    // the current one (which stays read-locked meanwhile) and chunks from the chunk store. It
+    // is committed like StoreFile, by a rename under the write lock, and only if it hashes to
+    // what the client sent.
+    class Reactor : public grpc::ServerReadReactor<minidfs::DeltaChunk> {
+    public:
+        Reactor(MiniDFSImpl* service, grpc::CallbackServerContext* ctx, minidfs::StoreFileRes* res)
+            : service_(service), context_(ctx), response_(res)
+        {
+            StartRead(&chunk_);
+        }
+
+        void OnReadDone(bool ok) override {
+            if (!ok) {
+                Rebuilt();
+                return;
+            }
+            if (staging_path_.empty()) {
+                Begin();
+                return;
+            }
+            ApplyCurrent();
+        }
+
+        void OnCancel() override {
+            std::shared_ptr<LockWaiter> waiter;
+            {
+                std::lock_guard<std::mutex> lock(waiter_mu_);
+                waiter = waiter_;
+            }
+            if (waiter && service_->file_manager_->CancelLockWaiter(file_path_.generic_string(), waiter)) {
+                Finish(grpc::Status::CANCELLED);
+            }
+        }
+
+        void OnDone() override {
+            ReleaseStaging();
+            ReleaseBase();
+            ReleaseLock();
+            if (!staging_path_.empty()) {
+                std::error_code ec;
+                fs::remove(staging_path_, ec);
+            }
+            delete this;
+        }
+
+    private:
+        void Begin() {
+            const minidfs::DeltaHeader& header = chunk_.header();
+            if (!chunk_.has_header() || header.file_path().empty() || (header.block_size() == 0 && header.base_size() > 0)) {
+                Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Delta stream must start with a header"));
+                return;
+            }
+            file_path_ = FileManager::ResolvePath(service_->mount_path_, header.file_path());
+            client_id_ = header.client_id();
+            block_size_ = header.block_size();
+            base_size_ = header.base_size();
+
+            staging_path_ = service_->upload_manager_->NewStagingPath();
+            if (!service_->file_manager_->AcquireWriteLock(client_id_, staging_path_, true)) {
+                staging_path_.clear();
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to stage upload"));
+                return;
+            }
+            staging_locked_ = true;
+
+            // without a signature there is nothing to copy from, and no need to lock it
+            if (block_size_ == 0) {
+                ApplyCurrent();
+                return;
+            }
+            auto waiter = service_->RequestFileLock(context_, &base_alarm_, client_id_, file_path_.generic_string(),
+                minidfs::FileOpType::READ, [this](const grpc::Status& status) { OnBaseLocked(status); });
+            std::lock_guard<std::mutex> lock(waiter_mu_);
+            waiter_ = std::move(waiter);
+        }
+
+        void OnBaseLocked(const grpc::Status& status) {
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
+            base_locked_ = true;
+            std::error_code ec;
+            uint64_t size = fs::file_size(file_path_, ec);
+            if (ec || size != base_size_) {
+                Finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "File changed since its signature was taken"));
+                return;
+            }
+            // without a mapping, copies are read through the session instead
+            base_ = service_->file_manager_->MapFile(client_id_, file_path_.generic_string());
+            ApplyCurrent();
+        }
+
+        // Rebuilds this message's bytes in out_ and appends them to the staged file.
+        void ApplyCurrent() {
+            if (!chunk_.file_hash().empty()) {
+                file_hash_ = chunk_.file_hash();
+            }
+
+            out_.clear();
+            const uint64_t base_blocks = block_size_ ? (base_size_ + block_size_ - 1) / block_size_ : 0;
+            for (const minidfs::DeltaOp& op : chunk_.ops()) {
+                uint64_t begin = 0;
+                uint64_t size = op.literal().size();
+                if (!op.chunk().empty()) {
+                    size = op.chunk_size();
+                } else if (op.blocks() > 0) {
+                    if (op.block() >= base_blocks || op.blocks() > base_blocks - op.block()) {
+                        Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Delta refers past the end of the file"));
+                        return;
+                    }
+                    begin = op.block() * block_size_;
+                    size = std::min(base_size_, (op.block() + op.blocks()) * block_size_) - begin;
+                }
+                if (out_.size() + size > DELTA_MAX_MESSAGE_OUTPUT) {
+                    Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Delta message rebuilds too much data"));
+                    return;
+                }
+
+                if (!op.chunk().empty()) {
+                    // the chunk store may have dropped it since FindChunks; the client then resends whole
+                    if (!service_->chunk_store_->Get(op.chunk(), &stored_chunk_) || stored_chunk_.size() != size) {
+                        Finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Chunk is not stored"));
+                        return;
+                    }
+                    out_.append(stored_chunk_);
+                    reused_bytes_ += size;
+                    continue;
+                }
+                if (op.blocks() == 0) {
+                    out_.append(op.literal());
+                    continue;
+                }
+                size_t at = out_.size();
+                out_.resize(at + size);
+                if (base_ && begin + size <= base_->Size()) {
+                    std::memcpy(out_.data() + at, base_->Data() + begin, size);
+                    continue;
+                }
+                size_t bytes_read = 0;
+                if (!service_->file_manager_->ReadFile(client_id_, file_path_.generic_string(), begin, out_.data() + at, &bytes_read, size)
+                    || bytes_read != size) {
+                    Finish(grpc::Status(grpc::StatusCode::DATA_LOSS, "Failed to read file"));
+                    return;
+                }
+            }
+
+            if (out_.empty()) {
+                StartRead(&chunk_);
+                return;
+            }
+            service_->file_manager_->WriteFileAsync(
+                client_id_, staging_path_, offset_, out_.data(), out_.size(), [this](bool write_ok) {
+                    if (!write_ok) {
+                        Finish(grpc::Status(grpc::StatusCode::DATA_LOSS, "Write failed"));
+                        return;
+                    }
+                    hash_.Update(out_.data(), out_.size());
+                    offset_ += out_.size();
+                    StartRead(&chunk_);
+                });
+        }
+
+        void Rebuilt() {
+            ReleaseStaging();
+            ReleaseBase();
+            if (context_->IsCancelled()) {
+                Finish(grpc::Status::CANCELLED);
+                return;
+            }
+            if (staging_path_.empty()) {
+                Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Delta stream must start with a header"));
+                return;
+            }
+            // a signature taken from another version than the one copied from lands here too
+            if (file_hash_.empty() || hash_.Final() != file_hash_) {
+                Finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Delta does not reproduce the file"));
+                return;
+            }
+
+            auto waiter = service_->RequestFileLock(context_, &alarm_, client_id_, file_path_.generic_string(),
+                minidfs::FileOpType::DEL, [this](const grpc::Status& status) { OnLocked(status); });
+            std::lock_guard<std::mutex> lock(waiter_mu_);
+            waiter_ = std::move(waiter);
+        }
+
+        void OnLocked(const grpc::Status& status) {
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
+            lock_held_ = true;
+
+            SaveStoredHash(staging_path_, file_hash_);
+            bool replaced = service_->file_manager_->ReplaceFile(client_id_, file_path_.generic_string(), staging_path_);
+            ReleaseLock();
+            if (!replaced) {
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to commit upload"));
+                return;
+            }
+            staging_path_.clear();
+            service_->chunk_store_->CountReused(reused_bytes_);
+
+            response_->set_success(true);
+            response_->set_msg("File stored successfully");
+            service_->IncrementVersion();
+            service_->pubsub_manager_->Publish(client_id_, file_path_.generic_string(), minidfs::FileUpdateType::MODIFIED);
+            Finish(grpc::Status::OK);
+        }
+
+        void ReleaseStaging() {
+            if (!staging_locked_) return;
+            staging_locked_ = false;
+            service_->file_manager_->ReleaseWriteLock(client_id_, staging_path_);
+        }
+
+        void ReleaseBase() {
+            if (!base_locked_) return;
+            base_locked_ = false;
+            base_.reset();
+            service_->file_manager_->ReleaseReadLock(client_id_, file_path_.generic_string());
+        }
+
+        void ReleaseLock() {
+            if (!lock_held_) return;
+            lock_held_ = false;
+            service_->file_manager_->ReleaseWriteLock(client_id_, file_path_.generic_string());
+            service_->InvalidateListings(file_path_);
+        }
+
+        MiniDFSImpl* service_;
+        grpc::CallbackServerContext* context_;
+        minidfs::StoreFileRes* response_;
+        minidfs::DeltaChunk chunk_;
+        std::string out_;
+        std::string stored_chunk_;
+        uint64_t reused_bytes_ = 0;
+        uint64_t offset_ = 0;
+        IncrementalHash hash_;
+        std::string file_hash_;
+        fs::path file_path_;
+        std::string client_id_;
+        uint64_t block_size_ = 0;
+        uint64_t base_size_ = 0;
+        std::shared_ptr<const MappedFile> base_;
+        std::string staging_path_;
+        bool staging_locked_ = false;
+        bool base_locked_ = false;
+        bool lock_held_ = false;
+        std::mutex waiter_mu_;
+        std::shared_ptr<LockWaiter> waiter_;
+        // one per lock wait; the read lock's alarm may still be pending when the write lock is queued
+        grpc::Alarm base_alarm_;
+        grpc::Alarm alarm_;
+    };
+
+    return new Reactor(this, context, response);
+}
+
+static void FillUploadStatus(UploadManager& uploads, const std::shared_ptr<UploadSession>& session, size_t max_chunk_size, minidfs::UploadStatus* status) {
+    status->set_upload_id(session->id);
+    status->set_size(session->size);
+    status->set_committed(uploads.Committed(session));
+    status->set_stripe_size(session->stripe_size);
+    status->set_max_chunk_size(static_cast<uint32_t>(max_chunk_size));
+    for (uint32_t stripe = 0; stripe < session->stripes; stripe++) {
+        status->add_stripe_committed(uploads.StripeCommitted(session, stripe));
+    }
+}
+
+grpc::ServerUnaryReactor* MiniDFSImpl::StartUpload(
+    grpc::CallbackServerContext* context,
+    const minidfs::StartUploadReq* request,
+    minidfs::UploadStatus* response)
+{
+    class Reactor final : public grpc::ServerUnaryReactor {
+    public:
+        Reactor(MiniDFSImpl* service, const minidfs::StartUploadReq* req, minidfs::UploadStatus* res) {
+            if (req->file_path().empty()) {
+                Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Missing file path"));
+                return;
+            }
+
+            auto session = service->upload_manager_->Start(req->client_id(), req->file_path(), req->size(), req->source_version(), req->stripes());
+            if (!session) {
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to start upload"));
+                return;
+            }
+            FillUploadStatus(*service->upload_manager_, session, service->GetMaxChunkSize(), res);
+            Finish(grpc::Status::OK);
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+    };
+
+    return new Reactor(this, request, response);
+}
+
+grpc::ServerUnaryReactor* MiniDFSImpl::GetUploadStatus(
+    grpc::CallbackServerContext* context,
+    const minidfs::UploadStatusReq* request,
+    minidfs::UploadStatus* response)
+{
+    class Reactor final : public grpc::ServerUnaryReactor {
+    public:
+        Reactor(MiniDFSImpl* service, const minidfs::UploadStatusReq* req, minidfs::UploadStatus* res) {
+            auto session = service->upload_manager_->Find(req->upload_id());
+            if (!session) {
+                // never started, or already committed
+                Finish(grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown upload id"));
+                return;
+            }
+            FillUploadStatus(*service->upload_manager_, session, service->GetMaxChunkSize(), res);
+            Finish(grpc::Status::OK);
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+    };
+
+    return new Reactor(this, request, response);
+}
+
+grpc::ServerUnaryReactor* MiniDFSImpl::GetServerInfo(
+    grpc::CallbackServerContext* context,
+    const minidfs::ServerInfoReq* /*request*/,
+    minidfs::ServerInfo* response)
+{
+    class Reactor final : public grpc::ServerUnaryReactor {
+    public:
+        Reactor(MiniDFSImpl* service, minidfs::ServerInfo* res) {
+            for (minidfs::Codec codec : SupportedCodecs()) {
+                res->add_codecs(codec);
+            }
+            res->set_max_chunk_size(static_cast<uint32_t>(service->GetMaxChunkSize()));
+            if (service->chunk_store_->Enabled()) {
+                ChunkStoreStats stats = service->chunk_store_->Stats();
+                res->set_chunk_store(true);
+                res->set_logical_bytes(stats.logical_bytes);
+                res->set_unique_bytes(stats.unique_bytes);
+                res->set_potential_dedup_ratio(stats.PotentialRatio());
+            }
+            ChunkPoolStats pool = service->chunk_pool_->Stats();
+            res->set_pool_allocations(pool.allocations);
+            res->set_pool_reuses(pool.reuses);
+            res->set_pool_bytes(pool.bytes);
+            res->set_pool_allocations_per_gb(pool.AllocationsPerGB());
+            CodecStats codec = service->codec_counters_.Stats();
+            res->set_codec_compressed_chunks(codec.compressed_chunks);
+            res->set_codec_skipped_chunks(codec.skipped_chunks);
+            res->set_codec_raw_bytes(codec.raw_bytes);
+            res->set_codec_wire_bytes(codec.wire_bytes);
+            res->set_codec_ratio(codec.Ratio());
+            res->set_codec_compress_ns(codec.compress_ns);
+            res->set_codec_decompressed_chunks(codec.decompressed_chunks);
+            res->set_codec_decompress_ns(codec.decompress_ns);
+            Finish(grpc::Status::OK);
+        }
+
+        void OnDone() override {
+            delete this;
+        }
+    };
+
     return new Reactor(this, response);
 }
 
-grpc::ServerWriteReactor<minidfs::FileBuffer>* MiniDFSImpl::FetchFile(
+grpc::ServerReadReactor<minidfs::FileBuffer>* MiniDFSImpl::UploadChunks(
     grpc::CallbackServerContext* context,
-    const minidfs::FetchFileReq* request)
+    minidfs::UploadStatus* response)
 {
-    class Reactor : public grpc::ServerWriteReactor<minidfs::FileBuffer> {
+    class Reactor : public grpc::ServerReadReactor<minidfs::FileBuffer> {
     public:
-        Reactor(MiniDFSImpl* service, const minidfs::FetchFileReq* req)
-            : service_(service), req_(req), offset_(0)
-        {   
-            file_path_ = FileManager::ResolvePath(
-                service_->mount_path_, req_->file_path());
-            client_id_ = req_->client_id();
-            NextWrite();
+        Reactor(MiniDFSImpl* service, grpc::CallbackServerContext* ctx, minidfs::UploadStatus* res)
+            : service_(service), context_(ctx), response_(res), current_(service->chunk_pool_->Acquire()), offset_(0)
+        {
+            StartRead(current_.get());
         }
 
-        void OnWriteDone(bool ok) override {
+        void OnReadDone(bool ok) override {
             if (!ok) {
-                if (!file_path_.empty()) {
-                    service_->file_manager_->ReleaseReadLock(client_id_, file_path_.generic_string());
+                if (context_->IsCancelled()) {
+                    Finish(grpc::Status::CANCELLED);
+                } else if (!session_) {
+                    Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Missing upload id"));
+                } else {
+                    EndStripe();
                 }
-                Finish(grpc::Status::OK);
                 return;
             }
-            NextWrite();
+
+            if (!session_) {
+                grpc::Status status = Open();
+                if (!status.ok()) {
+                    Finish(status);
+                    return;
+                }
+            }
+
+            WriteCurrent();
+        }
+
+        void OnCancel() override {
+            // may race with the stream end that queued the commit lock
+            std::shared_ptr<LockWaiter> waiter;
+            {
+                std::lock_guard<std::mutex> lock(waiter_mu_);
+                waiter = waiter_;
+            }
+            if (waiter && service_->file_manager_->CancelLockWaiter(target_path_.generic_string(), waiter)) {
+                service_->upload_manager_->AbortCommit(session_);
+                Finish(grpc::Status::CANCELLED);
+            }
         }
 
         void OnDone() override {
+            ReleaseStripe(false);
             delete this;
         }
 
     private:
-        void NextWrite() {
-            std::vector<char> raw_buf(CHUNK_SIZE);
-            size_t bytes_read = 0;
-    
-            bool read_success = service_->file_manager_->ReadFile(
-                client_id_, file_path_.generic_string(), offset_, raw_buf.data(), &bytes_read
-            );
+        grpc::Status Open() {
+            auto session = service_->upload_manager_->Find(current_->upload_id());
+            if (!session) {
+                return grpc::Status(grpc::StatusCode::NOT_FOUND, "Unknown upload id");
+            }
+            stripe_ = current_->stripe();
+            if (stripe_ >= session->stripes) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "No such stripe");
+            }
+
+            // every stripe writes through one write session on the part file, opened by the
+            // first stripe to arrive and closed by the last to leave
+            FileManager* fm = service_->file_manager_.get();
+            bool claimed = service_->upload_manager_->Claim(session, stripe_, [fm, session]() {
+                return fm->AcquireWriteLock(session->client_id, session->part_path, false);
+            });
+            if (!claimed) {
+                return grpc::Status(grpc::StatusCode::ABORTED, "Upload already in progress");
+            }
+            session_ = std::move(session);
+            stripe_claimed_ = true;
+
+            UploadManager::StripeBounds(*session_, stripe_, &stripe_begin_, &stripe_end_);
+            // a gap would leave bytes in the part file that were never sent
+            if (current_->offset() < stripe_begin_ || current_->offset() > service_->upload_manager_->StripeCommitted(session_, stripe_)) {
+                return grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Offset is outside the committed part of the stripe");
+            }
+            offset_ = current_->offset();
+            hash_valid_ = offset_ == 0 && session_->stripes == 1;
+            return grpc::Status::OK;
+        }
+
+        void WriteCurrent() {
+            // nothing of a corrupt chunk is committed, so the client resumes from before it
+            grpc::Status unpacked = UnpackChunk(current_.get(), service_->GetMaxChunkSize(), &scratch_, &service_->codec_counters_);
+            if (!unpacked.ok()) {
+                Finish(unpacked);
+                return;
+            }
+            const char* data = static_cast<const char*>(current_->data().data());
+            size_t data_size = current_->data().size();
+
+            if (data_size > stripe_end_ - offset_) {
+                Finish(grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Write past the end of the stripe"));
+                return;
+            }
+            if (data_size == 0) {
+                StartRead(current_.get());
+                return;
+            }
+
+            service_->file_manager_->WriteFileAsync(
+                session_->client_id, session_->part_path,
+                offset_, data, data_size, [this, data_size](bool write_ok) {
+                    if (!write_ok) {
+                        Finish(grpc::Status(grpc::StatusCode::DATA_LOSS, "Write failed"));
+                        return;
+                    }
+                    if (hash_valid_) hash_.Update(current_->data().data(), data_size);
+                    service_->chunk_pool_->CountBytes(data_size);
+                    offset_ += data_size;
+                    service_->upload_manager_->Advance(session_, stripe_, offset_);
+                    StartRead(current_.get());
+                });
+        }
+
+        // Every stream just reports how far the upload got, except the one that completes
+        // it: that one moves the part file over the target under its write lock, so readers
+        // see either the old file or the whole new one.
+        void EndStripe() {
+            bool commit = ReleaseStripe(true);
+            FillUploadStatus(*service_->upload_manager_, session_, service_->GetMaxChunkSize(), response_);
+            if (!commit) {
+                Finish(grpc::Status::OK);
+                return;
+            }
+
+            target_path_ = FileManager::ResolvePath(service_->mount_path_, session_->file_path);
+            // DEL locks without creating the target, so no empty file appears while queued
+            auto waiter = service_->RequestFileLock(context_, &alarm_, session_->client_id, target_path_.generic_string(),
+                minidfs::FileOpType::DEL, [this](const grpc::Status& status) { OnTargetLocked(status); });
+            std::lock_guard<std::mutex> lock(waiter_mu_);
+            waiter_ = std::move(waiter);
+        }
+
+        void OnTargetLocked(const grpc::Status& status) {
+            if (!status.ok()) {
+                service_->upload_manager_->AbortCommit(session_);
+                Finish(status);
+                return;
+            }
+
+            std::string target = target_path_.generic_string();
+            // only a single stream that carried every byte has a digest of the whole file
+            if (hash_valid_ && offset_ == session_->size) {
+                SaveStoredHash(session_->part_path, hash_.Final());
+            }
+            bool replaced = service_->file_manager_->ReplaceFile(session_->client_id, target, session_->part_path);
+            service_->file_manager_->ReleaseWriteLock(session_->client_id, target);
+            service_->InvalidateListings(target_path_);
+
+            if (!replaced) {
+                service_->upload_manager_->AbortCommit(session_);
+                Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to commit upload"));
+                return;
+            }
+
+            service_->upload_manager_->Remove(session_);
+            service_->IncrementVersion();
+            service_->pubsub_manager_->Publish(session_->client_id, target, minidfs::FileUpdateType::MODIFIED);
+            response_->set_committed(session_->size);
+            response_->set_complete(true);
+            Finish(grpc::Status::OK);
+        }
+
+        bool ReleaseStripe(bool try_commit) {
+            if (!stripe_claimed_) return false;
+            stripe_claimed_ = false;
+            FileManager* fm = service_->file_manager_.get();
+            auto session = session_;
+            return service_->upload_manager_->Release(session_, stripe_, try_commit, [fm, session]() {
+                fm->ReleaseWriteLock(session->client_id, session->part_path);
+            });
+        }
+
+        MiniDFSImpl* service_;
+        grpc::CallbackServerContext* context_;
+        minidfs::UploadStatus* response_;
+        ChunkPool::Chunk current_;
+        std::string scratch_;
+        std::shared_ptr<UploadSession> session_;
+        uint32_t stripe_ = 0;
+        bool stripe_claimed_ = false;
+        uint64_t stripe_begin_ = 0;
+        uint64_t stripe_end_ = 0;
+        uint64_t offset_;
+        bool hash_valid_ = false;
+        IncrementalHash hash_;
+        fs::path target_path_;
+        std::mutex waiter_mu_;
+        std::shared_ptr<LockWaiter> waiter_;
+        grpc::Alarm alarm_;
+    };
+
+    return new Reactor(this, context, response);
+}
+
+// Registered as a raw method so each chunk can be framed by hand: above FETCH_MMAP_MIN_SIZE the
+// payload goes out as a gRPC slice pointing straight into a mapping of the file, with no copy on
+// the way to the transport. Smaller files, or a server with mmap switched off, go through the
+// read-ahead ring and are serialized as ordinary FileBuffers. Clients see the same messages.
+grpc::ServerWriteReactor<grpc::ByteBuffer>* MiniDFSImpl::FetchFile(
+    grpc::CallbackServerContext* context,
+    const grpc::ByteBuffer* request)
+{
+    class Reactor : public grpc::ServerWriteReactor<grpc::ByteBuffer> {
+    public:
+        Reactor(MiniDFSImpl* service, grpc::CallbackServerContext* ctx, const grpc::ByteBuffer* request)
+            : service_(service), slots_(service->fetch_read_ahead_.load() + 1)
+        {   
+            grpc::ByteBuffer request_copy(*request);
+            if (!grpc::SerializationTraits<minidfs::FetchFileReq>::Deserialize(&request_copy, &req_).ok()) {
+                Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Malformed FetchFile request"));
+                return;
+            }
+            for (ReadSlot& slot : slots_) {
+                slot.chunk = service_->chunk_pool_->Acquire();
+            }
+            file_path_ = FileManager::ResolvePath(
+                service_->mount_path_, req_.file_path());
+            client_id_ = req_.client_id();
+            read_offset_ = req_.offset();
+            // chunks must fit both our send limit and the client's receive limit
+            size_t client_max = req_.max_chunk_size() > 0 ? req_.max_chunk_size() : MaxChunkSize(MAX_MESSAGE_SIZE);
+            sizer_ = ChunkSizer(req_.chunk_size(), std::min(service_->GetMaxChunkSize(), client_max), req_.adaptive_chunks());
+            // a codec we lack is not an error: the chunks just go out uncompressed
+            if (req_.codec() != minidfs::CODEC_NONE && CodecSupported(req_.codec())) {
+                compressor_ = std::make_unique<ChunkCompressor>(&service_->codec_counters_, req_.codec(), req_.codec_level());
+            }
+            // length 0 (or a range running past the end) streams to EOF
+            end_ = req_.length() == 0 || req_.length() > UINT64_MAX - read_offset_ ? UINT64_MAX : read_offset_ + req_.length();
 
-            if (!read_success) {
-                Finish(grpc::Status(grpc::StatusCode::DATA_LOSS, "File Read Error"));
+            if (req_.acquire_lock()) {
+                waiter_ = service_->RequestFileLock(ctx, &alarm_, client_id_, file_path_.generic_string(),
+                    minidfs::FileOpType::READ, [this](const grpc::Status& status) { OnLocked(status); }, req_.lock_token());
                 return;
             }
+            // legacy clients took the lock through GetFileLock
+            lock_held_ = true;
+            StartStreaming();
+        }
+
+        void OnWriteDone(bool ok) override {
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                writing_ = false;
+                if (ok) sizer_.Record(write_bytes_, std::chrono::steady_clock::now() - write_started_);
+                if (!ok && !finish_) finish_ = grpc::Status::OK;
+            }
+            Pump();
+        }
+
+        void OnCancel() override {
+            if (waiter_ && service_->file_manager_->CancelLockWaiter(file_path_.generic_string(), waiter_)) {
+                Finish(grpc::Status::CANCELLED);
+            }
+        }
 
-            if (bytes_read > 0) {
-                if (offset_ == 0) {
-                    buffer_.set_file_path(file_path_.generic_string());
+        void OnDone() override {
+            if (lock_held_) {
+                service_->file_manager_->ReleaseReadLock(client_id_, file_path_.generic_string());
+            }
+            delete this;
+        }
+
+    private:
+        void OnLocked(const grpc::Status& status) {
+            if (!status.ok()) {
+                Finish(status);
+                return;
+            }
+            lock_held_ = true;
+            StartStreaming();
+        }
+
+        // Under the read lock, so the mapping is of the version the lock protects.
+        // Compressed streams skip the mapping: the compressor reads the bytes anyway.
+        void StartStreaming() {
+            // the first chunk hands it out, so the client's other streams of this fetch can share the lock
+            lock_token_ = service_->file_manager_->ReadLockToken(client_id_, file_path_.generic_string());
+            if (!compressor_ && service_->fetch_mmap_.load() && FileSize() >= FETCH_MMAP_MIN_SIZE) {
+                mapping_ = service_->file_manager_->MapFile(client_id_, file_path_.generic_string());
+            }
+            Pump();
+        }
+
+        // A pooled chunk in the read-ahead ring. Slots are filled in offset order starting at
+        // tail_ and sent in the same order from head_; reads may complete in any order. The disk
+        // read lands straight in the chunk's payload, which is serialized once into the stream.
+        struct ReadSlot {
+            enum class State { FREE, READING, READY };
+            ChunkPool::Chunk chunk;
+            State state = State::FREE;
+            uint64_t offset = 0;
+            // the chunk size when the read was issued; the sizer may have moved on since
+            size_t size = 0;
+            size_t bytes = 0;
+            std::string scratch;
+            bool ok = true;
+        };
+
+        // Sends the next chunk if it is ready and the stream is idle, then refills free slots.
+        // Runs after every read completion and write completion; the reads and the StartWrite
+        // are issued outside mu_ because FileManager completes non-uring reads inline.
+        void Pump() {
+            bool write = false;
+            std::optional<grpc::Status> finish;
+            std::vector<std::pair<size_t, char*>> reads;
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                if (mapping_) {
+                    write = NextMapped();
                 } else {
-                    buffer_.clear_file_path();
+                    write = NextRead(&reads);
                 }
 
-                buffer_.set_offset(offset_);
-                buffer_.set_data(raw_buf.data(), bytes_read);
+                // the reactor is deleted in OnDone, so no read may still be writing into it
+                if (finish_ && !finished_ && !writing_ && reads_in_flight_ == 0) {
+                    finished_ = true;
+                    finish = finish_;
+                }
+            }
 
-                offset_ += bytes_read;
-                
-                StartWrite(&buffer_);
-            } else {
-                Finish(grpc::Status::OK);
+            if (write) StartWrite(&outgoing_);
+            for (const auto& [index, out] : reads) {
+                service_->file_manager_->ReadFileAsync(
+                    client_id_, file_path_.generic_string(), slots_[index].offset, out, slots_[index].size,
+                    [this, index](bool read_success, size_t bytes_read) { OnChunkRead(index, read_success, bytes_read); });
             }
+            if (finish) Finish(*finish);
+        }
+
+        // Caller holds mu_. Frames the next slice of the mapping into outgoing_; nothing is read,
+        // the page cache is faulted in as the transport sends.
+        bool NextMapped() {
+            if (writing_ || finish_) return false;
+            uint64_t size = mapping_->Size();
+            uint64_t end = std::min<uint64_t>(end_, size);
+            if (read_offset_ >= end) {
+                // starting exactly at EOF is an empty range (a finished resume); past it is an error
+                if (read_offset_ == req_.offset() && read_offset_ > size) {
+                    finish_ = grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Offset is past the end of the file");
+                } else {
+                    finish_ = grpc::Status::OK;
+                }
+                return false;
+            }
+
+            size_t bytes = static_cast<size_t>(std::min<uint64_t>(sizer_.Size(), end - read_offset_));
+            minidfs::FileBuffer& header = *slots_[0].chunk;
+            header.Clear();
+            if (read_offset_ == req_.offset()) {
+                header.set_file_path(file_path_.generic_string());
+                header.set_file_size(size);
+                header.set_lock_token(lock_token_);
+            }
+            header.set_offset(read_offset_);
+            header.set_crc32c(Crc32c(mapping_->Data() + read_offset_, bytes));
+
+            // the header fields, then the data field's tag and length, then the mapped bytes themselves
+            prefix_.clear();
+            header.AppendToString(&prefix_);
+            uint8_t data_key[16];
+            uint8_t* key_end = google::protobuf::internal::WireFormatLite::WriteTagToArray(
+                minidfs::FileBuffer::kDataFieldNumber, google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED, data_key);
+            key_end = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(bytes), key_end);
+            prefix_.append(reinterpret_cast<const char*>(data_key), key_end - data_key);
+
+            // each slice holds its own reference, so the pages outlive the read lock if the
+            // transport is still sending them
+            grpc::Slice slices[2] = {
+                grpc::Slice(prefix_),
+                grpc::Slice(const_cast<char*>(mapping_->Data() + read_offset_), bytes, &ReleaseMapping,
+                    new std::shared_ptr<const MappedFile>(mapping_)),
+            };
+            outgoing_ = grpc::ByteBuffer(slices, 2);
+            service_->chunk_pool_->CountBytes(bytes);
+
+            read_offset_ += bytes;
+            StartedWrite(bytes);
+            return true;
+        }
+
+        static void ReleaseMapping(void* mapping) {
+            delete static_cast<std::shared_ptr<const MappedFile>*>(mapping);
+        }
+
+        // Caller holds mu_. Serializes the head slot into outgoing_ if it is ready and queues
+        // reads into every free slot; returns whether a write should start.
+        bool NextRead(std::vector<std::pair<size_t, char*>>* reads) {
+            bool write = false;
+            if (!writing_ && !finish_) {
+                ReadSlot& slot = slots_[head_];
+                if (slot.state == ReadSlot::State::READY) {
+                    if (!slot.ok) {
+                        finish_ = grpc::Status(grpc::StatusCode::DATA_LOSS, "File Read Error");
+                    } else if (slot.bytes == 0) {
+                        // starting exactly at EOF is an empty range (a finished resume); past it is an error
+                        if (slot.offset == req_.offset() && slot.offset > 0 && slot.offset > FileSize()) {
+                            finish_ = grpc::Status(grpc::StatusCode::OUT_OF_RANGE, "Offset is past the end of the file");
+                        } else {
+                            finish_ = grpc::Status::OK;
+                        }
+                    } else {
+                        minidfs::FileBuffer& chunk = *slot.chunk;
+                        if (slot.offset == req_.offset()) {
+                            chunk.set_file_path(file_path_.generic_string());
+                            chunk.set_file_size(FileSize());
+                            chunk.set_lock_token(lock_token_);
+                        } else {
+                            chunk.clear_file_path();
+                            chunk.clear_file_size();
+                            chunk.clear_lock_token();
+                        }
+                        size_t bytes = static_cast<size_t>(std::min<uint64_t>(slot.bytes, end_ - slot.offset));
+                        chunk.set_offset(slot.offset);
+                        bool own_buffer;
+                        outgoing_.Clear();
+                        grpc::SerializationTraits<minidfs::FileBuffer>::Serialize(chunk, &outgoing_, &own_buffer);
+                        service_->chunk_pool_->CountBytes(bytes);
+
+                        slot.state = ReadSlot::State::FREE;
+                        head_ = (head_ + 1) % slots_.size();
+                        queued_--;
+                        StartedWrite(bytes);
+                        write = true;
+                    }
+                } else if (queued_ == 0 && (read_offset_ >= end_ || eof_)) {
+                    finish_ = grpc::Status::OK;
+                }
+            }
+
+            // the chunk on the wire counts against the ring, so a read-ahead of 0 reads only when idle
+            while (!finish_ && !eof_ && read_offset_ < end_ && queued_ + (writing_ ? 1 : 0) < slots_.size()) {
+                ReadSlot& slot = slots_[tail_];
+                slot.state = ReadSlot::State::READING;
+                slot.offset = read_offset_;
+                slot.size = sizer_.Size();
+                reads->emplace_back(tail_, service_->chunk_pool_->Reserve(slot.chunk.get(), slot.size));
+                tail_ = (tail_ + 1) % slots_.size();
+                read_offset_ += slot.size;
+                queued_++;
+                reads_in_flight_++;
+            }
+            return write;
+        }
+
+        // Caller holds mu_.
+        void StartedWrite(size_t bytes) {
+            writing_ = true;
+            write_bytes_ = bytes;
+            write_started_ = std::chrono::steady_clock::now();
+        }
+
+        void OnChunkRead(size_t index, bool read_success, size_t bytes_read) {
+            // nothing else touches a READING slot, so the checksum and compression run here,
+            // off mu_ and spread over however many threads complete reads
+            ReadSlot& read = slots_[index];
+            if (read_success && bytes_read > 0) {
+                minidfs::FileBuffer& chunk = *read.chunk;
+                chunk.mutable_data()->resize(static_cast<size_t>(std::min<uint64_t>(bytes_read, end_ - read.offset)));
+                chunk.set_crc32c(Crc32c(chunk.data().data(), chunk.data().size()));
+                if (compressor_) compressor_->Compress(&chunk, &read.scratch);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                ReadSlot& slot = slots_[index];
+                slot.state = ReadSlot::State::READY;
+                slot.ok = read_success;
+                slot.bytes = read_success ? bytes_read : 0;
+                reads_in_flight_--;
+                // a short read is the end of the file: nothing past it is worth requesting
+                if (!read_success || bytes_read < slot.size) eof_ = true;
+            }
+            Pump();
+        }
+
+        uint64_t FileSize() const {
+            std::error_code ec;
+            uint64_t size = fs::file_size(file_path_, ec);
+            return ec ? 0 : size;
         }
 
         MiniDFSImpl* service_;
-        const minidfs::FetchFileReq* req_;
+        minidfs::FetchFileReq req_;
         fs::path file_path_;
         std::string client_id_;
-        uint64_t offset_;
-        minidfs::FileBuffer buffer_;
+        uint64_t read_offset_ = 0;
+        uint64_t end_ = 0;
+        // guards the ring and the stream state below; completions arrive on gRPC and uring threads
+        std::mutex mu_;
+        std::vector<ReadSlot> slots_;
+        size_t head_ = 0;
+        size_t tail_ = 0;
+        size_t queued_ = 0;
+        size_t reads_in_flight_ = 0;
+        // picks each chunk's size, fed by how long every write took to complete
+        ChunkSizer sizer_{CHUNK_SIZE, CHUNK_SIZE, false};
+        std::unique_ptr<ChunkCompressor> compressor_;
+        size_t write_bytes_ = 0;
+        std::chrono::steady_clock::time_point write_started_;
+        std::shared_ptr<const MappedFile> mapping_;
+        std::string prefix_;
+        grpc::ByteBuffer outgoing_;
+        bool writing_ = false;
+        bool eof_ = false;
+        bool finished_ = false;
+        std::optional<grpc::Status> finish_;
+        bool lock_held_ = false;
+        uint64_t lock_token_ = 0;
+        std::shared_ptr<LockWaiter> waiter_;
+        grpc::Alarm alarm_;
     };
     
-    return new Reactor(this, request);
+    return new Reactor(this, context, request);
 }
 
 grpc::ServerWriteReactor<minidfs::FileUpdate>* MiniDFSImpl::FileUpdateCallback(
@@ -327,7 +1645,7 @@ grpc::ServerWriteReactor<minidfs::FileUpdate>* MiniDFSImpl::FileUpdateCallback(
             minidfs::FileInfo file_info;
             file_info.set_file_path(file_path);
             file_info.set_is_dir(fs::is_directory(file_path));
-            file_info.set_hash(FileManager::GetFileHash(file_path));
+            file_info.set_hash(service_->hash_cache_->GetFileHash(file_path));
 
             minidfs::FileUpdate res;
             res.set_type(type);
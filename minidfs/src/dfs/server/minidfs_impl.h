@@ -1,21 +1,58 @@
 #pragma once
 
 #include <grpcpp/grpcpp.h>
+#include <grpcpp/alarm.h>
 #include <atomic>
 #include <queue>
 #include "proto_src/minidfs.grpc.pb.h"
+#include "dfs/chunk_codec.h"
+#include "dfs/chunk_pool.h"
+#include "dfs/chunk_sizer.h"
+#include "dfs/file_delta.h"
 #include "dfs/file_manager.h"
+#include "dfs/storage/chunk_store.h"
+#include "dfs/storage/dir_scan.h"
+#include "dfs/storage/hash_cache.h"
+#include "dfs/storage/tree_walk.h"
+#include "dfs/thread_pool.h"
+#include "listing_cache.h"
 #include "pubsub_manager.h"
+#include "upload_manager.h"
 
-class MiniDFSImpl final : public minidfs::MiniDFSService::CallbackService {
+// Upper bound on how long a GetFileLock call stays queued when the client sets no deadline.
+#define LOCK_WAIT_TIMEOUT_MS 30000
+
+// ListFilesStream page bounds, in entries.
+#define LIST_FILES_PAGE_SIZE 1000
+#define LIST_FILES_MAX_PAGE_SIZE 10000
+
+// Upper bound on WalkTree pool threads; the pool is shared by every walk.
+#define WALK_TREE_MAX_THREADS 8
+
+// Chunks FetchFile reads ahead of the one being sent; 0 reads each chunk only after the last was sent.
+#define FETCH_READ_AHEAD 3
+
+// FetchFile sends files at least this large as slices of an mmap instead of reading them.
+#define FETCH_MMAP_MIN_SIZE (1024 * 1024)
+
+// FetchFile is a raw method so its chunks can reference mapped file pages directly.
+class MiniDFSImpl final : public minidfs::MiniDFSService::WithRawCallbackMethod_FetchFile<minidfs::MiniDFSService::CallbackService> {
 public:
-    explicit MiniDFSImpl(const std::string& mount_path);
+    explicit MiniDFSImpl(const std::string& mount_path, IoBackend io_backend = IoBackend::FSTREAM);
 
     grpc::ServerUnaryReactor* ListFiles(
         grpc::CallbackServerContext* context, 
         const minidfs::ListFilesReq* request, 
         minidfs::ListFilesRes* response) override;
 
+    grpc::ServerWriteReactor<minidfs::ListFilesRes>* ListFilesStream(
+        grpc::CallbackServerContext* context,
+        const minidfs::ListFilesReq* request) override;
+
+    grpc::ServerWriteReactor<minidfs::ListFilesRes>* WalkTree(
+        grpc::CallbackServerContext* context,
+        const minidfs::WalkTreeReq* request) override;
+
     grpc::ServerUnaryReactor* GetFileLock(
         grpc::CallbackServerContext* context, 
         const minidfs::FileLockReq* request, 
@@ -30,9 +67,43 @@ public:
         grpc::CallbackServerContext* context, 
         minidfs::StoreFileRes* response) override;
 
-    grpc::ServerWriteReactor<minidfs::FileBuffer>* FetchFile(
+    grpc::ServerUnaryReactor* GetFileSignature(
+        grpc::CallbackServerContext* context,
+        const minidfs::FileSignatureReq* request,
+        minidfs::FileSignature* response) override;
+
+    grpc::ServerUnaryReactor* FindChunks(
+        grpc::CallbackServerContext* context,
+        const minidfs::FindChunksReq* request,
+        minidfs::FindChunksRes* response) override;
+
+    grpc::ServerReadReactor<minidfs::DeltaChunk>* StoreFileDelta(
+        grpc::CallbackServerContext* context,
+        minidfs::StoreFileRes* response) override;
+
+    grpc::ServerUnaryReactor* StartUpload(
+        grpc::CallbackServerContext* context,
+        const minidfs::StartUploadReq* request,
+        minidfs::UploadStatus* response) override;
+
+    grpc::ServerUnaryReactor* GetUploadStatus(
+        grpc::CallbackServerContext* context,
+        const minidfs::UploadStatusReq* request,
+        minidfs::UploadStatus* response) override;
+
+    grpc::ServerReadReactor<minidfs::FileBuffer>* UploadChunks(
+        grpc::CallbackServerContext* context,
+        minidfs::UploadStatus* response) override;
+
+    grpc::ServerUnaryReactor* GetServerInfo(
+        grpc::CallbackServerContext* context,
+        const minidfs::ServerInfoReq* request,
+        minidfs::ServerInfo* response) override;
+
+    // Takes a serialized FetchFileReq and streams serialized FileBuffers.
+    grpc::ServerWriteReactor<grpc::ByteBuffer>* FetchFile(
         grpc::CallbackServerContext* context, 
-        const minidfs::FetchFileReq* request) override;
+        const grpc::ByteBuffer* request) override;
     
     grpc::ServerWriteReactor<minidfs::FileUpdate>* FileUpdateCallback(
         grpc::CallbackServerContext* context, 
@@ -49,12 +120,101 @@ public:
     void SetVersion(uint64_t new_version) {
         version_.store(new_version);
     }
+
+    // Memory budget for cached ListFiles responses; 0 turns the cache off.
+    void SetListingCacheBytes(size_t max_bytes) {
+        listing_cache_->SetMaxBytes(max_bytes);
+    }
+
+    // Buffer reuse across every transfer stream this service has run.
+    ChunkPoolStats GetChunkPoolStats() const {
+        return chunk_pool_->Stats();
+    }
+
+    // Compression on FetchFile streams and decompression of uploads, across all streams.
+    CodecStats GetCodecStats() const {
+        return codec_counters_.Stats();
+    }
+
+    // Indexes committed files by content-defined chunk beside the mount (see chunk_store.h)
+    // and lets uploads refer to chunks any file already has. Off by default; enabling it the
+    // first time loads the index from disk.
+    void SetChunkStore(bool enabled);
+
+    ChunkStoreStats GetChunkStoreStats() const {
+        return chunk_store_->Stats();
+    }
+
+    // Files are ingested in the background; waits until every commit so far has been.
+    void FlushChunkStore() {
+        chunk_store_->Flush();
+    }
+
+    // Applies to FetchFile streams started afterwards.
+    void SetFetchReadAhead(size_t chunks) {
+        fetch_read_ahead_.store(chunks);
+    }
+
+    // Zero-copy FetchFile for files of FETCH_MMAP_MIN_SIZE and up; on by default where mmap exists.
+    void SetFetchMmap(bool enabled) {
+        fetch_mmap_.store(enabled);
+    }
+
+    // Must match the limits the server was built with (ServerBuilder::SetMax*MessageSize);
+    // chunk sizes are negotiated below it.
+    void SetMaxMessageSize(size_t bytes) {
+        max_message_size_.store(bytes);
+    }
+
+    size_t GetMaxChunkSize() const {
+        return MaxChunkSize(max_message_size_.load());
+    }
     
 private:
+    // Maps a ListFiles request path to the local directory and its virtual path, checking
+    // that it exists and is a directory.
+    grpc::Status ResolveListDirectory(const std::string& request_path, std::filesystem::path* dir_path, std::filesystem::path* virtual_dir);
+
+    // Drops cached listings that a change to local_file_path makes stale: its directory and
+    // every ancestor, since a created file or directory also moves the parent's mtime shown
+    // one level up.
+    void InvalidateListings(const std::filesystem::path& local_file_path);
+
+    // false once any entry of a cached listing changed on disk, such as a file edited in place,
+    // which moves the file's mtime but not its directory's.
+    static bool ListingIsCurrent(const std::filesystem::path& dir_path, const minidfs::ListFilesRes& listing);
+
+    void FillFileInfo(const std::filesystem::path& dir_path, const std::filesystem::path& virtual_dir, const DirEntryInfo& entry, minidfs::FileInfo* file_info);
+
+    // Requests a file lock for op without blocking the calling thread. on_locked receives OK,
+    // ABORTED or DEADLINE_EXCEEDED exactly once, unless the returned waiter is cancelled first.
+    // alarm bounds the wait and must be owned by the calling reactor. lock_token is passed on
+    // to FileManager::AcquireReadLockAsync for READ.
+    std::shared_ptr<LockWaiter> RequestFileLock(
+        grpc::CallbackServerContext* context,
+        grpc::Alarm* alarm,
+        const std::string& client_id,
+        const std::string& file_path,
+        minidfs::FileOpType op,
+        std::function<void(const grpc::Status&)> on_locked,
+        uint64_t lock_token = 0);
+
+    // declared before file_manager_, which points at it
+    std::unique_ptr<ChunkStore> chunk_store_;
     std::unique_ptr<FileManager> file_manager_;
     std::unique_ptr<PubSubManager> pubsub_manager_;
+    std::unique_ptr<HashCache> hash_cache_;
+    std::unique_ptr<ListingCache> listing_cache_;
+    std::unique_ptr<UploadManager> upload_manager_;
+    std::unique_ptr<ChunkPool> chunk_pool_;
+    CodecCounters codec_counters_;
+    // declared after hash_cache_ so walks still running at shutdown stop first
+    std::unique_ptr<ThreadPool> walk_pool_;
     std::string mount_path_;
     std::atomic<uint64_t> version_;
+    std::atomic<size_t> fetch_read_ahead_{FETCH_READ_AHEAD};
+    std::atomic<bool> fetch_mmap_{true};
+    std::atomic<size_t> max_message_size_{MAX_MESSAGE_SIZE};
 
 
     friend class MiniDFSSingleClientTest;
@@ -1,3 +1,6 @@
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -8,6 +11,17 @@
 
 namespace fs = std::filesystem;
 
+// Parses a positive whole number of MB. gRPC takes message limits as an int, so anything
+// larger is clamped to INT_MAX bytes.
+static bool ParseMessageSize(const char* arg, size_t* max_message_size) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long mb = std::strtoull(arg, &end, 10);
+    if (arg[0] < '0' || arg[0] > '9' || *end != '\0' || errno == ERANGE || mb == 0) return false;
+    *max_message_size = mb > (INT_MAX >> 20) ? static_cast<size_t>(INT_MAX) : static_cast<size_t>(mb << 20);
+    return true;
+}
+
 int main(int argc, char** argv) {
     std::string mount_path = "server/minidfs";
     if (argc > 1) {
@@ -15,11 +29,34 @@ int main(int argc, char** argv) {
     }
     fs::create_directories(mount_path);
 
+    // storage I/O backend: "fstream" (default), "posix" or "uring"
+    IoBackend io_backend = IoBackend::FSTREAM;
+    if (argc > 2 && std::string(argv[2]) == "posix") {
+        io_backend = IoBackend::POSIX;
+    } else if (argc > 2 && std::string(argv[2]) == "uring") {
+        io_backend = IoBackend::URING;
+    }
+
+    // largest gRPC message in MB; transfer chunks are negotiated to fit under it
+    size_t max_message_size = MAX_MESSAGE_SIZE;
+    if (argc > 3 && !ParseMessageSize(argv[3], &max_message_size)) {
+        std::cerr << "usage: " << argv[0] << " [mount_path] [fstream|posix|uring] [max_message_mb] [dedup]" << std::endl;
+        return 1;
+    }
+
+    // "dedup" keeps a content-addressed chunk index beside the mount so uploads skip chunks the
+    // server already has
+    bool chunk_store = argc > 4 && std::string(argv[4]) == "dedup";
+
     std::string server_address("0.0.0.0:50051");
-    MiniDFSImpl service(mount_path);
+    MiniDFSImpl service(mount_path, io_backend);
+    service.SetMaxMessageSize(max_message_size);
+    service.SetChunkStore(chunk_store);
 
     grpc::ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
+    builder.SetMaxReceiveMessageSize(static_cast<int>(max_message_size));
+    builder.SetMaxSendMessageSize(static_cast<int>(max_message_size));
     builder.RegisterService(&service);
 
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
@@ -0,0 +1,233 @@
+#include "upload_manager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string NewUploadId() {
+        static std::mutex mu;
+        static std::mt19937_64 rng(std::random_device{}());
+
+        std::lock_guard<std::mutex> lock(mu);
+        std::ostringstream oss;
+        oss << std::hex << std::setfill('0') << std::setw(16) << rng() << std::setw(16) << rng();
+        return oss.str();
+    }
+
+    bool IsNumber(const std::string& s) {
+        return !s.empty() && s.size() <= 19 && s.find_first_not_of("0123456789") == std::string::npos;
+    }
+
+    bool IsSignedNumber(const std::string& s) {
+        return IsNumber(s[0] == '-' ? s.substr(1) : s);
+    }
+
+    void InitStripes(UploadSession& session, uint32_t stripes) {
+        session.stripes = stripes;
+        session.stripe_size = (session.size + stripes - 1) / stripes;
+        session.stripe_committed.assign(stripes, 0);
+        session.stripe_active.assign(stripes, false);
+    }
+}
+
+UploadManager::UploadManager(const std::string& state_dir) : state_dir_(state_dir) {
+    std::error_code ec;
+    fs::create_directories(state_dir_, ec);
+    Load();
+}
+
+std::string UploadManager::StateDirFor(const std::string& mount_path) {
+    fs::path mount = fs::path(mount_path).lexically_normal();
+    if (!mount.has_filename()) mount = mount.parent_path();
+    return mount.generic_string() + ".uploads";
+}
+
+std::shared_ptr<UploadSession> UploadManager::Start(const std::string& client_id, const std::string& file_path, uint64_t size,
+    int64_t source_version, uint32_t stripes)
+{
+    stripes = static_cast<uint32_t>(std::clamp<uint64_t>(stripes, 1, std::min<uint64_t>(UPLOAD_MAX_STRIPES, std::max<uint64_t>(size, 1))));
+
+    std::lock_guard<std::mutex> lock(mu_);
+
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+        const std::shared_ptr<UploadSession>& existing = it->second;
+        if (existing->client_id != client_id || existing->file_path != file_path) continue;
+        if (existing->size == size && existing->source_version == source_version && existing->stripes == stripes) return existing;
+        // the file changed since the last attempt; its bytes are useless now
+        if (existing->active == 0 && !existing->committing) {
+            std::error_code ec;
+            fs::remove(existing->part_path, ec);
+            fs::remove(existing->meta_path, ec);
+            sessions_.erase(it);
+        }
+        break;
+    }
+
+    auto session = std::make_shared<UploadSession>();
+    session->id = NewUploadId();
+    session->client_id = client_id;
+    session->file_path = file_path;
+    session->size = size;
+    session->source_version = source_version;
+    session->part_path = (fs::path(state_dir_) / (session->id + ".part")).generic_string();
+    session->meta_path = (fs::path(state_dir_) / (session->id + ".meta")).generic_string();
+    InitStripes(*session, stripes);
+
+    std::ofstream part(session->part_path, std::ios::binary | std::ios::trunc);
+    std::ofstream meta(session->meta_path, std::ios::trunc);
+    meta << client_id << '\n' << file_path << '\n' << size << '\n' << stripes << '\n' << source_version << '\n';
+    meta.flush();
+    if (!part || !meta) {
+        std::error_code ec;
+        fs::remove(session->part_path, ec);
+        fs::remove(session->meta_path, ec);
+        return nullptr;
+    }
+
+    sessions_[session->id] = session;
+    return session;
+}
+
+std::shared_ptr<UploadSession> UploadManager::Find(const std::string& upload_id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = sessions_.find(upload_id);
+    return it == sessions_.end() ? nullptr : it->second;
+}
+
+bool UploadManager::Claim(const std::shared_ptr<UploadSession>& session, uint32_t stripe, const std::function<bool()>& open_part) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stripe >= session->stripes || session->stripe_active[stripe] || session->committing) return false;
+    if (session->active == 0 && !open_part()) return false;
+    session->stripe_active[stripe] = true;
+    session->active++;
+    return true;
+}
+
+bool UploadManager::Release(const std::shared_ptr<UploadSession>& session, uint32_t stripe, bool try_commit, const std::function<void()>& close_part) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (stripe < session->stripes && session->stripe_active[stripe]) {
+        session->stripe_active[stripe] = false;
+        if (--session->active == 0) close_part();
+    }
+
+    if (!try_commit || session->active > 0 || session->committing) return false;
+    uint64_t committed = 0;
+    for (uint32_t i = 0; i < session->stripes; i++) {
+        uint64_t begin, end;
+        StripeBounds(*session, i, &begin, &end);
+        committed += StripeCommittedLocked(*session, i) - begin;
+    }
+    if (committed < session->size) return false;
+
+    session->committing = true;
+    return true;
+}
+
+void UploadManager::AbortCommit(const std::shared_ptr<UploadSession>& session) {
+    std::lock_guard<std::mutex> lock(mu_);
+    session->committing = false;
+}
+
+void UploadManager::Advance(const std::shared_ptr<UploadSession>& session, uint32_t stripe, uint64_t end) {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint64_t begin, stripe_end;
+    StripeBounds(*session, stripe, &begin, &stripe_end);
+    session->stripe_committed[stripe] = std::max(session->stripe_committed[stripe], std::min(end, stripe_end) - begin);
+}
+
+void UploadManager::Remove(const std::shared_ptr<UploadSession>& session) {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::error_code ec;
+    fs::remove(session->part_path, ec);
+    fs::remove(session->meta_path, ec);
+    sessions_.erase(session->id);
+}
+
+void UploadManager::StripeBounds(const UploadSession& session, uint32_t stripe, uint64_t* begin, uint64_t* end) {
+    *begin = std::min(session.size, stripe * session.stripe_size);
+    *end = stripe + 1 == session.stripes ? session.size : std::min(session.size, *begin + session.stripe_size);
+}
+
+uint64_t UploadManager::StripeCommitted(const std::shared_ptr<UploadSession>& session, uint32_t stripe) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return StripeCommittedLocked(*session, stripe);
+}
+
+uint64_t UploadManager::Committed(const std::shared_ptr<UploadSession>& session) {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint64_t committed = 0;
+    for (uint32_t i = 0; i < session->stripes; i++) {
+        uint64_t begin, end;
+        StripeBounds(*session, i, &begin, &end);
+        committed += StripeCommittedLocked(*session, i) - begin;
+    }
+    return committed;
+}
+
+uint64_t UploadManager::StripeCommittedLocked(const UploadSession& session, uint32_t stripe) const {
+    uint64_t begin, end;
+    StripeBounds(session, stripe, &begin, &end);
+    if (session.stripes > 1) return begin + session.stripe_committed[stripe];
+
+    // a single stripe is written strictly in order, so the part file's length is its progress
+    std::error_code ec;
+    uint64_t size = fs::file_size(session.part_path, ec);
+    return ec ? 0 : std::min(size, end);
+}
+
+std::string UploadManager::NewStagingPath() const {
+    return (fs::path(state_dir_) / (NewUploadId() + ".tmp")).generic_string();
+}
+
+size_t UploadManager::Size() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return sessions_.size();
+}
+
+void UploadManager::Load() {
+    std::vector<fs::path> stale;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(state_dir_, ec)) {
+        if (entry.path().extension() == ".tmp") {
+            stale.push_back(entry.path());
+            continue;
+        }
+        if (entry.path().extension() != ".meta") continue;
+
+        auto session = std::make_shared<UploadSession>();
+        session->id = entry.path().stem().string();
+        session->meta_path = entry.path().generic_string();
+        session->part_path = (fs::path(state_dir_) / (session->id + ".part")).generic_string();
+
+        std::ifstream meta(entry.path());
+        std::string size;
+        std::string stripes;
+        std::string source_version;
+        bool parsed = std::getline(meta, session->client_id) && std::getline(meta, session->file_path)
+            && std::getline(meta, size) && IsNumber(size);
+        // sessions written before striping have no stripe count
+        if (!std::getline(meta, stripes)) stripes = "1";
+        // nor a source version; such a session only matches a client that sends none either
+        if (!std::getline(meta, source_version)) source_version = "0";
+        if (!parsed || !IsNumber(stripes) || stripes.size() > 3 || !IsSignedNumber(source_version) || !fs::exists(session->part_path)) {
+            stale.push_back(session->part_path);
+            stale.push_back(entry.path());
+            continue;
+        }
+        session->size = std::stoull(size);
+        session->source_version = std::stoll(source_version);
+        InitStripes(*session, static_cast<uint32_t>(std::clamp(std::stoul(stripes), 1ul, static_cast<unsigned long>(UPLOAD_MAX_STRIPES))));
+        sessions_[session->id] = session;
+    }
+
+    for (const fs::path& path : stale) {
+        fs::remove(path, ec);
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Upper bound on parallel streams for one striped upload.
+#define UPLOAD_MAX_STRIPES 16
+
+// One resumable upload, split into stripes: contiguous byte ranges that are each sent in
+// order on their own stream. A plain upload has a single stripe, so its part file is always
+// a valid prefix and the part file's length is the committed offset; nothing else has to be
+// persisted for a restarted server to resume it. Per-stripe progress of a striped upload is
+// only kept in memory, so after a restart it starts over.
+struct UploadSession {
+    std::string id;
+    std::string client_id;
+    // as sent by the client; resolved against the mount when the upload is committed
+    std::string file_path;
+    uint64_t size = 0;
+    // the client's identifier of the file version being sent, 0 if it gave none
+    int64_t source_version = 0;
+    uint32_t stripes = 1;
+    // every stripe but the last covers exactly this many bytes
+    uint64_t stripe_size = 0;
+    std::string part_path;
+    std::string meta_path;
+
+    // guarded by UploadManager
+    std::vector<uint64_t> stripe_committed;
+    std::vector<bool> stripe_active;
+    uint32_t active = 0;
+    bool committing = false;
+};
+
+// Server-tracked upload sessions, kept in a state directory beside the mount as <id>.part
+// (the bytes received so far) and <id>.meta (client, target path, final size, stripes and
+// source version).
+// Sessions survive restarts and are only dropped once committed. Safe to use from any thread.
+class UploadManager {
+public:
+    explicit UploadManager(const std::string& state_dir);
+
+    // <mount>.uploads, outside the mount so part files never show up in listings.
+    static std::string StateDirFor(const std::string& mount_path);
+
+    // Returns the client's existing session for file_path if its size, source version and
+    // stripe count match, so a client that lost the upload id can resume; otherwise drops it
+    // and starts a new one, since an edited file must not be appended to the old bytes.
+    // nullptr on I/O failure.
+    std::shared_ptr<UploadSession> Start(const std::string& client_id, const std::string& file_path, uint64_t size,
+        int64_t source_version, uint32_t stripes);
+
+    std::shared_ptr<UploadSession> Find(const std::string& upload_id);
+
+    // Only one stream may write a stripe at a time; false if another already claimed it. All
+    // stripes share one writer on the part file: open_part runs for the first active stripe.
+    bool Claim(const std::shared_ptr<UploadSession>& session, uint32_t stripe, const std::function<bool()>& open_part);
+
+    // close_part runs when the last active stripe lets go. Returns true, and marks the session
+    // as committing, when the caller asked to commit and the upload is now complete; that
+    // caller must then either Remove the session or call AbortCommit.
+    bool Release(const std::shared_ptr<UploadSession>& session, uint32_t stripe, bool try_commit, const std::function<void()>& close_part);
+
+    void AbortCommit(const std::shared_ptr<UploadSession>& session);
+
+    // Records that a stripe now holds every byte up to end (an absolute file offset).
+    void Advance(const std::shared_ptr<UploadSession>& session, uint32_t stripe, uint64_t end);
+
+    // Deletes the session and whatever is left of its part file.
+    void Remove(const std::shared_ptr<UploadSession>& session);
+
+    static void StripeBounds(const UploadSession& session, uint32_t stripe, uint64_t* begin, uint64_t* end);
+
+    // Absolute offset a stripe can be resumed from.
+    uint64_t StripeCommitted(const std::shared_ptr<UploadSession>& session, uint32_t stripe);
+
+    // Bytes received across all stripes.
+    uint64_t Committed(const std::shared_ptr<UploadSession>& session);
+
+    // A fresh <id>.tmp path for a plain StoreFile to write before it is moved into place.
+    // Leftovers from a crash are deleted at the next startup.
+    std::string NewStagingPath() const;
+
+    size_t Size();
+
+private:
+    void Load();
+
+    // Caller holds mu_.
+    uint64_t StripeCommittedLocked(const UploadSession& session, uint32_t stripe) const;
+
+    std::string state_dir_;
+    std::mutex mu_;
+    std::unordered_map<std::string, std::shared_ptr<UploadSession>> sessions_;
+};
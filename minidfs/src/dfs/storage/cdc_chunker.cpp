@@ -0,0 +1,77 @@
+#include "dfs/storage/cdc_chunker.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// SplitChunks reads the input in pieces of this size.
+#define CDC_READ_SIZE (1024 * 1024)
+
+namespace {
+
+// Fixed for good: boundaries have to come out the same on every client and server.
+constexpr std::array<uint64_t, 256> MakeGearTable() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x6d696e6964667321ull;
+    for (uint64_t& entry : table) {
+        // splitmix64
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        entry = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 256> kGear = MakeGearTable();
+
+// The hash shifts left once per byte, so its top bits cover the last 64 bytes while its
+// low bits only cover the last few; the masks test the top. 2^16 is CDC_AVG_CHUNK.
+constexpr uint64_t kMaskSmall = ~uint64_t(0) << (64 - 18);
+constexpr uint64_t kMaskLarge = ~uint64_t(0) << (64 - 14);
+
+}
+
+size_t CdcCutPoint(const char* data, size_t size) {
+    if (size <= CDC_MIN_CHUNK) return size;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t normal = size < CDC_AVG_CHUNK ? size : CDC_AVG_CHUNK;
+    size_t limit = size < CDC_MAX_CHUNK ? size : CDC_MAX_CHUNK;
+
+    uint64_t hash = 0;
+    size_t i = CDC_MIN_CHUNK;
+    for (; i < normal; i++) {
+        hash = (hash << 1) + kGear[bytes[i]];
+        if (!(hash & kMaskSmall)) return i + 1;
+    }
+    for (; i < limit; i++) {
+        hash = (hash << 1) + kGear[bytes[i]];
+        if (!(hash & kMaskLarge)) return i + 1;
+    }
+    return limit;
+}
+
+bool SplitChunks(std::istream& in, const std::function<bool(const char* data, size_t size)>& on_chunk) {
+    std::vector<char> buf;
+    size_t start = 0;
+    bool eof = false;
+    while (true) {
+        if (!eof && buf.size() - start < CDC_MAX_CHUNK) {
+            buf.erase(buf.begin(), buf.begin() + start);
+            start = 0;
+            size_t old_size = buf.size();
+            buf.resize(old_size + CDC_READ_SIZE);
+            in.read(buf.data() + old_size, CDC_READ_SIZE);
+            size_t got = static_cast<size_t>(in.gcount());
+            buf.resize(old_size + got);
+            if (got < CDC_READ_SIZE) eof = true;
+            if (in.bad()) return false;
+            continue;
+        }
+        size_t available = buf.size() - start;
+        if (available == 0) return true;
+        size_t cut = CdcCutPoint(buf.data() + start, available);
+        if (!on_chunk(buf.data() + start, cut)) return false;
+        start += cut;
+    }
+}
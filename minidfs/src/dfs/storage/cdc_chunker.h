@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+
+// Content-defined chunk sizes. Boundaries depend only on nearby bytes, so an edit moves the
+// boundaries next to it and leaves every other chunk of the file, and of any other file
+// sharing that content, unchanged.
+#define CDC_MIN_CHUNK (16 * 1024)
+#define CDC_AVG_CHUNK (64 * 1024)
+#define CDC_MAX_CHUNK (256 * 1024)
+
+// FastCDC: a gear hash over the bytes, cut where its top bits are all zero. Normalized
+// chunking checks more bits before CDC_AVG_CHUNK and fewer after, which narrows the spread
+// of chunk sizes around the average. Returns the length of the first chunk of data; data
+// shorter than CDC_MAX_CHUNK is assumed to be the end of the input.
+size_t CdcCutPoint(const char* data, size_t size);
+
+// Splits everything read from in into chunks, in order. false on a read error or when
+// on_chunk returns false.
+bool SplitChunks(std::istream& in, const std::function<bool(const char* data, size_t size)>& on_chunk);
@@ -0,0 +1,281 @@
+#include "dfs/storage/chunk_store.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "dfs/storage/cdc_chunker.h"
+#include "dfs/storage/file_hash.h"
+
+namespace fs = std::filesystem;
+
+static const char* kManifestSuffix = ".manifest";
+
+// Writes beside the target and renames over it, so a crash never leaves half a file.
+static bool WriteFileAtomically(const std::string& path, const char* data, size_t size) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.write(data, static_cast<std::streamsize>(size))) {
+            out.close();
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+double ChunkStoreStats::PotentialRatio() const {
+    return unique_bytes == 0 ? 1.0 : static_cast<double>(logical_bytes) / static_cast<double>(unique_bytes);
+}
+
+std::string ChunkHash(const char* data, size_t size) {
+    IncrementalHash hash;
+    hash.Update(data, size);
+    return hash.Final();
+}
+
+ChunkStore::ChunkStore(const std::string& root, const std::string& mount_path)
+    : root_(root), mount_path_(mount_path) {
+}
+
+ChunkStore::~ChunkStore() {
+    if (worker_) {
+        Flush();
+        worker_.reset();
+    }
+}
+
+std::string ChunkStore::RootFor(const std::string& mount_path) {
+    fs::path mount = fs::path(mount_path).lexically_normal();
+    if (!mount.has_filename()) mount = mount.parent_path();
+    return mount.generic_string() + ".chunks";
+}
+
+bool ChunkStore::Enable() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!loaded_) {
+            std::error_code ec;
+            fs::create_directories(fs::path(root_) / "manifests", ec);
+            if (ec) return false;
+            Load();
+            worker_ = std::unique_ptr<ThreadPool>(new ThreadPool(1));
+            loaded_ = true;
+        }
+    }
+    enabled_.store(true);
+    return true;
+}
+
+void ChunkStore::Disable() {
+    enabled_.store(false);
+}
+
+// Caller holds mu_.
+void ChunkStore::Load() {
+    std::error_code ec;
+    fs::path manifest_dir = fs::path(root_) / "manifests";
+    for (auto it = fs::recursive_directory_iterator(manifest_dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        std::string name = it->path().generic_string();
+        if (name.size() <= strlen(kManifestSuffix) || name.compare(name.size() - strlen(kManifestSuffix), std::string::npos, kManifestSuffix) != 0) {
+            // a write cut short by a crash
+            std::error_code rm_ec;
+            fs::remove(it->path(), rm_ec);
+            continue;
+        }
+        minidfs::ChunkManifest manifest;
+        std::ifstream in(it->path(), std::ios::binary);
+        if (!manifest.ParseFromIstream(&in)) continue;
+
+        std::string key = it->path().lexically_relative(manifest_dir).generic_string();
+        key.resize(key.size() - strlen(kManifestSuffix));
+        AddLocations(key, manifest);
+        manifests_[key] = std::move(manifest);
+    }
+}
+
+void ChunkStore::AddLocations(const std::string& key, const minidfs::ChunkManifest& manifest) {
+    uint64_t offset = 0;
+    for (const minidfs::ChunkRef& ref : manifest.chunks()) {
+        ChunkEntry& entry = chunks_[ref.hash()];
+        if (entry.locations.empty()) {
+            entry.size = ref.size();
+            unique_bytes_ += ref.size();
+        }
+        entry.locations.push_back(ChunkLocation{ key, offset });
+        offset += ref.size();
+    }
+    logical_bytes_ += manifest.size();
+}
+
+void ChunkStore::RemoveLocations(const std::string& key, const minidfs::ChunkManifest& manifest) {
+    uint64_t offset = 0;
+    for (const minidfs::ChunkRef& ref : manifest.chunks()) {
+        auto it = chunks_.find(ref.hash());
+        if (it != chunks_.end()) {
+            std::vector<ChunkLocation>& locations = it->second.locations;
+            for (size_t i = 0; i < locations.size(); i++) {
+                if (locations[i].key == key && locations[i].offset == offset) {
+                    locations[i] = std::move(locations.back());
+                    locations.pop_back();
+                    break;
+                }
+            }
+            if (locations.empty()) {
+                unique_bytes_ -= it->second.size;
+                chunks_.erase(it);
+            }
+        }
+        offset += ref.size();
+    }
+    logical_bytes_ -= manifest.size();
+}
+
+void ChunkStore::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mu_);
+        pending_++;
+    }
+    worker_->Submit([this, task = std::move(task)]() {
+        task();
+        {
+            std::lock_guard<std::mutex> lock(queue_mu_);
+            pending_--;
+        }
+        idle_cv_.notify_all();
+    });
+}
+
+void ChunkStore::Ingest(const std::string& file_path) {
+    if (!Enabled()) return;
+    Submit([this, file_path]() { IngestNow(file_path); });
+}
+
+void ChunkStore::Forget(const std::string& file_path) {
+    if (!Enabled()) return;
+    Submit([this, file_path]() { ForgetNow(file_path); });
+}
+
+void ChunkStore::Flush() {
+    std::unique_lock<std::mutex> lock(queue_mu_);
+    idle_cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void ChunkStore::IngestNow(const std::string& file_path) {
+    std::string key = Key(file_path);
+    if (key.empty()) return;
+    std::ifstream in(file_path, std::ios::binary);
+    if (!in) {
+        // replaced and removed again before its turn came
+        SetManifest(key, nullptr);
+        return;
+    }
+
+    minidfs::ChunkManifest manifest;
+    uint64_t size = 0;
+    bool split = SplitChunks(in, [&](const char* data, size_t chunk_size) {
+        std::string hash = ChunkHash(data, chunk_size);
+        if (hash.empty()) return false;
+        minidfs::ChunkRef* ref = manifest.add_chunks();
+        ref->set_hash(hash);
+        ref->set_size(static_cast<uint32_t>(chunk_size));
+        size += chunk_size;
+        return true;
+    });
+    if (!split) {
+        // the old manifest no longer describes the file
+        SetManifest(key, nullptr);
+        return;
+    }
+    manifest.set_size(size);
+    SetManifest(key, &manifest);
+}
+
+void ChunkStore::ForgetNow(const std::string& file_path) {
+    std::string key = Key(file_path);
+    if (!key.empty()) SetManifest(key, nullptr);
+}
+
+void ChunkStore::SetManifest(const std::string& key, const minidfs::ChunkManifest* manifest) {
+    std::string manifest_path = ManifestPath(key);
+    bool written = false;
+    if (manifest) {
+        std::string bytes = manifest->SerializeAsString();
+        written = WriteFileAtomically(manifest_path, bytes.data(), bytes.size());
+    }
+    if (!written) {
+        // without its manifest on disk the file is not indexed at all, in memory either
+        manifest = nullptr;
+        std::error_code ec;
+        fs::remove(manifest_path, ec);
+    }
+
+    std::lock_guard<std::mutex> lock(mu_);
+    auto old = manifests_.find(key);
+    if (old != manifests_.end()) {
+        RemoveLocations(key, old->second);
+        manifests_.erase(old);
+    }
+    if (manifest) {
+        AddLocations(key, *manifest);
+        manifests_[key] = *manifest;
+    }
+}
+
+bool ChunkStore::Has(const std::string& hash) {
+    if (!Enabled()) return false;
+    std::lock_guard<std::mutex> lock(mu_);
+    return chunks_.count(hash) > 0;
+}
+
+bool ChunkStore::Get(const std::string& hash, std::string* data) {
+    uint64_t size = 0;
+    std::vector<ChunkLocation> locations;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = chunks_.find(hash);
+        if (it == chunks_.end()) return false;
+        size = it->second.size;
+        locations = it->second.locations;
+    }
+
+    data->resize(size);
+    for (const ChunkLocation& location : locations) {
+        std::ifstream in(fs::path(mount_path_) / location.key, std::ios::binary);
+        if (!in.seekg(static_cast<std::streamoff>(location.offset))) continue;
+        if (!in.read(data->data(), static_cast<std::streamsize>(size))) continue;
+        // the file may have changed since it was ingested
+        if (ChunkHash(data->data(), data->size()) == hash) return true;
+    }
+    return false;
+}
+
+ChunkStoreStats ChunkStore::Stats() {
+    ChunkStoreStats stats;
+    std::lock_guard<std::mutex> lock(mu_);
+    stats.files = manifests_.size();
+    stats.logical_bytes = logical_bytes_;
+    stats.unique_bytes = unique_bytes_;
+    stats.chunks = chunks_.size();
+    stats.reused_bytes = reused_bytes_.load();
+    return stats;
+}
+
+std::string ChunkStore::Key(const std::string& file_path) const {
+    fs::path relative = fs::absolute(file_path).lexically_normal().lexically_relative(fs::absolute(mount_path_).lexically_normal());
+    std::string key = relative.generic_string();
+    if (key.empty() || key == "." || key.rfind("..", 0) == 0) return "";
+    return key;
+}
+
+std::string ChunkStore::ManifestPath(const std::string& key) const {
+    return (fs::path(root_) / "manifests" / (key + kManifestSuffix)).string();
+}
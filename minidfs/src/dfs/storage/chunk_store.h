@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "proto_src/minidfs.pb.h"
+#include "dfs/thread_pool.h"
+
+struct ChunkStoreStats {
+    uint64_t files = 0;
+    uint64_t logical_bytes = 0;     // size of every file with a manifest
+    uint64_t chunks = 0;            // distinct chunks among them
+    uint64_t unique_bytes = 0;      // their total size
+    uint64_t reused_bytes = 0;      // bytes uploads took from the store instead of the wire
+
+    // logical_bytes / unique_bytes, 1.0 while the store is empty. What storing each distinct
+    // chunk once would save, not what the server saves: the mount still holds every file whole.
+    double PotentialRatio() const;
+};
+
+// Lowercase hex SHA-256; chunks are indexed and looked up by it.
+std::string ChunkHash(const char* data, size_t size);
+
+// Content index over the mount, kept beside it (<mount>.chunks): every committed file is split
+// into content-defined chunks (cdc_chunker.h), and manifests/<path in the mount>.manifest
+// lists a file's chunks in order. No chunk bodies are stored: the mount stays the only copy
+// of the data, and a chunk is read back from a file whose manifest has it, at the offset the
+// manifest implies, and checked against its hash. The index costs a manifest per file, a
+// few dozen bytes per 64 KB chunk, rather than a second copy of every byte.
+//
+// This deduplicates uploads, not storage: uploads use it to skip chunks the server already
+// holds under any path, but every file is still written to the mount in full. Stats measures
+// how much the files share, i.e. what chunk-level storage would save. Files changed in place (WriteFile on a GetFileLock session) or
+// outside the server are not re-ingested; their chunks then fail the hash check on Get until
+// the file is next uploaded.
+//
+// Ingest and Forget queue work for one worker thread, so one file's versions are applied in
+// commit order. Safe to use from any thread.
+class ChunkStore {
+public:
+    ChunkStore(const std::string& root, const std::string& mount_path);
+
+    // Finishes queued work.
+    ~ChunkStore();
+
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+
+    static std::string RootFor(const std::string& mount_path);
+
+    // The first call loads the manifests. Until then, and after Disable, Ingest and Forget do
+    // nothing and Has is always false.
+    bool Enable();
+    void Disable();
+    bool Enabled() const { return enabled_.load(); }
+
+    // file_path is a committed file inside the mount.
+    void Ingest(const std::string& file_path);
+    void Forget(const std::string& file_path);
+
+    // Waits until every queued Ingest and Forget has been applied.
+    void Flush();
+
+    bool Has(const std::string& hash);
+
+    // Reads the chunk from a file that had it when it was ingested. false if no such file
+    // still holds it unchanged.
+    bool Get(const std::string& hash, std::string* data);
+
+    void CountReused(uint64_t bytes) { reused_bytes_.fetch_add(bytes); }
+
+    ChunkStoreStats Stats();
+
+private:
+    // One place a chunk occurs: a file (by key) and the offset within it.
+    struct ChunkLocation {
+        std::string key;
+        uint64_t offset;
+    };
+
+    struct ChunkEntry {
+        uint64_t size = 0;
+        // one per reference in a manifest
+        std::vector<ChunkLocation> locations;
+    };
+
+    void Load();
+    void Submit(std::function<void()> task);
+    void IngestNow(const std::string& file_path);
+    void ForgetNow(const std::string& file_path);
+    // Replaces key's manifest (or drops it, for nullptr) and updates the index.
+    void SetManifest(const std::string& key, const minidfs::ChunkManifest* manifest);
+
+    // Caller holds mu_.
+    void AddLocations(const std::string& key, const minidfs::ChunkManifest& manifest);
+    void RemoveLocations(const std::string& key, const minidfs::ChunkManifest& manifest);
+
+    // The file's path relative to the mount; "" outside it.
+    std::string Key(const std::string& file_path) const;
+    std::string ManifestPath(const std::string& key) const;
+
+    std::string root_;
+    std::string mount_path_;
+    std::atomic<bool> enabled_{false};
+    bool loaded_ = false;
+    std::atomic<uint64_t> reused_bytes_{0};
+
+    std::mutex mu_;
+    std::unordered_map<std::string, ChunkEntry> chunks_;
+    std::unordered_map<std::string, minidfs::ChunkManifest> manifests_;
+    uint64_t logical_bytes_ = 0;
+    uint64_t unique_bytes_ = 0;
+
+    std::mutex queue_mu_;
+    std::condition_variable idle_cv_;
+    size_t pending_ = 0;
+    // one thread, so work on a file is applied in the order it was queued
+    std::unique_ptr<ThreadPool> worker_;
+};
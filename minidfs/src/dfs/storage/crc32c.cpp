@@ -0,0 +1,204 @@
+#include "dfs/storage/crc32c.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MINIDFS_CRC32C_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define MINIDFS_CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+namespace {
+
+// reflected Castagnoli polynomial
+constexpr uint32_t kPoly = 0x82f63b78;
+
+struct Crc32cTables {
+    uint32_t t[8][256];
+
+    constexpr Crc32cTables() : t{} {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t crc = n;
+            for (int k = 0; k < 8; k++) {
+                crc = crc & 1 ? (crc >> 1) ^ kPoly : crc >> 1;
+            }
+            t[0][n] = crc;
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            for (int k = 1; k < 8; k++) {
+                t[k][n] = (t[k - 1][n] >> 8) ^ t[0][t[k - 1][n] & 0xff];
+            }
+        }
+    }
+};
+
+constexpr Crc32cTables kTables;
+
+// Raw register update: no pre- or post-inversion.
+uint32_t UpdatePortable(uint32_t crc, const unsigned char* p, size_t size) {
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        // the tables index bytes in stream order, which is little-endian word order
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        word ^= crc;
+        crc = kTables.t[7][word & 0xff] ^ kTables.t[6][(word >> 8) & 0xff] ^
+              kTables.t[5][(word >> 16) & 0xff] ^ kTables.t[4][(word >> 24) & 0xff] ^
+              kTables.t[3][(word >> 32) & 0xff] ^ kTables.t[2][(word >> 40) & 0xff] ^
+              kTables.t[1][(word >> 48) & 0xff] ^ kTables.t[0][word >> 56];
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = (crc >> 8) ^ kTables.t[0][(crc ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+#ifdef MINIDFS_CRC32C_X86
+
+// Bytes per lane when three lanes run interleaved; long enough that merging them is cheap
+// next to the work saved, short enough that a 40 KB chunk still splits.
+constexpr size_t kLane = 4096;
+
+// a * b mod P on reflected polynomials (bit 31 is x^0)
+uint32_t MultModP(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ kPoly : b >> 1;
+    }
+    return p;
+}
+
+// x^n mod P, reflected
+uint32_t XPowModP(uint64_t n) {
+    uint32_t result = 1u << 31;
+    uint32_t square = 1u << 30;
+    while (n) {
+        if (n & 1) result = MultModP(result, square);
+        square = MultModP(square, square);
+        n >>= 1;
+    }
+    return result;
+}
+
+// A carry-less product of two reflected 32-bit values comes out multiplied by x, and the
+// crc32 instruction multiplies by x^32 on the way to reducing it; so shifting a register
+// over kLane zero bytes is one PCLMUL by x^(8 * kLane - 33) and one crc32.
+const uint32_t kLaneShift = XPowModP(8 * kLane - 33);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MINIDFS_CRC32C_TARGET __attribute__((target("sse4.2,pclmul")))
+#else
+#define MINIDFS_CRC32C_TARGET
+#endif
+
+MINIDFS_CRC32C_TARGET
+uint32_t ShiftLane(uint32_t crc) {
+    __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128(static_cast<int>(crc)),
+        _mm_cvtsi32_si128(static_cast<int>(kLaneShift)), 0);
+    return static_cast<uint32_t>(_mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product))));
+}
+
+MINIDFS_CRC32C_TARGET
+uint32_t UpdateHardware(uint32_t crc, const unsigned char* p, size_t size) {
+    uint64_t crc0 = crc;
+    // three independent dependency chains keep the crc32 unit busy; its latency is three cycles
+    while (size >= 3 * kLane) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        for (size_t i = 0; i < kLane; i += 8) {
+            uint64_t w0, w1, w2;
+            std::memcpy(&w0, p + i, 8);
+            std::memcpy(&w1, p + kLane + i, 8);
+            std::memcpy(&w2, p + 2 * kLane + i, 8);
+            crc0 = _mm_crc32_u64(crc0, w0);
+            crc1 = _mm_crc32_u64(crc1, w1);
+            crc2 = _mm_crc32_u64(crc2, w2);
+        }
+        crc0 = ShiftLane(static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = ShiftLane(static_cast<uint32_t>(crc0)) ^ crc2;
+        p += 3 * kLane;
+        size -= 3 * kLane;
+    }
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc0 = _mm_crc32_u64(crc0, word);
+        p += 8;
+        size -= 8;
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc0);
+    while (size--) {
+        crc32 = _mm_crc32_u8(crc32, *p++);
+    }
+    return crc32;
+}
+
+bool DetectHardware() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) && (info[2] & (1 << 1));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul");
+#endif
+}
+
+const bool kHardware = DetectHardware();
+
+#elif defined(MINIDFS_CRC32C_ARM)
+
+uint32_t UpdateHardware(uint32_t crc, const unsigned char* p, size_t size) {
+    while (size >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+        p += 8;
+        size -= 8;
+    }
+    while (size--) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+}
+
+const bool kHardware = true;
+
+#endif
+
+} // namespace
+
+uint32_t Crc32cPortable(const void* data, size_t size, uint32_t crc) {
+    return ~UpdatePortable(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+uint32_t Crc32c(const void* data, size_t size, uint32_t crc) {
+#if defined(MINIDFS_CRC32C_X86) || defined(MINIDFS_CRC32C_ARM)
+    if (kHardware) {
+        return ~UpdateHardware(~crc, static_cast<const unsigned char*>(data), size);
+    }
+#endif
+    return Crc32cPortable(data, size, crc);
+}
+
+bool Crc32cAccelerated() {
+#if defined(MINIDFS_CRC32C_X86) || defined(MINIDFS_CRC32C_ARM)
+    return kHardware;
+#else
+    return false;
+#endif
+}
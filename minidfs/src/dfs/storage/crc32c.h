@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32C (Castagnoli) of size bytes, continuing from crc: Crc32c(b, n, Crc32c(a, m)) is the
+// checksum of a followed by b. Uses the SSE4.2 crc32 instruction with PCLMUL to merge three
+// interleaved streams on x86-64 CPUs that have them, the ARMv8 CRC instructions where the
+// compiler targets them, and a slicing-by-8 table everywhere else.
+uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+// True when Crc32c runs on CPU instructions rather than the table fallback.
+bool Crc32cAccelerated();
+
+// The table implementation, always available; for checking the accelerated paths against.
+uint32_t Crc32cPortable(const void* data, size_t size, uint32_t crc = 0);
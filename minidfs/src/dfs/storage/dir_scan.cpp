@@ -0,0 +1,161 @@
+#include "dfs/storage/dir_scan.h"
+#include <chrono>
+#include <filesystem>
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#if defined(STATX_BASIC_STATS) && defined(SYS_getdents64)
+#define MINIDFS_STATX_SCAN 1
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+#ifdef MINIDFS_STATX_SCAN
+namespace {
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    bool StatxEntry(int dir_fd, const char* name, unsigned char d_type, DirEntryInfo* info) {
+        struct statx stx;
+        unsigned int mask = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_INO;
+        if (d_type == DT_UNKNOWN) {
+            // some filesystems leave d_type blank; only then does a link check cost a second call
+            if (::statx(dir_fd, name, AT_SYMLINK_NOFOLLOW, STATX_TYPE, &stx) != 0) return false;
+            info->is_symlink = S_ISLNK(stx.stx_mode);
+        } else {
+            info->is_symlink = d_type == DT_LNK;
+        }
+
+        // follow symlinks like fs::directory_entry; a dangling one is reported as itself
+        if (::statx(dir_fd, name, 0, mask, &stx) != 0 &&
+            ::statx(dir_fd, name, AT_SYMLINK_NOFOLLOW, mask, &stx) != 0) {
+            return false;
+        }
+
+        info->is_dir = S_ISDIR(stx.stx_mode);
+        info->size = info->is_dir ? 0 : stx.stx_size;
+        info->mtime_ns = static_cast<int64_t>(stx.stx_mtime.tv_sec) * 1000000000 + stx.stx_mtime.tv_nsec;
+        info->dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+        info->ino = stx.stx_ino;
+        return true;
+    }
+}
+#endif
+
+#ifndef MINIDFS_STATX_SCAN
+static int64_t ToUnixNanos(fs::file_time_type mtime) {
+    auto sys_time = std::chrono::file_clock::to_sys(mtime);
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sys_time.time_since_epoch()).count());
+}
+
+static void FillFromEntry(const fs::directory_entry& entry, DirEntryInfo* info, std::error_code& ec) {
+    info->is_dir = entry.is_directory(ec);
+    if (!info->is_dir) {
+        info->size = entry.file_size(ec);
+        if (ec) info->size = 0;
+    }
+    auto mtime = entry.last_write_time(ec);
+    if (!ec) info->mtime_ns = ToUnixNanos(mtime);
+}
+#endif
+
+DirScanner::DirScanner(const std::string& dir_path) {
+#ifdef MINIDFS_STATX_SCAN
+    dir_fd_ = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    failed_ = dir_fd_ < 0;
+    if (!failed_) buffer_.resize(DIR_SCAN_BUFFER_SIZE);
+#else
+    std::error_code ec;
+    it_ = fs::directory_iterator(dir_path, ec);
+    failed_ = static_cast<bool>(ec);
+#endif
+}
+
+DirScanner::~DirScanner() {
+#ifdef MINIDFS_STATX_SCAN
+    if (dir_fd_ >= 0) ::close(dir_fd_);
+#endif
+}
+
+size_t DirScanner::Next(std::vector<DirEntryInfo>* entries, size_t max_entries) {
+    size_t added = 0;
+    if (failed_) return 0;
+
+#ifdef MINIDFS_STATX_SCAN
+    while (added < max_entries) {
+        if (buffer_pos_ >= buffer_len_) {
+            long n = ::syscall(SYS_getdents64, dir_fd_, buffer_.data(), buffer_.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                failed_ = true;
+                break;
+            }
+            if (n == 0) break;
+            buffer_pos_ = 0;
+            buffer_len_ = n;
+        }
+
+        auto* d = reinterpret_cast<LinuxDirent64*>(buffer_.data() + buffer_pos_);
+        buffer_pos_ += d->d_reclen;
+        if (std::strcmp(d->d_name, ".") == 0 || std::strcmp(d->d_name, "..") == 0) continue;
+
+        DirEntryInfo info;
+        // entries removed between the two calls are simply skipped
+        if (!StatxEntry(dir_fd_, d->d_name, d->d_type, &info)) continue;
+        info.name = d->d_name;
+        entries->push_back(std::move(info));
+        added++;
+    }
+#else
+    std::error_code ec;
+    for (; added < max_entries && it_ != fs::directory_iterator(); it_.increment(ec)) {
+        if (ec) {
+            failed_ = true;
+            break;
+        }
+        const fs::directory_entry& entry = *it_;
+        DirEntryInfo info;
+        info.name = entry.path().filename().string();
+        info.is_symlink = entry.is_symlink(ec);
+        FillFromEntry(entry, &info, ec);
+        entries->push_back(std::move(info));
+        added++;
+    }
+    if (ec) failed_ = true;
+#endif
+    return added;
+}
+
+bool ScanDirectory(const std::string& dir_path, std::vector<DirEntryInfo>* entries) {
+    DirScanner scanner(dir_path);
+    while (scanner.Next(entries, SIZE_MAX) > 0) {}
+    return !scanner.Failed();
+}
+
+bool StatEntry(const std::string& path, DirEntryInfo* info) {
+#ifdef MINIDFS_STATX_SCAN
+    // a known type skips StatxEntry's link check, which only feeds is_symlink
+    bool is_symlink = info->is_symlink;
+    bool ok = StatxEntry(AT_FDCWD, path.c_str(), DT_REG, info);
+    info->is_symlink = is_symlink;
+    return ok;
+#else
+    std::error_code ec;
+    fs::directory_entry entry(path, ec);
+    if (ec || !entry.exists(ec)) return false;
+    FillFromEntry(entry, info, ec);
+    return !ec;
+#endif
+}
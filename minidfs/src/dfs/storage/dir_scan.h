@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Size of the buffer handed to each getdents64 call; one call returns a few hundred entries.
+#define DIR_SCAN_BUFFER_SIZE 64 * 1024
+
+struct DirEntryInfo {
+    std::string name;
+    bool is_dir = false;
+    // set for symlinks even though the other fields describe the target
+    bool is_symlink = false;
+    uint64_t size = 0;
+    // nanoseconds since the Unix epoch, negative before it
+    int64_t mtime_ns = 0;
+    // identity for HashCache; both stay 0 where the scan cannot provide them
+    uint64_t dev = 0;
+    uint64_t ino = 0;
+};
+
+// Reads one directory (not recursively) a batch at a time, with every entry's type, size and
+// mtime. On Linux this is getdents64 plus one statx per entry; elsewhere it walks
+// std::filesystem. Symlinks report their target, like fs::directory_entry.
+class DirScanner {
+public:
+    explicit DirScanner(const std::string& dir_path);
+    ~DirScanner();
+
+    DirScanner(const DirScanner&) = delete;
+    DirScanner& operator=(const DirScanner&) = delete;
+
+    // Appends up to max_entries entries and returns how many were added; 0 means the
+    // directory is exhausted, or that reading it failed (see Failed).
+    size_t Next(std::vector<DirEntryInfo>* entries, size_t max_entries);
+
+    bool Failed() const { return failed_; }
+
+private:
+    bool failed_ = false;
+#if defined(__linux__)
+    int dir_fd_ = -1;
+    std::vector<char> buffer_;
+    long buffer_pos_ = 0;
+    long buffer_len_ = 0;
+#endif
+    std::filesystem::directory_iterator it_;
+};
+
+// Fills in one entry's fields for path, following symlinks; name and is_symlink are left
+// alone. Returns false if it can't be stat'ed.
+bool StatEntry(const std::string& path, DirEntryInfo* info);
+
+// Reads the whole directory at once. Returns false if it can't be read.
+bool ScanDirectory(const std::string& dir_path, std::vector<DirEntryInfo>* entries);
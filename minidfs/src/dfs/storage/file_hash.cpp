@@ -0,0 +1,94 @@
+#include "dfs/storage/file_hash.h"
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <openssl/evp.h>
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/xattr.h>
+#define MINIDFS_XATTR 1
+#endif
+
+namespace fs = std::filesystem;
+
+static const char* kHashAttr = "user.minidfs.sha256";
+
+IncrementalHash::IncrementalHash() {
+    ctx_ = EVP_MD_CTX_new();
+    ok_ = ctx_ && EVP_DigestInit_ex(ctx_, EVP_sha256(), nullptr) == 1;
+}
+
+IncrementalHash::~IncrementalHash() {
+    if (ctx_) EVP_MD_CTX_free(ctx_);
+}
+
+bool IncrementalHash::Update(const void* data, size_t size) {
+    if (ok_ && size > 0) {
+        ok_ = EVP_DigestUpdate(ctx_, data, size) == 1;
+    }
+    return ok_;
+}
+
+std::string IncrementalHash::Final() {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+    if (!ok_ || EVP_DigestFinal_ex(ctx_, hash, &hash_len) != 1) {
+        ok_ = false;
+        return "";
+    }
+    ok_ = false;
+
+    std::stringstream ss;
+    for (unsigned int i = 0; i < hash_len; i++) {
+        ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+    }
+    return ss.str();
+}
+
+// "<size> <mtime ticks>", the part of the attribute that ties a digest to one file version
+static bool FileStamp(const std::string& file_path, std::string* stamp) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(file_path, ec);
+    if (ec) return false;
+    auto mtime = fs::last_write_time(file_path, ec);
+    if (ec) return false;
+
+    *stamp = std::to_string(size) + " " + std::to_string(mtime.time_since_epoch().count());
+    return true;
+}
+
+bool SaveStoredHash(const std::string& file_path, const std::string& hash) {
+#ifdef MINIDFS_XATTR
+    std::string stamp;
+    if (hash.empty() || !FileStamp(file_path, &stamp)) return false;
+
+    std::string value = hash + " " + stamp;
+#ifdef __APPLE__
+    return ::setxattr(file_path.c_str(), kHashAttr, value.data(), value.size(), 0, 0) == 0;
+#else
+    return ::setxattr(file_path.c_str(), kHashAttr, value.data(), value.size(), 0) == 0;
+#endif
+#else
+    return false;
+#endif
+}
+
+std::string LoadStoredHash(const std::string& file_path) {
+#ifdef MINIDFS_XATTR
+    char value[256];
+#ifdef __APPLE__
+    ssize_t len = ::getxattr(file_path.c_str(), kHashAttr, value, sizeof(value), 0, 0);
+#else
+    ssize_t len = ::getxattr(file_path.c_str(), kHashAttr, value, sizeof(value));
+#endif
+    if (len <= 0) return "";
+
+    std::string stored(value, static_cast<size_t>(len));
+    size_t split = stored.find(' ');
+    std::string stamp;
+    if (split == std::string::npos || !FileStamp(file_path, &stamp)) return "";
+    if (stored.compare(split + 1, std::string::npos, stamp) != 0) return "";
+    return stored.substr(0, split);
+#else
+    return "";
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+// SHA-256 fed one chunk at a time, for hashing a file while it streams in.
+class IncrementalHash {
+public:
+    IncrementalHash();
+    ~IncrementalHash();
+
+    IncrementalHash(const IncrementalHash&) = delete;
+    IncrementalHash& operator=(const IncrementalHash&) = delete;
+
+    bool Update(const void* data, size_t size);
+
+    // Lowercase hex digest, or "" if any step failed. The context cannot be reused.
+    std::string Final();
+
+private:
+    EVP_MD_CTX* ctx_ = nullptr;
+    bool ok_ = false;
+};
+
+// A digest kept as file metadata (the user.minidfs.sha256 xattr) together with the size
+// and mtime it was computed for, so a file modified behind the server's back never
+// serves a stale hash. Both are no-ops where xattrs are unsupported.
+bool SaveStoredHash(const std::string& file_path, const std::string& hash);
+
+// Returns "" when there is no stored digest or it no longer matches the file.
+std::string LoadStoredHash(const std::string& file_path);
@@ -0,0 +1,289 @@
+#include "dfs/storage/hash_cache.h"
+#include "dfs/file_manager.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#ifdef MINIDFS_POSIX_IO
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// On-disk layout: magic, then fixed-size records up to the end of the file, each
+// dev, ino, size, mtime_ns (little-endian u64/i64 as written by this host) and the raw digest.
+// Records are replayed in order, so later ones count as more recently used; keys may repeat,
+// and evicted ones stay until the next compaction.
+static const char kIndexMagic[8] = { 'M', 'D', 'F', 'S', 'H', 'C', '0', '2' };
+
+struct IndexRecord {
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_ns;
+    unsigned char digest[32];
+};
+
+size_t HashCacheKeyHasher::operator()(const HashCacheKey& key) const {
+    size_t h = std::hash<uint64_t>{}(key.ino);
+    h ^= std::hash<uint64_t>{}(key.dev) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= std::hash<uint64_t>{}(key.size) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= std::hash<int64_t>{}(key.mtime_ns) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+static bool HexToDigest(const std::string& hex, unsigned char* out) {
+    if (hex.size() != 64) return false;
+    for (size_t i = 0; i < 32; i++) {
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        };
+        int hi = nibble(hex[2 * i]);
+        int lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<unsigned char>(hi << 4 | lo);
+    }
+    return true;
+}
+
+static std::string DigestToHex(const unsigned char* digest) {
+    static const char* kHex = "0123456789abcdef";
+    std::string hex(64, '0');
+    for (size_t i = 0; i < 32; i++) {
+        hex[2 * i] = kHex[digest[i] >> 4];
+        hex[2 * i + 1] = kHex[digest[i] & 0xf];
+    }
+    return hex;
+}
+
+HashCache::HashCache(const std::string& index_path, size_t max_entries)
+    : index_path_(index_path), max_entries_(max_entries) {
+    Load();
+}
+
+HashCache::~HashCache() {
+    Save();
+}
+
+std::string HashCache::IndexPathFor(const std::string& mount_path) {
+    fs::path mount = fs::absolute(mount_path).lexically_normal();
+    if (!mount.has_filename()) mount = mount.parent_path();
+    mount += ".hashcache";
+    return mount.string();
+}
+
+bool HashCache::StatKey(const std::string& file_path, HashCacheKey* key) {
+#ifdef MINIDFS_POSIX_IO
+    struct stat st;
+    if (::stat(file_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    key->dev = static_cast<uint64_t>(st.st_dev);
+    key->ino = static_cast<uint64_t>(st.st_ino);
+    key->size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    key->mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    key->mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+#else
+    // no inode numbers through std::filesystem; the absolute path stands in for (dev, ino)
+    std::error_code ec;
+    if (!fs::is_regular_file(file_path, ec)) return false;
+    key->size = fs::file_size(file_path, ec);
+    if (ec) return false;
+    key->mtime_ns = static_cast<int64_t>(fs::last_write_time(file_path, ec).time_since_epoch().count());
+    if (ec) return false;
+    key->ino = std::hash<std::string>{}(fs::absolute(file_path).generic_string());
+    return true;
+#endif
+}
+
+std::string HashCache::GetFileHash(const std::string& file_path) {
+    HashCacheKey key;
+    if (!StatKey(file_path, &key)) return FileManager::GetFileHash(file_path);
+    return GetFileHash(file_path, key);
+}
+
+std::string HashCache::GetFileHash(const std::string& file_path, const HashCacheKey& key) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            hits_++;
+            lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+            return DigestToHex(it->second.digest.data());
+        }
+    }
+    misses_++;
+
+    // hash outside the lock; concurrent misses on the same file just compute it twice
+    std::string hash = FileManager::GetFileHash(file_path);
+    HashCacheKey after;
+    Digest digest;
+    // a file that changed while it was being read is not cached under either version
+    if (!StatKey(file_path, &after) || !(after == key) || !HexToDigest(hash, digest.data())) return hash;
+
+    bool flush = false;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (Insert(key, digest)) {
+            pending_.emplace_back(key, digest);
+            flush = pending_.size() >= HASH_CACHE_FLUSH_INTERVAL;
+        }
+    }
+    if (flush) Flush();
+    return hash;
+}
+
+bool HashCache::Insert(const HashCacheKey& key, const Digest& digest) {
+    if (max_entries_ == 0) return false;
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+        return false;
+    }
+    while (entries_.size() >= max_entries_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{ digest, lru_.begin() });
+    return true;
+}
+
+size_t HashCache::Size() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return entries_.size();
+}
+
+bool HashCache::Load() {
+    std::ifstream in(index_path_, std::ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(kIndexMagic)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, kIndexMagic, sizeof(kIndexMagic)) != 0) {
+        std::cerr << "Ignoring unreadable hash cache at " << index_path_ << std::endl;
+        // replaced by the first flush rather than appended to
+        std::lock_guard<std::mutex> save_lock(save_mu_);
+        compact_needed_ = true;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> save_lock(save_mu_);
+    std::lock_guard<std::mutex> lock(mu_);
+    IndexRecord record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        HashCacheKey key{ record.dev, record.ino, record.size, record.mtime_ns };
+        Digest digest;
+        std::memcpy(digest.data(), record.digest, digest.size());
+        // records run oldest first, so each one loaded becomes the most recently used
+        Insert(key, digest);
+        log_records_++;
+    }
+    in.close();
+
+    // a crash mid-append leaves part of a record; cut it off so later appends stay aligned
+    std::error_code ec;
+    uint64_t valid = sizeof(kIndexMagic) + log_records_ * sizeof(IndexRecord);
+    if (fs::file_size(index_path_, ec) != valid && !ec) fs::resize_file(index_path_, valid, ec);
+    return true;
+}
+
+void HashCache::Flush() {
+    std::lock_guard<std::mutex> save_lock(save_mu_);
+    size_t live;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        live = entries_.size();
+    }
+    // rewriting only once stale records match the live ones keeps the total written linear
+    if (compact_needed_ || log_records_ >= 2 * live + HASH_CACHE_FLUSH_INTERVAL) {
+        CompactLocked();
+    } else {
+        AppendLocked();
+    }
+}
+
+bool HashCache::AppendLocked() {
+    std::vector<IndexRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        records.reserve(pending_.size());
+        for (const auto& [key, digest] : pending_) {
+            IndexRecord record{ key.dev, key.ino, key.size, key.mtime_ns, {} };
+            std::memcpy(record.digest, digest.data(), digest.size());
+            records.push_back(record);
+        }
+        pending_.clear();
+    }
+    if (records.empty()) return true;
+
+    std::error_code ec;
+    bool fresh = !fs::exists(index_path_, ec);
+    {
+        std::ofstream out(index_path_, std::ios::binary | std::ios::app);
+        if (fresh) out.write(kIndexMagic, sizeof(kIndexMagic));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(IndexRecord));
+        out.close();
+        if (out) {
+            if (fresh) log_records_ = 0;
+            log_records_ += records.size();
+            return true;
+        }
+    }
+
+    // the file may now end in a partial record; a rewrite puts it right
+    std::cerr << "Failed to append to hash cache at " << index_path_ << std::endl;
+    return CompactLocked();
+}
+
+bool HashCache::Save() {
+    std::lock_guard<std::mutex> save_lock(save_mu_);
+    return CompactLocked();
+}
+
+bool HashCache::CompactLocked() {
+    std::vector<IndexRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        std::error_code ec;
+        if (!compact_needed_ && pending_.empty() && log_records_ == entries_.size() && fs::exists(index_path_, ec)) {
+            return true;
+        }
+        pending_.clear();
+        records.reserve(entries_.size());
+        for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) {
+            const Digest& digest = entries_.at(*it).digest;
+            IndexRecord record{ it->dev, it->ino, it->size, it->mtime_ns, {} };
+            std::memcpy(record.digest, digest.data(), digest.size());
+            records.push_back(record);
+        }
+    }
+
+    // write-then-rename so a crash mid-save leaves the previous index intact
+    std::string tmp_path = index_path_ + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(kIndexMagic, sizeof(kIndexMagic));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(IndexRecord));
+        if (out) {
+            out.close();
+            std::error_code ec;
+            fs::rename(tmp_path, index_path_, ec);
+            if (!ec) {
+                log_records_ = records.size();
+                compact_needed_ = false;
+                return true;
+            }
+        }
+    }
+
+    std::cerr << "Failed to save hash cache to " << index_path_ << std::endl;
+    // the entries pending before this call are on disk nowhere; the next flush retries them all
+    compact_needed_ = true;
+    return false;
+}
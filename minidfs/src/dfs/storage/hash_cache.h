@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Append new entries to the index after this many, so a crash loses at most this much work.
+#define HASH_CACHE_FLUSH_INTERVAL 256
+// Entries for deleted or rewritten files are never looked up again; past this many the least
+// recently used ones are evicted rather than growing without bound (about 100 bytes per entry).
+#define HASH_CACHE_MAX_ENTRIES (1 << 20)
+
+// Identifies one version of one file without reading it. Any write moves mtime (and
+// usually size), and a replaced file gets a new inode, so a key never outlives its contents.
+struct HashCacheKey {
+    uint64_t dev = 0;
+    uint64_t ino = 0;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+
+    bool operator==(const HashCacheKey& other) const {
+        return dev == other.dev && ino == other.ino && size == other.size && mtime_ns == other.mtime_ns;
+    }
+};
+
+struct HashCacheKeyHasher {
+    size_t operator()(const HashCacheKey& key) const;
+};
+
+// Server-side SHA-256 cache for every file it lists, including ones written outside StoreFile.
+// Entries are filled lazily on lookup and appended in batches to a binary index that is
+// replayed at startup. The index is only rewritten once evicted and repeated records make up
+// half of it, and at shutdown, so a cold scan of many files writes each record about twice.
+// Holds at most max_entries, evicting the least recently used. Safe to use from any thread.
+class HashCache {
+public:
+    explicit HashCache(const std::string& index_path, size_t max_entries = HASH_CACHE_MAX_ENTRIES);
+
+    // Compacts the index.
+    ~HashCache();
+
+    HashCache(const HashCache&) = delete;
+    HashCache& operator=(const HashCache&) = delete;
+
+    // One stat on a hit; on a miss falls back to FileManager::GetFileHash and remembers the result.
+    std::string GetFileHash(const std::string& file_path);
+
+    // For callers that already stat'ed the file (a directory scan): skips the lookup stat.
+    std::string GetFileHash(const std::string& file_path, const HashCacheKey& key);
+
+    // Rewrites the index file (atomically, via rename) with exactly the cached entries, least
+    // recently used first, unless it already holds just those.
+    bool Save();
+
+    uint64_t Hits() const { return hits_.load(); }
+    uint64_t Misses() const { return misses_.load(); }
+    size_t Size();
+
+    // Derives the index location for a mount: a sibling file, so it never shows up in listings.
+    static std::string IndexPathFor(const std::string& mount_path);
+
+private:
+    using Digest = std::array<unsigned char, 32>;
+
+    struct Entry {
+        Digest digest;
+        std::list<HashCacheKey>::iterator lru_it;
+    };
+
+    static bool StatKey(const std::string& file_path, HashCacheKey* key);
+    bool Load();
+    // Appends the pending entries, compacting instead once the index is mostly stale.
+    void Flush();
+    // Caller holds save_mu_.
+    bool AppendLocked();
+    bool CompactLocked();
+    // Caller holds mu_. Makes key the most recently used; false if it was already cached.
+    bool Insert(const HashCacheKey& key, const Digest& digest);
+
+    std::string index_path_;
+    std::mutex save_mu_;
+    // records in the index file, stale ones included, and whether it lacks entries that are no
+    // longer pending; both guarded by save_mu_
+    uint64_t log_records_ = 0;
+    bool compact_needed_ = false;
+    size_t max_entries_;
+    std::mutex mu_;
+    // front is most recently used
+    std::list<HashCacheKey> lru_;
+    std::unordered_map<HashCacheKey, Entry, HashCacheKeyHasher> entries_;
+    // inserted since the last append
+    std::vector<std::pair<HashCacheKey, Digest>> pending_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
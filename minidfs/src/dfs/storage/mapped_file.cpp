@@ -0,0 +1,40 @@
+#include "dfs/storage/mapped_file.h"
+#ifdef MINIDFS_MMAP_IO
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const MappedFile> MappedFile::Map(int fd, const std::string& path) {
+#ifdef MINIDFS_MMAP_IO
+    int own_fd = -1;
+    if (fd < 0) {
+        own_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (own_fd < 0) return nullptr;
+        fd = own_fd;
+    }
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // the mapping keeps the file referenced on its own
+    if (own_fd >= 0) ::close(own_fd);
+    if (data == MAP_FAILED) return nullptr;
+
+    ::madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    return std::shared_ptr<const MappedFile>(new MappedFile(static_cast<const char*>(data), static_cast<size_t>(st.st_size)));
+#else
+    (void)fd;
+    (void)path;
+    return nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef MINIDFS_MMAP_IO
+    ::munmap(const_cast<char*>(data_), size_);
+#endif
+}
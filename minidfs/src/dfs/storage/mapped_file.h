@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MINIDFS_MMAP_IO 1
+#endif
+
+// A read-only, shared mapping of a whole file. Unmapped when the last reference goes, so
+// anything still pointing into it (a gRPC slice on its way to the socket) keeps it alive.
+class MappedFile {
+public:
+    // Maps fd's file, or the file at path when fd is negative. Returns nullptr for empty
+    // files, on failure, and on platforms without mmap.
+    static std::shared_ptr<const MappedFile> Map(int fd, const std::string& path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    MappedFile(const char* data, size_t size) : data_(data), size_(size) {}
+
+    const char* data_;
+    size_t size_;
+};
@@ -0,0 +1,167 @@
+#include "dfs/storage/tree_walk.h"
+
+namespace fs = std::filesystem;
+
+bool GlobMatch(const std::string& pattern, const std::string& name) {
+    size_t p = 0, n = 0;
+    size_t star = std::string::npos, resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            p++;
+            n++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        } else if (star != std::string::npos) {
+            // let the last '*' swallow one more character and retry
+            p = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') p++;
+    return p == pattern.size();
+}
+
+std::shared_ptr<TreeWalk> TreeWalk::Start(ThreadPool* pool, const fs::path& root, const fs::path& virtual_root,
+    const TreeWalkOptions& options, size_t max_buffered, FillFn fill, std::function<void()> on_ready)
+{
+    std::shared_ptr<TreeWalk> walk(new TreeWalk());
+    walk->pool_ = pool;
+    walk->options_ = options;
+    walk->max_buffered_ = max_buffered;
+    walk->fill_ = std::move(fill);
+    walk->on_ready_ = std::move(on_ready);
+
+    auto root_item = std::make_shared<WalkItem>();
+    root_item->dir_path = root;
+    root_item->virtual_dir = virtual_root;
+    std::vector<std::shared_ptr<WalkItem>> items{ root_item };
+    walk->outstanding_ = 1;
+    walk->Schedule(items);
+    return walk;
+}
+
+void TreeWalk::Schedule(std::vector<std::shared_ptr<WalkItem>>& items) {
+    std::shared_ptr<TreeWalk> self = shared_from_this();
+    for (auto& item : items) {
+        pool_->Submit([self, item] { self->Process(item); });
+    }
+}
+
+bool TreeWalk::Matches(const DirEntryInfo& entry) const {
+    if (options_.modified_since != 0 && (entry.is_dir || entry.mtime_ns <= options_.modified_since)) return false;
+    return options_.name_glob.empty() || GlobMatch(options_.name_glob, entry.name);
+}
+
+void TreeWalk::Process(const std::shared_ptr<WalkItem>& item) {
+    std::vector<DirEntryInfo> entries;
+    bool root = item->depth == 0;
+    bool more = false;
+    bool scan_failed = false;
+
+    if (!cancelled_) {
+        if (!item->scanner) item->scanner = std::make_unique<DirScanner>(item->dir_path.string());
+        more = item->scanner->Next(&entries, TREE_WALK_BATCH) > 0;
+        // an unreadable subdirectory is skipped; only the root fails the walk
+        scan_failed = root && item->scanner->Failed();
+    }
+
+    std::vector<minidfs::FileInfo> matched;
+    std::vector<std::shared_ptr<WalkItem>> children;
+    for (const DirEntryInfo& entry : entries) {
+        // never follow symlinked directories, so a link cycle can't trap the walk
+        if (entry.is_dir && !entry.is_symlink && (options_.max_depth == 0 || item->depth + 1 < options_.max_depth)) {
+            auto child = std::make_shared<WalkItem>();
+            child->dir_path = item->dir_path / entry.name;
+            child->virtual_dir = item->virtual_dir / entry.name;
+            child->depth = item->depth + 1;
+            children.push_back(std::move(child));
+        }
+        if (Matches(entry)) {
+            matched.emplace_back();
+            fill_(item->dir_path, item->virtual_dir, entry, &matched.back());
+        }
+    }
+    // keep reading this directory after its children, so the walk stays roughly depth-first
+    if (more) children.push_back(item);
+
+    std::vector<std::shared_ptr<WalkItem>> runnable;
+    std::function<void()> ready;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (scan_failed) failed_ = true;
+        for (auto& info : matched) {
+            results_.push_back(std::move(info));
+        }
+        outstanding_--;
+        if (!cancelled_) {
+            outstanding_ += children.size();
+            for (auto& child : children) {
+                if (results_.size() >= max_buffered_) {
+                    parked_.push_back(std::move(child));
+                } else {
+                    runnable.push_back(std::move(child));
+                }
+            }
+            Unpark(runnable);
+        }
+        ready = TakeReadyCallback();
+    }
+    Schedule(runnable);
+    if (ready) ready();
+}
+
+void TreeWalk::Unpark(std::vector<std::shared_ptr<WalkItem>>& runnable) {
+    // room again: hand parked directories back to the pool, a pool's worth at a time
+    while (!parked_.empty() && results_.size() < max_buffered_ && runnable.size() < pool_->Size()) {
+        runnable.push_back(std::move(parked_.front()));
+        parked_.pop_front();
+    }
+}
+
+std::function<void()> TreeWalk::TakeReadyCallback() {
+    bool done = cancelled_ || outstanding_ == 0;
+    if (!armed_ || (results_.empty() && !done)) return nullptr;
+    armed_ = false;
+    return on_ready_;
+}
+
+bool TreeWalk::TakeBatch(std::vector<minidfs::FileInfo>* batch, size_t max_entries, bool* done) {
+    std::vector<std::shared_ptr<WalkItem>> runnable;
+    bool ready;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        while (!results_.empty() && batch->size() < max_entries) {
+            batch->push_back(std::move(results_.front()));
+            results_.pop_front();
+        }
+
+        Unpark(runnable);
+
+        *done = cancelled_ || (outstanding_ == 0 && results_.empty());
+        ready = !batch->empty() || *done;
+        if (!ready) armed_ = true;
+    }
+    Schedule(runnable);
+    return ready;
+}
+
+void TreeWalk::Cancel() {
+    std::function<void()> ready;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        cancelled_ = true;
+        outstanding_ -= parked_.size();
+        parked_.clear();
+        results_.clear();
+        ready = TakeReadyCallback();
+    }
+    if (ready) ready();
+}
+
+bool TreeWalk::Failed() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return failed_;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "proto_src/minidfs.pb.h"
+#include "dfs/storage/dir_scan.h"
+#include "dfs/thread_pool.h"
+
+// Entries read from one directory before its task yields the pool thread.
+#define TREE_WALK_BATCH 256
+
+struct TreeWalkOptions {
+    // 0 walks the whole tree; 1 lists direct children only
+    uint32_t max_depth = 0;
+    // '*' and '?' glob applied to entry names; directories are descended either way
+    std::string name_glob;
+    // when non-zero, only files with a newer mtime (ns since the Unix epoch) are reported
+    int64_t modified_since = 0;
+};
+
+// Recursive listing that scans directories in parallel on a shared ThreadPool. Every
+// directory is its own task (split again every TREE_WALK_BATCH entries), so one deep or
+// wide walk never monopolises the pool. Results are buffered up to max_buffered entries;
+// beyond that, pending directories are parked until the consumer catches up.
+class TreeWalk : public std::enable_shared_from_this<TreeWalk> {
+public:
+    using FillFn = std::function<void(const std::filesystem::path& dir_path, const std::filesystem::path& virtual_dir,
+        const DirEntryInfo& entry, minidfs::FileInfo* file_info)>;
+
+    // on_ready runs on a pool thread whenever TakeBatch has returned false and results (or the
+    // end of the walk) have since become available.
+    static std::shared_ptr<TreeWalk> Start(ThreadPool* pool, const std::filesystem::path& root, const std::filesystem::path& virtual_root,
+        const TreeWalkOptions& options, size_t max_buffered, FillFn fill, std::function<void()> on_ready);
+
+    // Moves up to max_entries results into batch. Returns false, and arms on_ready, when there
+    // is nothing to hand out yet; otherwise sets done once the walk has finished.
+    bool TakeBatch(std::vector<minidfs::FileInfo>* batch, size_t max_entries, bool* done);
+
+    // Stops scheduling further directories. Arms nothing; a pending on_ready fires once.
+    void Cancel();
+
+    // The root directory could not be read.
+    bool Failed();
+
+private:
+    struct WalkItem {
+        std::filesystem::path dir_path;
+        std::filesystem::path virtual_dir;
+        uint32_t depth = 0;
+        std::unique_ptr<DirScanner> scanner;
+    };
+
+    TreeWalk() = default;
+
+    void Schedule(std::vector<std::shared_ptr<WalkItem>>& items);
+    void Process(const std::shared_ptr<WalkItem>& item);
+    bool Matches(const DirEntryInfo& entry) const;
+    // Caller holds mu_.
+    void Unpark(std::vector<std::shared_ptr<WalkItem>>& runnable);
+    // Caller holds mu_. Returns the callback to run once mu_ is dropped, if any.
+    std::function<void()> TakeReadyCallback();
+
+    ThreadPool* pool_ = nullptr;
+    TreeWalkOptions options_;
+    size_t max_buffered_ = 0;
+    FillFn fill_;
+    std::function<void()> on_ready_;
+
+    std::mutex mu_;
+    std::deque<minidfs::FileInfo> results_;
+    std::deque<std::shared_ptr<WalkItem>> parked_;
+    // items queued on the pool, running or parked
+    size_t outstanding_ = 0;
+    std::atomic<bool> cancelled_{false};
+    bool failed_ = false;
+    bool armed_ = false;
+};
+
+// Shell-style match of '*' (any run) and '?' (any one character) against a whole name.
+bool GlobMatch(const std::string& pattern, const std::string& name);
@@ -0,0 +1,243 @@
+#include "dfs/storage/uring_engine.h"
+
+#ifdef MINIDFS_URING_IO
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+    struct UringRequest {
+        std::function<void(int)> done;
+    };
+
+    int uring_setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    // READ and WRITE arrived in 5.6 together with IORING_REGISTER_PROBE; older rings take the
+    // setup call but fail every chunk with -EINVAL, so the probe failing means no.
+    bool SupportsChunkOps(int ring_fd) {
+#ifdef IO_URING_OP_SUPPORTED
+        const unsigned kOps = 256;
+        size_t size = sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op);
+        auto* probe = static_cast<io_uring_probe*>(std::calloc(1, size));
+        if (!probe) return false;
+        int ret = static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, kOps));
+        bool supported = ret >= 0 && probe->last_op >= IORING_OP_WRITE
+            && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)
+            && (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+        std::free(probe);
+        return supported;
+#else
+        (void)ring_fd;
+        return false;
+#endif
+    }
+}
+
+std::unique_ptr<UringEngine> UringEngine::Create(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    int ring_fd = uring_setup(entries, &params);
+    if (ring_fd < 0) {
+        std::cerr << "io_uring unavailable: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<UringEngine> engine(new UringEngine());
+    engine->ring_fd_ = ring_fd;
+    if (!SupportsChunkOps(ring_fd)) {
+        std::cerr << "io_uring unavailable: kernel lacks IORING_OP_READ/IORING_OP_WRITE" << std::endl;
+        return nullptr;
+    }
+
+    engine->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    engine->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        engine->sq_ring_size_ = std::max(engine->sq_ring_size_, engine->cq_ring_size_);
+        engine->cq_ring_size_ = engine->sq_ring_size_;
+    }
+
+    void* sq_ring = ::mmap(nullptr, engine->sq_ring_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) return nullptr;
+    engine->sq_ring_ = sq_ring;
+
+    void* cq_ring = sq_ring;
+    if (!single_mmap) {
+        cq_ring = ::mmap(nullptr, engine->cq_ring_size_, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED) return nullptr;
+    }
+    engine->cq_ring_ = cq_ring;
+
+    engine->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, engine->sqes_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return nullptr;
+    engine->sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ring);
+    engine->sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    engine->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    engine->sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    engine->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cq_ring);
+    engine->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    engine->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    engine->cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    engine->cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    engine->cq_entries_ = params.cq_entries;
+
+    engine->reaper_ = std::thread(&UringEngine::ReapLoop, engine.get());
+    return engine;
+}
+
+UringEngine::~UringEngine() {
+    if (reaper_.joinable()) {
+        stopping_ = true;
+        // wake the reaper; it exits once every in-flight request has completed. While the SQ
+        // is full the NOP cannot go in, but then completions are on their way and wake the
+        // reaper anyway; keep trying until one of the two gets through.
+        while (!Submit(IORING_OP_NOP, -1, 0, 0, 0, nullptr) && !reaper_exited_.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        reaper_.join();
+    }
+
+    if (sqes_) ::munmap(sqes_, sqes_size_);
+    if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_) ::munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0) ::close(ring_fd_);
+}
+
+bool UringEngine::SubmitRead(int fd, void* buf, size_t len, uint64_t offset, std::function<void(int res)> done) {
+    return Submit(IORING_OP_READ, fd, reinterpret_cast<uint64_t>(buf), static_cast<uint32_t>(len), offset, std::move(done));
+}
+
+bool UringEngine::SubmitWrite(int fd, const void* buf, size_t len, uint64_t offset, std::function<void(int res)> done) {
+    return Submit(IORING_OP_WRITE, fd, reinterpret_cast<uint64_t>(buf), static_cast<uint32_t>(len), offset, std::move(done));
+}
+
+bool UringEngine::Submit(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t offset, std::function<void(int)> done) {
+    std::lock_guard<std::mutex> lock(sq_mu_);
+    // nobody would reap it
+    if (reaper_exited_) return false;
+
+    // a NOP (no callback) is only used to wake the reaper during shutdown
+    if (done) {
+        if (stopping_) return false;
+        // never let completions outrun the CQ
+        if (in_flight_.load() >= cq_entries_) return false;
+    }
+
+    unsigned tail = *sq_tail_;
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (tail - head > *sq_mask_) return false;
+
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = addr;
+    sqe->len = len;
+    sqe->off = offset;
+    auto* request = done ? new UringRequest{std::move(done)} : nullptr;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    sq_array_[index] = index;
+
+    if (request) {
+        in_flight_++;
+        pending_.insert(request);
+    }
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    int ret;
+    do {
+        ret = uring_enter(ring_fd_, 1, 0, 0);
+    } while (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+
+    // a hard error before the kernel took the entry: no completion will ever come for it, so
+    // take it back and let the caller do the I/O itself
+    if (ret < 0 && __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == tail) {
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        if (request) {
+            in_flight_--;
+            pending_.erase(request);
+            delete request;
+        }
+        return false;
+    }
+    return true;
+}
+
+void UringEngine::ReapLoop() {
+    bool failed = false;
+    while (true) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+        if (head == tail) {
+            if (stopping_ && in_flight_.load() == 0) break;
+            int ret = uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+            if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                std::cerr << "io_uring reaper stopped: " << std::strerror(errno) << std::endl;
+                failed = true;
+                break;
+            }
+            continue;
+        }
+
+        io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+        uint64_t user_data = cqe->user_data;
+        int res = cqe->res;
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+        if (user_data == 0) continue;
+
+        auto* request = reinterpret_cast<UringRequest*>(user_data);
+        {
+            std::lock_guard<std::mutex> lock(sq_mu_);
+            pending_.erase(request);
+        }
+        in_flight_--;
+        request->done(res);
+        delete request;
+    }
+
+    // Submit checks the flag under sq_mu_, so nothing joins pending_ after this
+    std::vector<void*> orphans;
+    {
+        std::lock_guard<std::mutex> lock(sq_mu_);
+        reaper_exited_ = true;
+        orphans.assign(pending_.begin(), pending_.end());
+        pending_.clear();
+    }
+    if (!failed) return;
+    // the ring is unusable: fail what it still holds so no caller waits forever
+    for (void* pending : orphans) {
+        auto* request = static_cast<UringRequest*>(pending);
+        in_flight_--;
+        request->done(-EIO);
+        delete request;
+    }
+}
+
+#endif
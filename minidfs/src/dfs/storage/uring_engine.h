@@ -0,0 +1,77 @@
+#pragma once
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MINIDFS_URING_IO 1
+#endif
+
+#ifdef MINIDFS_URING_IO
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing dependency).
+// Any thread may submit; completions are reaped on one internal thread and
+// each callback runs there with the raw result (bytes transferred or -errno).
+class UringEngine {
+public:
+    // Returns nullptr when the kernel (or a seccomp policy) does not allow io_uring, or its
+    // io_uring lacks IORING_OP_READ/IORING_OP_WRITE (before 5.6).
+    static std::unique_ptr<UringEngine> Create(unsigned entries);
+
+    ~UringEngine();
+
+    UringEngine(const UringEngine&) = delete;
+    UringEngine& operator=(const UringEngine&) = delete;
+
+    // Return false without queuing anything when the ring is saturated, the
+    // kernel refuses the submission or the reaper has stopped; the caller is
+    // expected to fall back to synchronous I/O. If the reaper stops on an error,
+    // requests still in flight complete with -EIO.
+    bool SubmitRead(int fd, void* buf, size_t len, uint64_t offset, std::function<void(int res)> done);
+    bool SubmitWrite(int fd, const void* buf, size_t len, uint64_t offset, std::function<void(int res)> done);
+
+    uint64_t InFlight() const { return in_flight_.load(); }
+
+private:
+    UringEngine() = default;
+
+    bool Submit(uint8_t opcode, int fd, uint64_t addr, uint32_t len, uint64_t offset, std::function<void(int)> done);
+    void ReapLoop();
+
+    int ring_fd_ = -1;
+
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_entries_ = 0;
+
+    std::mutex sq_mu_;
+    // requests submitted and not yet completed, so a failing reaper can complete them; guarded by sq_mu_
+    std::unordered_set<void*> pending_;
+    std::atomic<uint64_t> in_flight_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> reaper_exited_{false};
+    std::thread reaper_;
+};
+
+#endif
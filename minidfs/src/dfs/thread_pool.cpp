@@ -0,0 +1,43 @@
+#include "dfs/thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads) {
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        tasks_.clear();
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (stopping_) return;
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
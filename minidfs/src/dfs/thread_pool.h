@@ -0,0 +1,34 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining a FIFO of tasks. Tasks must not block on each other;
+// long-running work should split itself and resubmit instead.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads);
+
+    // Drops tasks that have not started and joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    size_t Size() const { return workers_.size(); }
+
+private:
+    void WorkerLoop();
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
@@ -1,10 +1,27 @@
 #include <gtest/gtest.h>
 #include <thread>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <random>
+#include <set>
+#include <sstream>
 #include <vector>
 #include <filesystem>
 #include <string>
+#include "dfs/chunk_codec.h"
+#include "dfs/chunk_pool.h"
+#include "dfs/chunk_sizer.h"
+#include "dfs/file_delta.h"
 #include "dfs/file_manager.h"
+#include "dfs/storage/cdc_chunker.h"
+#include "dfs/storage/chunk_store.h"
+#include "dfs/storage/crc32c.h"
+#include "dfs/storage/dir_scan.h"
+#include "dfs/storage/hash_cache.h"
+#include "dfs/storage/tree_walk.h"
 
 namespace fs = std::filesystem;
 
@@ -20,6 +37,14 @@ protected:
     void TearDown() override {
         fs::remove_all(test_mount);
     }
+
+    size_t ShardIndex(const std::string& file_path) {
+        return static_cast<size_t>(&fm.GetShard(file_path) - fm.lock_shards_.data());
+    }
+
+    std::mutex& ShardMutex(const std::string& file_path) {
+        return fm.GetShard(file_path).mu;
+    }
 };
 
 TEST_F(MiniDFSFileManagerTest, AcquireWriteLockExclusive) {
@@ -429,4 +454,874 @@ TEST_F(MiniDFSFileManagerTest, ManyReaderWriterChaosTest) {
     EXPECT_EQ(active_writers.load(), 0);
     EXPECT_EQ(total_writes.load(), kWriters * kIterations);
     EXPECT_EQ(total_reads.load(), kReaders * kIterations);
-}
\ No newline at end of file
+}
+
+TEST_F(MiniDFSFileManagerTest, ConcurrentTransfersOnDifferentFilesScale) {
+    constexpr int kFiles = 8;
+    constexpr int kChunks = 64;
+    const std::vector<char> chunk(CHUNK_SIZE, 'Z');
+
+    auto transfer = [&](const std::string& tag, int i) {
+        std::string cid = tag + "_" + std::to_string(i);
+        std::string fp = FileManager::ResolvePath(test_mount, tag + "_" + std::to_string(i) + ".bin").string();
+
+        ASSERT_TRUE(fm.AcquireWriteLock(cid, fp, true));
+        for (int c = 0; c < kChunks; ++c) {
+            ASSERT_TRUE(fm.WriteFile(cid, fp, static_cast<uint64_t>(c) * CHUNK_SIZE, chunk.data(), chunk.size()));
+        }
+        fm.ReleaseWriteLock(cid, fp);
+
+        std::vector<char> buf(CHUNK_SIZE);
+        size_t bytes_read = 0;
+        ASSERT_TRUE(fm.AcquireReadLock(cid, fp));
+        for (int c = 0; c < kChunks; ++c) {
+            ASSERT_TRUE(fm.ReadFile(cid, fp, static_cast<uint64_t>(c) * CHUNK_SIZE, buf.data(), &bytes_read));
+            ASSERT_EQ(bytes_read, static_cast<size_t>(CHUNK_SIZE));
+        }
+        fm.ReleaseReadLock(cid, fp);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kFiles; ++i) {
+        transfer("serial", i);
+    }
+    auto serial = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kFiles; ++i) {
+        threads.emplace_back(transfer, "parallel", i);
+    }
+    for (auto& t : threads) t.join();
+    auto parallel = std::chrono::steady_clock::now() - start;
+
+    for (int i = 0; i < kFiles; ++i) {
+        fs::path fp = FileManager::ResolvePath(test_mount, "parallel_" + std::to_string(i) + ".bin");
+        EXPECT_EQ(fs::file_size(fp), static_cast<uintmax_t>(kChunks) * CHUNK_SIZE);
+    }
+
+    // 2x per file: written once, read back once
+    double total_mb = 2.0 * kFiles * kChunks * CHUNK_SIZE / (1024.0 * 1024.0);
+    double serial_mbps = total_mb / std::chrono::duration<double>(serial).count();
+    double parallel_mbps = total_mb / std::chrono::duration<double>(parallel).count();
+    RecordProperty("serial_mbps", std::to_string(serial_mbps));
+    RecordProperty("parallel_mbps", std::to_string(parallel_mbps));
+}
+
+TEST_F(MiniDFSFileManagerTest, BusyShardDoesNotBlockOtherShards) {
+    std::string busy = FileManager::ResolvePath(test_mount, "busy.bin").string();
+    std::string same_shard, other_shard;
+    for (int i = 0; same_shard.empty() || other_shard.empty(); ++i) {
+        std::string candidate = FileManager::ResolvePath(test_mount, "f" + std::to_string(i) + ".bin").string();
+        std::string& slot = ShardIndex(candidate) == ShardIndex(busy) ? same_shard : other_shard;
+        if (slot.empty()) slot = candidate;
+    }
+
+    ASSERT_TRUE(fm.AcquireWriteLock("a", busy, true));
+    // whoever is inside the busy file's shard only holds up files that hash there too
+    std::unique_lock<std::mutex> shard_lock(ShardMutex(busy));
+    auto other = std::async(std::launch::async, [&] { return fm.AcquireWriteLock("b", other_shard, true); });
+    bool other_ready = other.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+    EXPECT_TRUE(other_ready);
+    if (!other_ready) shard_lock.unlock();
+    EXPECT_TRUE(other.get());
+    auto same = std::async(std::launch::async, [&] { return fm.AcquireWriteLock("c", same_shard, true); });
+    if (other_ready) {
+        EXPECT_EQ(same.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+        shard_lock.unlock();
+    }
+    EXPECT_TRUE(same.get());
+
+    fm.ReleaseWriteLock("a", busy);
+    fm.ReleaseWriteLock("b", other_shard);
+    fm.ReleaseWriteLock("c", same_shard);
+}
+
+TEST_F(MiniDFSFileManagerTest, AsyncWriteLockGrantedOnRelease) {
+    fs::path file_path = FileManager::ResolvePath(test_mount, "async.txt");
+    ASSERT_TRUE(fm.AcquireWriteLock("client1", file_path.string(), true));
+
+    std::atomic<int> result{-1};
+    auto waiter = fm.AcquireWriteLockAsync("client2", file_path.string(), true,
+        [&](bool granted) { result = granted ? 1 : 0; });
+
+    ASSERT_NE(waiter, nullptr);
+    EXPECT_EQ(result.load(), -1);
+
+    fm.ReleaseWriteLock("client1", file_path.string());
+    EXPECT_EQ(result.load(), 1);
+
+    std::string data = "async";
+    EXPECT_TRUE(fm.WriteFile("client2", file_path.string(), 0, data.data(), data.size()));
+    fm.ReleaseWriteLock("client2", file_path.string());
+}
+
+TEST_F(MiniDFSFileManagerTest, AsyncReadLockGrantedImmediately) {
+    fs::path file_path = FileManager::ResolvePath(test_mount, "async_read.txt");
+    ASSERT_TRUE(fm.AcquireWriteLock("client1", file_path.string(), true));
+    fm.ReleaseWriteLock("client1", file_path.string());
+
+    bool granted = false;
+    auto waiter = fm.AcquireReadLockAsync("client2", file_path.string(), [&](bool ok) { granted = ok; });
+
+    EXPECT_EQ(waiter, nullptr);
+    EXPECT_TRUE(granted);
+    fm.ReleaseReadLock("client2", file_path.string());
+}
+
+TEST_F(MiniDFSFileManagerTest, AsyncWaiterCancelledReleasesQueue) {
+    fs::path file_path = FileManager::ResolvePath(test_mount, "async_cancel.txt");
+    ASSERT_TRUE(fm.AcquireWriteLock("w1", file_path.string(), true));
+    fm.ReleaseWriteLock("w1", file_path.string());
+    ASSERT_TRUE(fm.AcquireReadLock("r1", file_path.string()));
+
+    bool writer_called = false;
+    auto writer = fm.AcquireWriteLockAsync("w2", file_path.string(), true, [&](bool) { writer_called = true; });
+    ASSERT_NE(writer, nullptr);
+
+    // readers queue behind the pending async writer
+    bool reader_granted = false;
+    auto reader = fm.AcquireReadLockAsync("r2", file_path.string(), [&](bool ok) { reader_granted = ok; });
+    ASSERT_NE(reader, nullptr);
+
+    EXPECT_TRUE(fm.CancelLockWaiter(file_path.string(), writer));
+    EXPECT_FALSE(fm.CancelLockWaiter(file_path.string(), writer));
+    EXPECT_FALSE(writer_called);
+    EXPECT_TRUE(reader_granted);
+
+    fm.ReleaseReadLock("r1", file_path.string());
+    fm.ReleaseReadLock("r2", file_path.string());
+}
+
+TEST_F(MiniDFSFileManagerTest, NestedReadLockSkipsPendingWriter) {
+    fs::path file_path = FileManager::ResolvePath(test_mount, "nested_read.txt");
+    ASSERT_TRUE(fm.AcquireWriteLock("w1", file_path.string(), true));
+    ASSERT_TRUE(fm.WriteFile("w1", file_path.string(), 0, "nested", 6));
+    fm.ReleaseWriteLock("w1", file_path.string());
+    ASSERT_TRUE(fm.AcquireReadLock("r1", file_path.string()));
+
+    bool writer_granted = false;
+    auto writer = fm.AcquireWriteLockAsync("w2", file_path.string(), true, [&](bool ok) { writer_granted = ok; });
+    ASSERT_NE(writer, nullptr);
+
+    // another request by the same reader waits behind the queued writer
+    bool late_granted = false;
+    auto late = fm.AcquireReadLockAsync("r1", file_path.string(), [&](bool ok) { late_granted = ok; });
+    ASSERT_NE(late, nullptr);
+
+    // a second hold with the session's token (the same fetch) goes ahead of it
+    uint64_t token = fm.ReadLockToken("r1", file_path.string());
+    EXPECT_NE(token, 0u);
+    bool nested_granted = false;
+    EXPECT_EQ(fm.AcquireReadLockAsync("r1", file_path.string(), [&](bool ok) { nested_granted = ok; }, token), nullptr);
+    EXPECT_TRUE(nested_granted);
+
+    // the session outlives the first release
+    fm.ReleaseReadLock("r1", file_path.string());
+    EXPECT_FALSE(writer_granted);
+    char buf[6];
+    size_t bytes_read = 0;
+    ASSERT_TRUE(fm.ReadFile("r1", file_path.string(), 0, buf, &bytes_read));
+    EXPECT_EQ(std::string(buf, bytes_read), "nested");
+
+    fm.ReleaseReadLock("r1", file_path.string());
+    EXPECT_TRUE(writer_granted);
+    EXPECT_FALSE(late_granted);
+    fm.ReleaseWriteLock("w2", file_path.string());
+    EXPECT_TRUE(late_granted);
+    EXPECT_NE(fm.ReadLockToken("r1", file_path.string()), token);
+    fm.ReleaseReadLock("r1", file_path.string());
+}
+
+TEST_F(MiniDFSFileManagerTest, ChunkPoolReusesBuffersAndCapacity) {
+    ChunkPool pool;
+    const char* payload = nullptr;
+    {
+        ChunkPool::Chunk chunk = pool.Acquire();
+        char* out = pool.Reserve(chunk.get(), CHUNK_SIZE);
+        std::fill(out, out + CHUNK_SIZE, 'p');
+        chunk->set_file_path("pooled.txt");
+        payload = chunk->data().data();
+        pool.CountBytes(CHUNK_SIZE);
+    }
+
+    // the released chunk comes back cleared, with its payload capacity intact
+    ChunkPool::Chunk chunk = pool.Acquire();
+    EXPECT_TRUE(chunk->file_path().empty());
+    EXPECT_TRUE(chunk->data().empty());
+    EXPECT_EQ(pool.Reserve(chunk.get(), CHUNK_SIZE / 2), payload);
+
+    ChunkPoolStats stats = pool.Stats();
+    EXPECT_EQ(stats.allocations, 2u);
+    EXPECT_EQ(stats.reuses, 1u);
+    EXPECT_EQ(stats.bytes, static_cast<uint64_t>(CHUNK_SIZE));
+    EXPECT_GT(stats.AllocationsPerGB(), 0.0);
+}
+
+TEST_F(MiniDFSFileManagerTest, ChunkSizerNegotiatesAndAdapts) {
+    const size_t max_chunk = MaxChunkSize(MAX_MESSAGE_SIZE);
+    EXPECT_EQ(NegotiateChunkSize(0, max_chunk), static_cast<size_t>(CHUNK_SIZE));
+    EXPECT_EQ(NegotiateChunkSize(1, max_chunk), static_cast<size_t>(MIN_CHUNK_SIZE));
+    EXPECT_EQ(NegotiateChunkSize(64 * 1024 * 1024, max_chunk), max_chunk);
+    EXPECT_LT(max_chunk, static_cast<size_t>(MAX_MESSAGE_SIZE));
+
+    auto feed = [](ChunkSizer& sizer, int windows, std::chrono::milliseconds latency) {
+        for (int i = 0; i < windows * CHUNK_SAMPLE_WINDOW; ++i) {
+            // throughput rises with the chunk size until latency caps it
+            sizer.Record(sizer.Size(), latency);
+        }
+    };
+
+    ChunkSizer fixed(CHUNK_SIZE, max_chunk, false);
+    feed(fixed, 4, std::chrono::milliseconds(1));
+    EXPECT_EQ(fixed.Size(), static_cast<size_t>(CHUNK_SIZE));
+
+    // a fast link grows chunks up to the message limit, a slow one shrinks them to the floor
+    ChunkSizer adaptive(CHUNK_SIZE, max_chunk, true);
+    feed(adaptive, 16, std::chrono::milliseconds(1));
+    EXPECT_EQ(adaptive.Size(), max_chunk);
+    feed(adaptive, 16, std::chrono::milliseconds(CHUNK_TARGET_LATENCY_MS * 4));
+    EXPECT_EQ(adaptive.Size(), static_cast<size_t>(MIN_CHUNK_SIZE));
+
+    // growth stops once a bigger chunk no longer moves more bytes per second
+    ChunkSizer capped(CHUNK_SIZE, max_chunk, true);
+    for (int i = 0; i < 16 * CHUNK_SAMPLE_WINDOW; ++i) {
+        capped.Record(capped.Size(), std::chrono::microseconds(capped.Size() / 1024));
+    }
+    EXPECT_LT(capped.Size(), 4u * CHUNK_SIZE);
+}
+
+TEST_F(MiniDFSFileManagerTest, Crc32cMatchesReferenceAcrossSizes) {
+    EXPECT_EQ(Crc32c("123456789", 9), 0xe3069283u);
+    EXPECT_EQ(Crc32cPortable("123456789", 9), 0xe3069283u);
+    EXPECT_EQ(Crc32c("", 0), 0u);
+
+    std::string data(3 * CHUNK_SIZE + 13, '\0');
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<char>(i * 2654435761u >> 13);
+    // odd lengths and offsets exercise the byte tails around the interleaved blocks
+    for (size_t size : {size_t(1), size_t(7), size_t(64), size_t(12287), size_t(12288), size_t(CHUNK_SIZE), data.size() - 3}) {
+        for (size_t offset : {size_t(0), size_t(3)}) {
+            EXPECT_EQ(Crc32c(data.data() + offset, size), Crc32cPortable(data.data() + offset, size)) << size << "+" << offset;
+        }
+    }
+    uint32_t split = Crc32c(data.data() + 100, data.size() - 100, Crc32c(data.data(), 100));
+    EXPECT_EQ(split, Crc32c(data.data(), data.size()));
+    RecordProperty("crc32c_accelerated", Crc32cAccelerated() ? "true" : "false");
+}
+
+TEST_F(MiniDFSFileManagerTest, ChunkCompressorSkipsIncompressibleChunks) {
+    std::vector<minidfs::Codec> codecs = SupportedCodecs();
+    if (codecs.empty()) GTEST_SKIP() << "built without any codec library";
+
+    std::string text;
+    while (text.size() < CHUNK_SIZE) text += "timestamp,level,message\n2024-01-01T00:00:00,INFO,started\n";
+    text.resize(CHUNK_SIZE);
+    std::mt19937 rng(7);
+    std::string noise(CHUNK_SIZE, '\0');
+    for (char& c : noise) c = static_cast<char>(rng());
+
+    for (minidfs::Codec codec : codecs) {
+        CodecCounters counters;
+        ChunkCompressor compressor(&counters, codec, 0);
+        std::string scratch;
+
+        minidfs::FileBuffer chunk;
+        chunk.set_data(text);
+        chunk.set_crc32c(Crc32c(text.data(), text.size()));
+        compressor.Compress(&chunk, &scratch);
+        EXPECT_EQ(chunk.codec(), codec);
+        EXPECT_EQ(chunk.raw_size(), text.size());
+        EXPECT_LT(chunk.data().size(), text.size() / 2);
+        minidfs::FileBuffer damaged = chunk;
+        ASSERT_TRUE(UnpackChunk(&chunk, CHUNK_SIZE, &scratch, &counters).ok());
+        EXPECT_EQ(chunk.data(), text);
+        EXPECT_EQ(chunk.codec(), minidfs::CODEC_NONE);
+
+        // damage shows up either as a failed decompression or as a checksum mismatch
+        (*damaged.mutable_data())[damaged.data().size() / 2] ^= 0x5a;
+        EXPECT_EQ(UnpackChunk(&damaged, CHUNK_SIZE, &scratch, &counters).error_code(), grpc::StatusCode::DATA_LOSS);
+        minidfs::FileBuffer oversized = chunk;
+        compressor.Compress(&oversized, &scratch);
+        EXPECT_EQ(UnpackChunk(&oversized, CHUNK_SIZE / 2, &scratch, &counters).error_code(), grpc::StatusCode::DATA_LOSS);
+
+        // random bytes go out raw, and after a streak of them most chunks are not even tried
+        for (int i = 0; i < CODEC_SKIP_STREAK + CODEC_PROBE_INTERVAL; ++i) {
+            chunk.set_data(noise);
+            compressor.Compress(&chunk, &scratch);
+            EXPECT_EQ(chunk.codec(), minidfs::CODEC_NONE);
+            EXPECT_EQ(chunk.data(), noise);
+        }
+        CodecStats stats = counters.Stats();
+        EXPECT_EQ(stats.compressed_chunks, 2u);
+        EXPECT_EQ(stats.skipped_chunks, static_cast<uint64_t>(CODEC_SKIP_STREAK + CODEC_PROBE_INTERVAL));
+        EXPECT_EQ(stats.decompressed_chunks, 1u);
+        EXPECT_GT(stats.Ratio(), 1.0);
+        EXPECT_GT(stats.compress_ns, 0u);
+    }
+}
+
+TEST_F(MiniDFSFileManagerTest, DeltaEncodesOnlyChangedBytes) {
+    std::mt19937 rng(11);
+    std::string base(300000, '\0');
+    for (char& c : base) c = static_cast<char>(rng());
+
+    RollingChecksum rolling, fresh;
+    rolling.Init(base.data(), 1000);
+    for (size_t i = 1; i < 500; i++) {
+        rolling.Roll(static_cast<unsigned char>(base[i - 1]), static_cast<unsigned char>(base[i + 999]));
+        fresh.Init(base.data() + i, 1000);
+        ASSERT_EQ(rolling.Value(), fresh.Value());
+    }
+
+    std::istringstream base_in(base);
+    minidfs::FileSignature signature;
+    ASSERT_TRUE(ComputeSignature(base_in, base.size(), &signature));
+    const size_t block_size = signature.block_size();
+    EXPECT_EQ(block_size, DeltaBlockSize(base.size()));
+    EXPECT_EQ(static_cast<size_t>(signature.weak_size()), (base.size() + block_size - 1) / block_size);
+
+    auto encode = [&](const std::string& data, std::vector<minidfs::DeltaOp>* ops) {
+        std::istringstream in(data);
+        IncrementalHash hash;
+        return ComputeDelta(in, signature, 4096, &hash, [ops](minidfs::DeltaOp& op) {
+            ops->push_back(op);
+            return true;
+        });
+    };
+    auto apply = [&](const std::vector<minidfs::DeltaOp>& ops, size_t* literal) {
+        std::string out;
+        *literal = 0;
+        for (const minidfs::DeltaOp& op : ops) {
+            if (op.blocks() == 0) {
+                EXPECT_LE(op.literal().size(), 4096u);
+                out += op.literal();
+                *literal += op.literal().size();
+                continue;
+            }
+            size_t begin = op.block() * block_size;
+            out += base.substr(begin, std::min(base.size(), (op.block() + op.blocks()) * block_size) - begin);
+        }
+        return out;
+    };
+
+    std::vector<minidfs::DeltaOp> ops;
+    size_t literal = 0;
+    ASSERT_TRUE(encode(base, &ops));
+    ASSERT_EQ(ops.size(), 1u);
+    EXPECT_EQ(ops[0].blocks(), static_cast<uint32_t>(signature.weak_size()));
+    EXPECT_EQ(apply(ops, &literal), base);
+
+    // an insertion shifts everything after it; the rolling match finds the blocks again
+    std::string edited = base;
+    edited.insert(1000, "inserted");
+    edited[150000] ^= 0x20;
+    edited += "appended tail";
+    ops.clear();
+    ASSERT_TRUE(encode(edited, &ops));
+    EXPECT_EQ(apply(ops, &literal), edited);
+    EXPECT_LT(literal, 3 * block_size + 32);
+
+    ops.clear();
+    ASSERT_TRUE(encode("", &ops));
+    EXPECT_TRUE(ops.empty());
+}
+
+TEST_F(MiniDFSFileManagerTest, ContentDefinedChunksSurviveInsertions) {
+    std::mt19937 rng(13);
+    std::string data(2 * 1024 * 1024, '\0');
+    for (char& c : data) c = static_cast<char>(rng());
+
+    auto split = [](const std::string& input) {
+        std::vector<std::string> chunks;
+        std::istringstream in(input);
+        EXPECT_TRUE(SplitChunks(in, [&](const char* chunk, size_t size) {
+            chunks.emplace_back(chunk, size);
+            return true;
+        }));
+        return chunks;
+    };
+
+    std::vector<std::string> chunks = split(data);
+    std::string joined;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (i + 1 < chunks.size()) {
+            EXPECT_GE(chunks[i].size(), static_cast<size_t>(CDC_MIN_CHUNK));
+        }
+        EXPECT_LE(chunks[i].size(), static_cast<size_t>(CDC_MAX_CHUNK));
+        joined += chunks[i];
+    }
+    EXPECT_EQ(joined, data);
+    // normalized chunking keeps the average near CDC_AVG_CHUNK
+    EXPECT_GT(chunks.size(), data.size() / (2 * CDC_AVG_CHUNK));
+    EXPECT_LT(chunks.size(), data.size() / (CDC_AVG_CHUNK / 2));
+
+    // fixed-size blocks would all shift; content-defined ones resync right after the edit
+    std::string edited = data;
+    edited.insert(500000, "a few inserted bytes");
+    std::set<std::string> original(chunks.begin(), chunks.end());
+    size_t changed = 0;
+    for (const std::string& chunk : split(edited)) {
+        if (original.count(chunk) == 0) changed++;
+    }
+    EXPECT_GE(changed, 1u);
+    EXPECT_LE(changed, 2u);
+
+    EXPECT_TRUE(split("").empty());
+}
+
+TEST_F(MiniDFSFileManagerTest, ChunkStoreIndexesSharedChunksOnce) {
+    const std::string root = ChunkStore::RootFor(test_mount);
+    fs::remove_all(root);
+    std::mt19937 rng(17);
+    std::string shared(1024 * 1024, '\0');
+    for (char& c : shared) c = static_cast<char>(rng());
+    std::string extra(512 * 1024, '\0');
+    for (char& c : extra) c = static_cast<char>(rng());
+
+    fs::path a_path = FileManager::ResolvePath(test_mount, "a.bin");
+    fs::path b_path = FileManager::ResolvePath(test_mount, "dir/b.bin");
+    fs::create_directories(b_path.parent_path());
+    std::ofstream(a_path, std::ios::binary) << shared;
+    std::ofstream(b_path, std::ios::binary) << "header" << shared << extra;
+
+    // a chunk from the middle, which both files have; b's prefix changes its first one
+    std::string middle_chunk;
+    {
+        std::istringstream in(shared);
+        int seen = 0;
+        SplitChunks(in, [&](const char* chunk, size_t size) {
+            middle_chunk.assign(chunk, size);
+            return ++seen < 3;
+        });
+    }
+    const std::string middle_hash = ChunkHash(middle_chunk.data(), middle_chunk.size());
+
+    {
+        ChunkStore store(root, test_mount);
+        store.Ingest(a_path.string());
+        store.Flush();
+        EXPECT_EQ(store.Stats().files, 0u);
+
+        ASSERT_TRUE(store.Enable());
+        store.Ingest(a_path.string());
+        store.Ingest(b_path.string());
+        store.Flush();
+        ChunkStoreStats stats = store.Stats();
+        EXPECT_EQ(stats.files, 2u);
+        EXPECT_EQ(stats.logical_bytes, 2 * shared.size() + extra.size() + 6);
+        EXPECT_LT(stats.unique_bytes, shared.size() + extra.size() + 2 * CDC_MAX_CHUNK);
+        EXPECT_GT(stats.PotentialRatio(), 1.4);
+
+        // only manifests go beside the mount; chunks are read back from the files themselves
+        uint64_t index_bytes = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(root)) {
+            if (entry.is_regular_file()) index_bytes += entry.file_size();
+        }
+        EXPECT_LT(index_bytes, stats.logical_bytes / 100);
+
+        std::string stored;
+        EXPECT_TRUE(store.Has(middle_hash));
+        ASSERT_TRUE(store.Get(middle_hash, &stored));
+        EXPECT_EQ(stored, middle_chunk);
+        EXPECT_FALSE(store.Get("../../etc/passwd", &stored));
+
+        // chunks b still has stay, now read from b
+        store.Forget(a_path.string());
+        store.Flush();
+        EXPECT_EQ(store.Stats().files, 1u);
+        EXPECT_EQ(store.Stats().logical_bytes, shared.size() + extra.size() + 6);
+        EXPECT_TRUE(store.Has(middle_hash));
+        fs::remove(a_path);
+        ASSERT_TRUE(store.Get(middle_hash, &stored));
+        EXPECT_EQ(stored, middle_chunk);
+    }
+
+    // a fresh instance finds the same store on disk
+    {
+        ChunkStore store(root, test_mount);
+        ASSERT_TRUE(store.Enable());
+        EXPECT_EQ(store.Stats().files, 1u);
+        EXPECT_TRUE(store.Has(middle_hash));
+
+        // edited in place without being ingested again: its chunks fail the hash check
+        std::ofstream(b_path, std::ios::binary) << std::string(shared.size() + extra.size() + 6, 'x');
+        std::string stored;
+        EXPECT_FALSE(store.Get(middle_hash, &stored));
+
+        store.Forget(b_path.string());
+        store.Flush();
+        EXPECT_EQ(store.Stats().chunks, 0u);
+        EXPECT_EQ(store.Stats().unique_bytes, 0u);
+        size_t manifests = 0;
+        for (const auto& entry : fs::recursive_directory_iterator(root)) {
+            if (entry.is_regular_file()) manifests++;
+        }
+        EXPECT_EQ(manifests, 0u);
+    }
+    fs::remove_all(root);
+}
+
+TEST_F(MiniDFSFileManagerTest, StoredHashIgnoredAfterExternalModification) {
+    fs::path file_path = FileManager::ResolvePath(test_mount, "stored_hash.txt");
+    {
+        std::ofstream out(file_path, std::ios::binary);
+        out << "original";
+    }
+    std::string real_hash = FileManager::GetFileHash(file_path.string());
+    if (!SaveStoredHash(file_path.string(), "cafe")) {
+        GTEST_SKIP() << "filesystem does not support user xattrs";
+    }
+    EXPECT_EQ(FileManager::GetFileHash(file_path.string()), "cafe");
+
+    {
+        std::ofstream out(file_path, std::ios::binary | std::ios::app);
+        out << " plus more";
+    }
+    EXPECT_EQ(LoadStoredHash(file_path.string()), "");
+    EXPECT_NE(FileManager::GetFileHash(file_path.string()), real_hash);
+    EXPECT_NE(FileManager::GetFileHash(file_path.string()), "cafe");
+}
+
+TEST_F(MiniDFSFileManagerTest, HashCacheHitsPersistAndInvalidate) {
+    std::string index_path = FileManager::ResolvePath(test_mount, "index.hashcache").string();
+    fs::path file_path = FileManager::ResolvePath(test_mount, "cached.bin");
+    {
+        std::ofstream out(file_path, std::ios::binary);
+        out << std::string(CHUNK_SIZE * 4, 'c');
+    }
+    std::string expected = FileManager::GetFileHash(file_path.string());
+
+    {
+        HashCache cache(index_path);
+        EXPECT_EQ(cache.GetFileHash(file_path.string()), expected);
+        EXPECT_EQ(cache.GetFileHash(file_path.string()), expected);
+        EXPECT_EQ(cache.Misses(), 1u);
+        EXPECT_EQ(cache.Hits(), 1u);
+    }
+    ASSERT_TRUE(fs::exists(index_path));
+
+    // a fresh instance starts warm from the saved index
+    HashCache reloaded(index_path);
+    EXPECT_EQ(reloaded.Size(), 1u);
+    EXPECT_EQ(reloaded.GetFileHash(file_path.string()), expected);
+    EXPECT_EQ(reloaded.Hits(), 1u);
+    EXPECT_EQ(reloaded.Misses(), 0u);
+
+    {
+        std::ofstream out(file_path, std::ios::binary | std::ios::app);
+        out << "changed";
+    }
+    EXPECT_NE(reloaded.GetFileHash(file_path.string()), expected);
+    EXPECT_EQ(reloaded.Misses(), 1u);
+}
+
+TEST_F(MiniDFSFileManagerTest, HashCacheEvictsLeastRecentlyUsed) {
+    std::string index_path = FileManager::ResolvePath(test_mount, "lru.hashcache").string();
+    std::vector<std::string> paths;
+    for (int i = 0; i < 3; i++) {
+        fs::path file_path = FileManager::ResolvePath(test_mount, "lru_" + std::to_string(i) + ".bin");
+        std::ofstream out(file_path, std::ios::binary);
+        out << std::string(1024, static_cast<char>('a' + i));
+        paths.push_back(file_path.string());
+    }
+
+    {
+        HashCache cache(index_path, 2);
+        cache.GetFileHash(paths[0]);
+        cache.GetFileHash(paths[1]);
+        // touching the first file leaves the second as the one to evict
+        cache.GetFileHash(paths[0]);
+        cache.GetFileHash(paths[2]);
+        EXPECT_EQ(cache.Size(), 2u);
+        EXPECT_EQ(cache.Misses(), 3u);
+
+        cache.GetFileHash(paths[0]);
+        cache.GetFileHash(paths[2]);
+        EXPECT_EQ(cache.Hits(), 3u);
+        cache.GetFileHash(paths[1]);
+        EXPECT_EQ(cache.Misses(), 4u);
+    }
+
+    // the saved index holds the two most recently used files
+    HashCache reloaded(index_path, 2);
+    EXPECT_EQ(reloaded.Size(), 2u);
+    reloaded.GetFileHash(paths[2]);
+    reloaded.GetFileHash(paths[1]);
+    EXPECT_EQ(reloaded.Hits(), 2u);
+    reloaded.GetFileHash(paths[0]);
+    EXPECT_EQ(reloaded.Misses(), 1u);
+}
+
+TEST_F(MiniDFSFileManagerTest, HashCacheIndexIsAppendedAndCompacted) {
+    std::string index_path = FileManager::ResolvePath(test_mount, "log.hashcache").string();
+    constexpr size_t kMaxEntries = 8;
+    constexpr uintmax_t kMagicBytes = 8;
+    std::vector<std::string> paths;
+    for (int i = 0; i < 3 * HASH_CACHE_FLUSH_INTERVAL + 1; i++) {
+        fs::path file_path = FileManager::ResolvePath(test_mount, "log_" + std::to_string(i) + ".bin");
+        std::ofstream out(file_path, std::ios::binary);
+        out << "file " << i;
+        paths.push_back(file_path.string());
+    }
+
+    uintmax_t logged_bytes = 0;
+    {
+        HashCache cache(index_path, kMaxEntries);
+        for (const std::string& path : paths) cache.GetFileHash(path);
+        EXPECT_EQ(cache.Size(), kMaxEntries);
+        logged_bytes = fs::file_size(index_path);
+    }
+    // shutdown compacts the index down to the live entries
+    uintmax_t record_bytes = (fs::file_size(index_path) - kMagicBytes) / kMaxEntries;
+    ASSERT_GT(record_bytes, 0u);
+    EXPECT_EQ(fs::file_size(index_path), kMagicBytes + kMaxEntries * record_bytes);
+    // records of evicted entries were dropped along the way instead of piling up
+    EXPECT_GT(logged_bytes, kMagicBytes);
+    EXPECT_LE(logged_bytes, kMagicBytes + (2 * kMaxEntries + 2 * HASH_CACHE_FLUSH_INTERVAL) * record_bytes);
+
+    // a record cut short by a crash is ignored and does not misalign later appends
+    {
+        std::ofstream out(index_path, std::ios::binary | std::ios::app);
+        out << "torn";
+    }
+    {
+        HashCache reloaded(index_path, kMaxEntries);
+        EXPECT_EQ(reloaded.Size(), kMaxEntries);
+        reloaded.GetFileHash(paths.front());
+        EXPECT_EQ(reloaded.Misses(), 1u);
+    }
+    HashCache again(index_path, kMaxEntries);
+    EXPECT_EQ(again.Size(), kMaxEntries);
+    again.GetFileHash(paths.front());
+    again.GetFileHash(paths.back());
+    EXPECT_EQ(again.Hits(), 2u);
+}
+
+TEST_F(MiniDFSFileManagerTest, ScanDirectoryReportsTypeSizeAndMtime) {
+    fs::path dir = FileManager::ResolvePath(test_mount, "scan");
+    fs::create_directories(dir / "sub");
+    {
+        std::ofstream out(dir / "five.txt", std::ios::binary);
+        out << "12345";
+    }
+
+    std::vector<DirEntryInfo> entries;
+    ASSERT_TRUE(ScanDirectory(dir.string(), &entries));
+    ASSERT_EQ(entries.size(), 2u);
+    std::sort(entries.begin(), entries.end(), [](const DirEntryInfo& a, const DirEntryInfo& b) { return a.name < b.name; });
+
+    EXPECT_EQ(entries[0].name, "five.txt");
+    EXPECT_FALSE(entries[0].is_dir);
+    EXPECT_EQ(entries[0].size, 5u);
+    auto expected_mtime = std::chrono::file_clock::to_sys(fs::last_write_time(dir / "five.txt"));
+    EXPECT_EQ(entries[0].mtime_ns, static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(expected_mtime.time_since_epoch()).count()));
+
+    EXPECT_EQ(entries[1].name, "sub");
+    EXPECT_TRUE(entries[1].is_dir);
+    EXPECT_EQ(entries[1].size, 0u);
+
+    // times before the epoch stay negative instead of wrapping
+    auto before_epoch = std::chrono::sys_seconds(std::chrono::seconds(-86400)) + std::chrono::nanoseconds(500);
+    fs::last_write_time(dir / "five.txt", std::chrono::file_clock::from_sys(before_epoch));
+    DirEntryInfo old_entry;
+    ASSERT_TRUE(StatEntry((dir / "five.txt").string(), &old_entry));
+    EXPECT_EQ(old_entry.mtime_ns, -86400LL * 1000000000 + 500);
+
+    EXPECT_FALSE(ScanDirectory((dir / "missing").string(), &entries));
+}
+
+// Creates 100k files, too slow for the default run; use --gtest_also_run_disabled_tests.
+TEST_F(MiniDFSFileManagerTest, DISABLED_ScanDirectoryVersusDirectoryIterator100k) {
+    constexpr int kEntries = 100000;
+    fs::path dir = FileManager::ResolvePath(test_mount, "big");
+    fs::create_directories(dir);
+    for (int i = 0; i < kEntries; ++i) {
+        std::ofstream(dir / ("f" + std::to_string(i)));
+    }
+
+    // what ListFiles used to do, plus the size and mtime it never filled in
+    auto start = std::chrono::steady_clock::now();
+    size_t iterated = 0;
+    uint64_t iterated_bytes = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (!entry.is_directory()) {
+            iterated_bytes += entry.file_size();
+            entry.last_write_time();
+        }
+        ++iterated;
+    }
+    double iterator_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::vector<DirEntryInfo> entries;
+    ASSERT_TRUE(ScanDirectory(dir.string(), &entries));
+    double scan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(iterated, static_cast<size_t>(kEntries));
+    EXPECT_EQ(iterated_bytes, 0u);
+    EXPECT_EQ(entries.size(), static_cast<size_t>(kEntries));
+    RecordProperty("directory_iterator_ms", std::to_string(iterator_ms));
+    RecordProperty("scan_directory_ms", std::to_string(scan_ms));
+}
+
+TEST_F(MiniDFSFileManagerTest, GlobMatchWildcards) {
+    EXPECT_TRUE(GlobMatch("*", ""));
+    EXPECT_TRUE(GlobMatch("*.txt", "notes.txt"));
+    EXPECT_FALSE(GlobMatch("*.txt", "notes.txt.bak"));
+    EXPECT_TRUE(GlobMatch("a?c", "abc"));
+    EXPECT_FALSE(GlobMatch("a?c", "ac"));
+    EXPECT_TRUE(GlobMatch("*a*b*", "xxaxxbxx"));
+    EXPECT_FALSE(GlobMatch("*a*b", "xxbxxa"));
+    EXPECT_TRUE(GlobMatch("exact", "exact"));
+    EXPECT_FALSE(GlobMatch("exact", "exactly"));
+}
+
+TEST_F(MiniDFSFileManagerTest, TreeWalkBoundedBufferStillFinishes) {
+    fs::path root = FileManager::ResolvePath(test_mount, "walk");
+    for (int d = 0; d < 20; ++d) {
+        fs::path dir = root / ("d" + std::to_string(d));
+        fs::create_directories(dir);
+        for (int f = 0; f < 50; ++f) {
+            std::ofstream(dir / ("f" + std::to_string(f)));
+        }
+    }
+
+    ThreadPool pool(4);
+    std::mutex mu;
+    std::condition_variable cv;
+    bool ready = false;
+    // a buffer far smaller than the tree forces directories to park and resume
+    auto walk = TreeWalk::Start(&pool, root, "walk", TreeWalkOptions(), 16,
+        [](const fs::path&, const fs::path& vdir, const DirEntryInfo& entry, minidfs::FileInfo* info) {
+            info->set_file_path((vdir / entry.name).generic_string());
+        },
+        [&] {
+            std::lock_guard<std::mutex> lock(mu);
+            ready = true;
+            cv.notify_one();
+        });
+
+    std::set<std::string> seen;
+    bool done = false;
+    while (!done) {
+        std::vector<minidfs::FileInfo> batch;
+        if (!walk->TakeBatch(&batch, 8, &done)) {
+            std::unique_lock<std::mutex> lock(mu);
+            ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(10), [&] { return ready; }));
+            ready = false;
+            continue;
+        }
+        EXPECT_LE(batch.size(), 8u);
+        for (const auto& info : batch) seen.insert(info.file_path());
+    }
+
+    EXPECT_FALSE(walk->Failed());
+    EXPECT_EQ(seen.size(), 20u + 20u * 50u);
+}
+
+#ifdef MINIDFS_POSIX_IO
+TEST_F(MiniDFSFileManagerTest, PosixBackendWriteAtOffset) {
+    FileManager posix_fm(IoBackend::POSIX);
+    fs::path file_path = FileManager::ResolvePath(test_mount, "posix.txt");
+    std::string initial_data = "AAAAA";
+    std::string patch_data = "BB";
+
+    ASSERT_TRUE(posix_fm.AcquireWriteLock("client1", file_path.string(), true));
+    ASSERT_TRUE(posix_fm.WriteFile("client1", file_path.string(), 0, initial_data.data(), initial_data.size()));
+    ASSERT_TRUE(posix_fm.WriteFile("client1", file_path.string(), 2, patch_data.data(), patch_data.size()));
+    EXPECT_TRUE(posix_fm.SyncFile("client1", file_path.string()));
+    posix_fm.ReleaseWriteLock("client1", file_path.string());
+
+    char buffer[16];
+    size_t bytes_read = 0;
+    ASSERT_TRUE(posix_fm.AcquireReadLock("client1", file_path.string()));
+    ASSERT_TRUE(posix_fm.ReadFile("client1", file_path.string(), 0, buffer, &bytes_read));
+    posix_fm.ReleaseReadLock("client1", file_path.string());
+
+    EXPECT_EQ(std::string(buffer, bytes_read), "AABBA");
+}
+
+TEST_F(MiniDFSFileManagerTest, PosixVersusFstreamChunkThroughput) {
+    constexpr int kChunks = 256;
+    const std::vector<char> chunk(CHUNK_SIZE, 'P');
+
+    auto run = [&](IoBackend backend, const std::string& name) {
+        FileManager backend_fm(backend);
+        std::string fp = FileManager::ResolvePath(test_mount, name + ".bin").string();
+        std::vector<char> buf(CHUNK_SIZE);
+        size_t bytes_read = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(backend_fm.AcquireWriteLock("c", fp, true));
+        for (int c = 0; c < kChunks; ++c) {
+            EXPECT_TRUE(backend_fm.WriteFile("c", fp, static_cast<uint64_t>(c) * CHUNK_SIZE, chunk.data(), chunk.size()));
+        }
+        backend_fm.ReleaseWriteLock("c", fp);
+
+        EXPECT_TRUE(backend_fm.AcquireReadLock("c", fp));
+        for (int c = 0; c < kChunks; ++c) {
+            EXPECT_TRUE(backend_fm.ReadFile("c", fp, static_cast<uint64_t>(c) * CHUNK_SIZE, buf.data(), &bytes_read));
+            EXPECT_EQ(bytes_read, static_cast<size_t>(CHUNK_SIZE));
+        }
+        backend_fm.ReleaseReadLock("c", fp);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        EXPECT_EQ(fs::file_size(fp), static_cast<uintmax_t>(kChunks) * CHUNK_SIZE);
+        return 2.0 * kChunks * CHUNK_SIZE / (1024.0 * 1024.0) / std::chrono::duration<double>(elapsed).count();
+    };
+
+    double fstream_mbps = run(IoBackend::FSTREAM, "fstream");
+    double posix_mbps = run(IoBackend::POSIX, "posix");
+    RecordProperty("fstream_mbps", std::to_string(fstream_mbps));
+    RecordProperty("posix_mbps", std::to_string(posix_mbps));
+}
+#endif
+
+#ifdef MINIDFS_URING_IO
+TEST_F(MiniDFSFileManagerTest, UringBackendQueuedChunksRoundTrip) {
+    FileManager uring_fm(IoBackend::URING);
+    if (uring_fm.GetIoBackend() != IoBackend::URING) {
+        GTEST_SKIP() << "io_uring unavailable on this kernel";
+    }
+
+    constexpr int kChunks = 64;
+    std::string fp = FileManager::ResolvePath(test_mount, "uring.bin").string();
+    std::vector<std::vector<char>> chunks;
+    for (int c = 0; c < kChunks; ++c) {
+        chunks.emplace_back(CHUNK_SIZE, static_cast<char>('a' + c % 26));
+    }
+
+    // every chunk is in flight at once; completions arrive on the reaper thread
+    ASSERT_TRUE(uring_fm.AcquireWriteLock("c", fp, true));
+    std::vector<std::promise<bool>> writes(kChunks);
+    for (int c = 0; c < kChunks; ++c) {
+        uring_fm.WriteFileAsync("c", fp, static_cast<uint64_t>(c) * CHUNK_SIZE, chunks[c].data(), chunks[c].size(),
+            [&writes, c](bool ok) { writes[c].set_value(ok); });
+    }
+    for (auto& w : writes) {
+        EXPECT_TRUE(w.get_future().get());
+    }
+    uring_fm.ReleaseWriteLock("c", fp);
+    EXPECT_EQ(fs::file_size(fp), static_cast<uintmax_t>(kChunks) * CHUNK_SIZE);
+
+    ASSERT_TRUE(uring_fm.AcquireReadLock("c", fp));
+    std::vector<std::vector<char>> out(kChunks, std::vector<char>(CHUNK_SIZE));
+    std::vector<std::promise<size_t>> reads(kChunks);
+    for (int c = 0; c < kChunks; ++c) {
+        uring_fm.ReadFileAsync("c", fp, static_cast<uint64_t>(c) * CHUNK_SIZE, out[c].data(), CHUNK_SIZE,
+            [&reads, c](bool ok, size_t bytes_read) { reads[c].set_value(ok ? bytes_read : 0); });
+    }
+    for (int c = 0; c < kChunks; ++c) {
+        EXPECT_EQ(reads[c].get_future().get(), static_cast<size_t>(CHUNK_SIZE));
+        EXPECT_EQ(out[c], chunks[c]);
+    }
+
+    // past EOF completes with zero bytes, which FetchFile treats as end of stream
+    std::promise<size_t> eof;
+    uring_fm.ReadFileAsync("c", fp, static_cast<uint64_t>(kChunks) * CHUNK_SIZE, out[0].data(), CHUNK_SIZE,
+        [&eof](bool ok, size_t bytes_read) { eof.set_value(ok ? bytes_read : 1); });
+    EXPECT_EQ(eof.get_future().get(), 0u);
+    uring_fm.ReleaseReadLock("c", fp);
+}
+#endif
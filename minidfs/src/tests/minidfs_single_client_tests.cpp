@@ -1,13 +1,17 @@
 #include <gtest/gtest.h>
 #include <thread>
+#include <chrono>
 #include <atomic>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <filesystem>
 #include <random>
+#include <set>
 #include "dfs/client/minidfs_client.h"
 #include "dfs/server/minidfs_impl.h"
+#include "dfs/storage/cdc_chunker.h"
+#include "dfs/storage/crc32c.h"
 
 namespace fs = std::filesystem;
 
@@ -15,6 +19,7 @@ class MiniDFSSingleClientTest : public ::testing::Test {
 protected:
     const std::string server_mount = "server";
     const std::string client_mount = "client";
+    const std::string client_id = "C:/Users/mtcco/projects/minidfs/build/bin/Debug";
 
     std::unique_ptr<MiniDFSImpl> server_impl;
     std::unique_ptr<grpc::Server> server;
@@ -47,6 +52,19 @@ protected:
         return buffer;
     }
 
+    // What StoreFileResumable sends as StartUploadReq.source_version for the file.
+    int64_t SourceVersion(const fs::path& file_path) {
+        return static_cast<int64_t>(fs::last_write_time(file_path).time_since_epoch().count());
+    }
+
+    ListingCache* listing_cache() {
+        return server_impl->listing_cache_.get();
+    }
+
+    UploadManager* upload_manager() {
+        return server_impl->upload_manager_.get();
+    }
+
     void SetUp() override {
         fs::create_directories(server_mount);
         fs::create_directories(client_mount);
@@ -60,7 +78,7 @@ protected:
 
         // Client Setup
         shared_channel = grpc::CreateChannel("localhost:50051", grpc::InsecureChannelCredentials());
-        client = std::make_unique<MiniDFSClient>(shared_channel, client_mount, "C:/Users/mtcco/projects/minidfs/build/bin/Debug");
+        client = std::make_unique<MiniDFSClient>(shared_channel, client_mount, client_id);
     }
 
     void TearDown() override {
@@ -68,6 +86,8 @@ protected:
         server->Shutdown();
         fs::remove_all(server_mount);
         fs::remove_all(client_mount);
+        fs::remove_all(UploadManager::StateDirFor(server_mount));
+        fs::remove_all(ChunkStore::RootFor(server_mount));
     }
 };
 
@@ -102,6 +122,218 @@ TEST_F(MiniDFSSingleClientTest, ListFilesWithFiles) {
     EXPECT_NE(std::find(file_names.begin(), file_names.end(), "file2.txt"), file_names.end());
 }
 
+TEST_F(MiniDFSSingleClientTest, ListFilesFillsSizeAndMtime) {
+    fs::path dir_path = fs::path(server_mount) / fs::path(client_mount) / "list_test";
+    fs::create_directories(dir_path / "nested");
+    CreateLocalFile((dir_path / "sized.txt").string(), "0123456789");
+
+    minidfs::ListFilesRes response;
+    ASSERT_EQ(client->ListFiles(dir_path.string(), &response), grpc::StatusCode::OK);
+    ASSERT_EQ(response.files_size(), 2);
+
+    for (const auto& file : response.files()) {
+        EXPECT_GT(file.mtime(), 0);
+        if (fs::path(file.file_path()).filename() == "sized.txt") {
+            EXPECT_FALSE(file.is_dir());
+            EXPECT_EQ(file.size(), 10u);
+            EXPECT_FALSE(file.hash().empty());
+        } else {
+            EXPECT_TRUE(file.is_dir());
+        }
+    }
+}
+
+TEST_F(MiniDFSSingleClientTest, ListFilesStreamPagesLargeDirectory) {
+    constexpr int kFiles = 2500;
+    fs::path dir_path = fs::path(server_mount) / fs::path(client_mount) / "paged";
+    fs::create_directories(dir_path);
+    for (int i = 0; i < kFiles; ++i) {
+        CreateLocalFile((dir_path / ("f" + std::to_string(i))).string(), "x");
+    }
+
+    std::vector<int> page_sizes;
+    std::set<std::string> names;
+    grpc::StatusCode status = client->ListFilesStream(dir_path.string(), 1000,
+        [&](const minidfs::ListFilesRes& page) {
+            page_sizes.push_back(page.files_size());
+            for (const auto& file : page.files()) {
+                names.insert(fs::path(file.file_path()).filename().string());
+            }
+        });
+
+    ASSERT_EQ(status, grpc::StatusCode::OK);
+    EXPECT_EQ(page_sizes, (std::vector<int>{ 1000, 1000, 500 }));
+    EXPECT_EQ(names.size(), static_cast<size_t>(kFiles));
+}
+
+TEST_F(MiniDFSSingleClientTest, ListFilesStreamEmptyAndMissingDirectory) {
+    fs::path dir_path = fs::path(server_mount) / fs::path(client_mount) / "paged_empty";
+    fs::create_directories(dir_path);
+
+    int pages = 0;
+    auto count_pages = [&](const minidfs::ListFilesRes& page) {
+        EXPECT_EQ(page.files_size(), 0);
+        pages++;
+    };
+    EXPECT_EQ(client->ListFilesStream(dir_path.string(), 0, count_pages), grpc::StatusCode::OK);
+    EXPECT_EQ(pages, 1);
+
+    pages = 0;
+    fs::path missing = fs::path(server_mount) / fs::path(client_mount) / "paged_missing";
+    EXPECT_EQ(client->ListFilesStream(missing.string(), 0, count_pages), grpc::StatusCode::NOT_FOUND);
+    EXPECT_EQ(pages, 0);
+}
+
+TEST_F(MiniDFSSingleClientTest, WalkTreeDepthGlobAndMtimeFilters) {
+    fs::path root = fs::path(server_mount) / fs::path(client_mount) / "tree";
+    // 3 levels, 4 directories per level, 2 files per directory
+    std::vector<fs::path> dirs{ root };
+    std::vector<fs::path> frontier{ root };
+    for (int level = 0; level < 3; ++level) {
+        std::vector<fs::path> next;
+        for (const auto& dir : frontier) {
+            for (int d = 0; d < 4; ++d) next.push_back(dir / ("d" + std::to_string(d)));
+        }
+        dirs.insert(dirs.end(), next.begin(), next.end());
+        frontier = std::move(next);
+    }
+    for (const auto& dir : dirs) {
+        fs::create_directories(dir);
+        CreateLocalFile((dir / "a.txt").string(), "a");
+        CreateLocalFile((dir / "b.log").string(), "bb");
+    }
+
+    auto walk = [&](uint32_t depth, const std::string& glob, int64_t since, std::vector<minidfs::FileInfo>* out) {
+        return client->WalkTree(root.string(), depth, glob, since, [&](const minidfs::ListFilesRes& page) {
+            out->insert(out->end(), page.files().begin(), page.files().end());
+        });
+    };
+
+    std::vector<minidfs::FileInfo> all;
+    ASSERT_EQ(walk(0, "", 0, &all), grpc::StatusCode::OK);
+    size_t dir_count = dirs.size() - 1;
+    EXPECT_EQ(all.size(), dir_count + 2 * dirs.size());
+    std::set<std::string> paths;
+    for (const auto& f : all) paths.insert(f.file_path());
+    EXPECT_EQ(paths.size(), all.size());
+
+    std::vector<minidfs::FileInfo> top;
+    ASSERT_EQ(walk(1, "", 0, &top), grpc::StatusCode::OK);
+    EXPECT_EQ(top.size(), 4u + 2u);
+
+    std::vector<minidfs::FileInfo> logs;
+    ASSERT_EQ(walk(0, "*.log", 0, &logs), grpc::StatusCode::OK);
+    EXPECT_EQ(logs.size(), dirs.size());
+    for (const auto& f : logs) {
+        EXPECT_EQ(fs::path(f.file_path()).extension(), ".log");
+        EXPECT_EQ(f.size(), 2u);
+    }
+
+    int64_t newest = 0;
+    for (const auto& f : all) newest = std::max<int64_t>(newest, f.mtime());
+    std::vector<minidfs::FileInfo> changed;
+    ASSERT_EQ(walk(0, "", newest, &changed), grpc::StatusCode::OK);
+    EXPECT_TRUE(changed.empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CreateLocalFile((dirs.back() / "fresh.txt").string(), "new");
+    changed.clear();
+    ASSERT_EQ(walk(0, "", newest, &changed), grpc::StatusCode::OK);
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(fs::path(changed[0].file_path()).filename(), "fresh.txt");
+}
+
+TEST_F(MiniDFSSingleClientTest, WalkTreeSkipsSymlinkCycles) {
+    fs::path root = fs::path(server_mount) / fs::path(client_mount) / "cyclic";
+    fs::create_directories(root / "inner");
+    CreateLocalFile((root / "inner" / "file.txt").string(), "x");
+    std::error_code ec;
+    fs::create_directory_symlink(fs::absolute(root), root / "inner" / "loop", ec);
+    if (ec) GTEST_SKIP() << "cannot create symlinks here";
+
+    size_t entries = 0;
+    grpc::StatusCode status = client->WalkTree(root.string(), 0, "", 0, [&](const minidfs::ListFilesRes& page) {
+        entries += page.files_size();
+    });
+    ASSERT_EQ(status, grpc::StatusCode::OK);
+    // inner, inner/file.txt and the link itself, which is reported but not followed
+    EXPECT_EQ(entries, 3u);
+}
+
+TEST_F(MiniDFSSingleClientTest, ListFilesCacheInvalidatedByStoreAndRemove) {
+    fs::path dir_path = fs::path(server_mount) / fs::path(client_mount) / "cached";
+    fs::create_directories(dir_path);
+    CreateLocalFile((dir_path / "first.txt").string(), "1");
+
+    minidfs::ListFilesRes response;
+    ASSERT_EQ(client->ListFiles(dir_path.string(), &response), grpc::StatusCode::OK);
+    ASSERT_EQ(client->ListFiles(dir_path.string(), &response), grpc::StatusCode::OK);
+    EXPECT_EQ(response.files_size(), 1);
+    EXPECT_EQ(listing_cache()->Hits(), 1u);
+
+    // edited in place behind the server's back: the directory's mtime stays, the file's moves
+    fs::path first_path = dir_path / "first.txt";
+    CreateLocalFile(first_path.string(), "111");
+    fs::last_write_time(first_path, fs::last_write_time(first_path) + std::chrono::seconds(1));
+    response.Clear();
+    ASSERT_EQ(client->ListFiles(dir_path.string(), &response), grpc::StatusCode::OK);
+    ASSERT_EQ(response.files_size(), 1);
+    EXPECT_EQ(response.files(0).size(), 3u);
+    EXPECT_EQ(response.files(0).hash(), FileManager::GetFileHash(first_path.string()));
+    EXPECT_EQ(listing_cache()->Hits(), 1u);
+
+    fs::path client_file_path = fs::path(client_mount) / "cached" / "second.txt";
+    CreateLocalFile(client_file_path.string(), "22");
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    response.Clear();
+    ASSERT_EQ(client->ListFiles(dir_path.string(), &response), grpc::StatusCode::OK);
+    EXPECT_EQ(response.files_size(), 2);
+    EXPECT_EQ(listing_cache()->Hits(), 1u);
+
+    ASSERT_EQ(client->RemoveFile(client_file_path.string()), grpc::StatusCode::OK);
+    response.Clear();
+    ASSERT_EQ(client->ListFiles(dir_path.string(), &response), grpc::StatusCode::OK);
+    EXPECT_EQ(response.files_size(), 1);
+}
+
+TEST_F(MiniDFSSingleClientTest, ListingCacheEvictsLeastRecentlyUsed) {
+    auto listing = [](int files) {
+        auto res = std::make_shared<minidfs::ListFilesRes>();
+        for (int i = 0; i < files; ++i) {
+            res->add_files()->set_file_path(std::string(100, 'p') + std::to_string(i));
+        }
+        return res;
+    };
+    size_t one = listing(10)->SpaceUsedLong();
+    ListingCache cache(3 * one + 3 * 200);
+
+    cache.Put("a", 1, cache.BeginFill(), listing(10));
+    cache.Put("b", 1, cache.BeginFill(), listing(10));
+    cache.Put("c", 1, cache.BeginFill(), listing(10));
+    ASSERT_EQ(cache.Entries(), 3u);
+    // touch "a" so "b" becomes the eviction candidate
+    EXPECT_NE(cache.Get("a", 1), nullptr);
+    cache.Put("d", 1, cache.BeginFill(), listing(10));
+
+    EXPECT_EQ(cache.Entries(), 3u);
+    EXPECT_LE(cache.Bytes(), 3 * one + 3 * 200);
+    EXPECT_EQ(cache.Get("b", 1), nullptr);
+    EXPECT_NE(cache.Get("a", 1), nullptr);
+    EXPECT_NE(cache.Get("d", 1), nullptr);
+
+    // stale directory mtime and racing invalidations never serve or store old data
+    EXPECT_EQ(cache.Get("a", 2), nullptr);
+    uint64_t generation = cache.BeginFill();
+    cache.Invalidate("e");
+    cache.Put("e", 1, generation, listing(1));
+    EXPECT_EQ(cache.Get("e", 1), nullptr);
+
+    cache.SetMaxBytes(0);
+    EXPECT_EQ(cache.Entries(), 0u);
+    EXPECT_EQ(cache.Bytes(), 0u);
+}
+
 TEST_F(MiniDFSSingleClientTest, ListFilesNonExistentDirectory) {
     fs::path dir_path_client = fs::path(client_mount) / "non_existent_dir";
 
@@ -267,4 +499,793 @@ TEST_F(MiniDFSSingleClientTest, DeleteNonExistentFile) {
 
     grpc::StatusCode delete_status = client->RemoveFile(client_file_path.string());
     ASSERT_EQ(delete_status, grpc::StatusCode::NOT_FOUND);
-}
\ No newline at end of file
+}
+
+TEST_F(MiniDFSSingleClientTest, StoreAndFetchWithInlineLock) {
+    fs::path client_file_path = fs::path(client_mount) / "inline_lock.txt";
+    const std::string content = "Locked inside the stream.";
+    CreateLocalFile(client_file_path.string(), content);
+
+    client->SetInlineLocking(true);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "inline_lock.txt";
+    ASSERT_TRUE(fs::exists(server_file_path));
+
+    fs::remove(client_file_path);
+    ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+}
+
+TEST_F(MiniDFSSingleClientTest, StoreEmptyFileWithInlineLock) {
+    fs::path client_file_path = fs::path(client_mount) / "inline_empty.txt";
+    CreateLocalFile(client_file_path.string(), "");
+
+    client->SetInlineLocking(true);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "inline_empty.txt";
+    ASSERT_TRUE(fs::exists(server_file_path));
+    EXPECT_EQ(fs::file_size(server_file_path), 0);
+}
+
+TEST_F(MiniDFSSingleClientTest, StoreFileRecordsStreamedHash) {
+    fs::path probe = fs::path(server_mount) / "xattr_probe";
+    CreateLocalFile(probe.string(), "probe");
+    if (!SaveStoredHash(probe.string(), "00")) {
+        GTEST_SKIP() << "filesystem does not support user xattrs";
+    }
+
+    fs::path client_file_path = fs::path(client_mount) / "hashed.txt";
+    const std::string content(3 * CHUNK_SIZE + 17, 'h');
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    IncrementalHash expected;
+    expected.Update(content.data(), content.size());
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "hashed.txt";
+    std::string expected_hash = expected.Final();
+    EXPECT_EQ(LoadStoredHash(server_file_path.string()), expected_hash);
+    EXPECT_EQ(FileManager::GetFileHash(server_file_path.string()), expected_hash);
+}
+
+TEST_F(MiniDFSSingleClientTest, FetchFileRangeWritesAtMatchingOffset) {
+    fs::path client_file_path = fs::path(client_mount) / "ranged.bin";
+    std::string content(3 * CHUNK_SIZE + 100, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>('a' + i % 26);
+    CreateLocalFile(client_file_path.string(), content);
+    client->SetInlineLocking(true);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // a range crossing a chunk boundary replaces only those bytes of the local copy
+    std::string local(content.size(), '-');
+    CreateLocalFile(client_file_path.string(), local);
+    const uint64_t offset = CHUNK_SIZE - 10;
+    const uint64_t length = CHUNK_SIZE + 20;
+    ASSERT_EQ(client->FetchFile(client_file_path.string(), offset, length), grpc::StatusCode::OK);
+    local.replace(offset, length, content, offset, length);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), local);
+
+    // resuming: fetch the tail of a partial download into a missing file
+    fs::remove(client_file_path);
+    ASSERT_EQ(client->FetchFile(client_file_path.string(), 2 * CHUNK_SIZE, 0), grpc::StatusCode::OK);
+    std::string fetched = ReadLocalFile(client_file_path.string());
+    ASSERT_EQ(fetched.size(), content.size());
+    EXPECT_EQ(fetched.substr(2 * CHUNK_SIZE), content.substr(2 * CHUNK_SIZE));
+
+    EXPECT_EQ(client->FetchFile(client_file_path.string(), content.size(), 0), grpc::StatusCode::OK);
+    EXPECT_EQ(client->FetchFile(client_file_path.string(), content.size() + 1, 0), grpc::StatusCode::OUT_OF_RANGE);
+}
+
+TEST_F(MiniDFSSingleClientTest, ResumableUploadContinuesFromCommittedOffset) {
+    fs::path client_file_path = fs::path(client_mount) / "resumed.bin";
+    std::string content(5 * CHUNK_SIZE + 123, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 31 % 251);
+    CreateLocalFile(client_file_path.string(), content);
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "resumed.bin";
+
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    minidfs::UploadStatus started;
+    {
+        minidfs::StartUploadReq request;
+        request.set_client_id(client_id);
+        request.set_file_path(client_file_path.string());
+        request.set_size(content.size());
+        request.set_source_version(SourceVersion(client_file_path));
+        grpc::ClientContext context;
+        ASSERT_TRUE(stub->StartUpload(&context, request, &started).ok());
+        EXPECT_EQ(started.committed(), 0);
+    }
+
+    auto send = [&](uint64_t offset, size_t length, minidfs::UploadStatus* response) {
+        grpc::ClientContext context;
+        auto writer = stub->UploadChunks(&context, response);
+        minidfs::FileBuffer chunk;
+        chunk.set_upload_id(started.upload_id());
+        chunk.set_offset(offset);
+        chunk.set_data(content.substr(offset, length));
+        writer->Write(chunk);
+        writer->WritesDone();
+        return writer->Finish().error_code();
+    };
+
+    // the stream ends early, as if the connection dropped: nothing lands in the mount yet
+    minidfs::UploadStatus partial;
+    ASSERT_EQ(send(0, 2 * CHUNK_SIZE, &partial), grpc::StatusCode::OK);
+    EXPECT_FALSE(partial.complete());
+    EXPECT_EQ(partial.committed(), 2 * CHUNK_SIZE);
+    EXPECT_FALSE(fs::exists(server_file_path));
+
+    minidfs::UploadStatus status;
+    {
+        minidfs::UploadStatusReq request;
+        request.set_upload_id(started.upload_id());
+        grpc::ClientContext context;
+        ASSERT_TRUE(stub->GetUploadStatus(&context, request, &status).ok());
+        EXPECT_EQ(status.committed(), 2 * CHUNK_SIZE);
+        EXPECT_EQ(status.size(), content.size());
+    }
+
+    // leaving a gap is refused
+    minidfs::UploadStatus gap;
+    EXPECT_EQ(send(3 * CHUNK_SIZE, 10, &gap), grpc::StatusCode::OUT_OF_RANGE);
+
+    // the client finds the same session and only sends the remainder
+    ASSERT_EQ(client->StoreFileResumable(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+
+    minidfs::UploadStatusReq request;
+    request.set_upload_id(started.upload_id());
+    grpc::ClientContext context;
+    EXPECT_EQ(stub->GetUploadStatus(&context, request, &status).error_code(), grpc::StatusCode::NOT_FOUND);
+    EXPECT_EQ(upload_manager()->Size(), 0);
+}
+
+TEST_F(MiniDFSSingleClientTest, ResumableUploadRestartsForEditedFile) {
+    fs::path client_file_path = fs::path(client_mount) / "edited.bin";
+    const std::string old_content(4 * CHUNK_SIZE, 'o');
+    CreateLocalFile(client_file_path.string(), old_content);
+
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    minidfs::UploadStatus started;
+    {
+        minidfs::StartUploadReq request;
+        request.set_client_id(client_id);
+        request.set_file_path(client_file_path.string());
+        request.set_size(old_content.size());
+        request.set_source_version(SourceVersion(client_file_path));
+        grpc::ClientContext context;
+        ASSERT_TRUE(stub->StartUpload(&context, request, &started).ok());
+    }
+    {
+        grpc::ClientContext context;
+        minidfs::UploadStatus response;
+        auto writer = stub->UploadChunks(&context, &response);
+        minidfs::FileBuffer chunk;
+        chunk.set_upload_id(started.upload_id());
+        chunk.set_data(old_content.substr(0, 2 * CHUNK_SIZE));
+        writer->Write(chunk);
+        writer->WritesDone();
+        ASSERT_TRUE(writer->Finish().ok());
+        EXPECT_EQ(response.committed(), 2 * CHUNK_SIZE);
+    }
+
+    // same size, new bytes: the old prefix must not be resumed
+    const std::string new_content(old_content.size(), 'n');
+    CreateLocalFile(client_file_path.string(), new_content);
+    fs::last_write_time(client_file_path, fs::last_write_time(client_file_path) + std::chrono::seconds(1));
+    ASSERT_EQ(client->StoreFileResumable(client_file_path.string()), grpc::StatusCode::OK);
+
+    fs::path server_file_path = fs::path(server_mount) / client_file_path;
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), new_content);
+    EXPECT_EQ(upload_manager()->Size(), 0);
+}
+
+TEST_F(MiniDFSSingleClientTest, ResumableUploadReplacesExistingFile) {
+    fs::path client_file_path = fs::path(client_mount) / "replaced.txt";
+    CreateLocalFile(client_file_path.string(), std::string(4 * CHUNK_SIZE, 'o'));
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // shorter than the old file: nothing of the old tail may survive
+    const std::string content(CHUNK_SIZE + 5, 'n');
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFileResumable(client_file_path.string()), grpc::StatusCode::OK);
+
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "replaced.txt";
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+    EXPECT_EQ(FileManager::GetFileHash(server_file_path.string()), FileManager::GetFileHash(client_file_path.string()));
+
+    // empty files go through the same path
+    CreateLocalFile(client_file_path.string(), "");
+    ASSERT_EQ(client->StoreFileResumable(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(fs::file_size(server_file_path), 0);
+}
+
+TEST_F(MiniDFSSingleClientTest, StripedUploadCommitsAllStripesTogether) {
+    fs::path client_file_path = fs::path(client_mount) / "striped.bin";
+    std::string content(20 * CHUNK_SIZE + 7, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 13 % 253);
+    CreateLocalFile(client_file_path.string(), content);
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "striped.bin";
+
+    // one stripe arrives partially, as if its stream dropped
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    minidfs::UploadStatus started;
+    {
+        minidfs::StartUploadReq request;
+        request.set_client_id(client_id);
+        request.set_file_path(client_file_path.string());
+        request.set_size(content.size());
+        request.set_source_version(SourceVersion(client_file_path));
+        request.set_stripes(4);
+        grpc::ClientContext context;
+        ASSERT_TRUE(stub->StartUpload(&context, request, &started).ok());
+        ASSERT_EQ(started.stripe_committed_size(), 4);
+    }
+    const uint64_t stripe_begin = started.stripe_size();
+    {
+        grpc::ClientContext context;
+        minidfs::UploadStatus response;
+        auto writer = stub->UploadChunks(&context, &response);
+        minidfs::FileBuffer chunk;
+        chunk.set_upload_id(started.upload_id());
+        chunk.set_stripe(1);
+        chunk.set_offset(stripe_begin);
+        chunk.set_data(content.substr(stripe_begin, CHUNK_SIZE));
+        writer->Write(chunk);
+        writer->WritesDone();
+        ASSERT_TRUE(writer->Finish().ok());
+        EXPECT_FALSE(response.complete());
+        EXPECT_EQ(response.committed(), CHUNK_SIZE);
+        EXPECT_EQ(response.stripe_committed(1), stripe_begin + CHUNK_SIZE);
+    }
+    EXPECT_FALSE(fs::exists(server_file_path));
+
+    ASSERT_EQ(client->StoreFileStriped(client_file_path.string(), 4), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+    EXPECT_EQ(upload_manager()->Size(), 0);
+
+    // files smaller than the stripe count just use fewer stripes
+    CreateLocalFile(client_file_path.string(), "abc");
+    ASSERT_EQ(client->StoreFileStriped(client_file_path.string(), 8), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), "abc");
+}
+
+TEST_F(MiniDFSSingleClientTest, ParallelFetchReassemblesRanges) {
+    fs::path client_file_path = fs::path(client_mount) / "parallel.bin";
+    std::string content(FETCH_STREAM_MIN_SIZE + 3 * CHUNK_SIZE + 11, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 31 % 251);
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // a stale, longer local copy is cut to the server's size
+    CreateLocalFile(client_file_path.string(), content + std::string(CHUNK_SIZE, 'x'));
+    ASSERT_EQ(client->FetchFileParallel(client_file_path.string(), 4), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+
+    client->SetInlineLocking(true);
+    CreateLocalFile(client_file_path.string(), "");
+    ASSERT_EQ(client->FetchFileParallel(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+
+    // every stream's read lock was released: a writer gets straight in
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // small files never leave the head stream
+    CreateLocalFile(client_file_path.string(), "");
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+    CreateLocalFile(client_file_path.string(), "stale");
+    ASSERT_EQ(client->FetchFileParallel(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), "");
+}
+
+TEST_F(MiniDFSSingleClientTest, FetchReadAheadThroughput) {
+    fs::path client_file_path = fs::path(client_mount) / "read_ahead.bin";
+    std::string content(32 * 1024 * 1024 + 5, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 7 % 241);
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // measures the read path; large files otherwise go out as mapped slices
+    server_impl->SetFetchMmap(false);
+    auto run = [&](size_t read_ahead) {
+        server_impl->SetFetchReadAhead(read_ahead);
+        fs::remove(client_file_path);
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+        return content.size() / (1024.0 * 1024.0) / std::chrono::duration<double>(elapsed).count();
+    };
+
+    double serial_mbps = run(0);
+    double read_ahead_mbps = run(FETCH_READ_AHEAD);
+    RecordProperty("serial_mbps", std::to_string(serial_mbps));
+    RecordProperty("read_ahead_mbps", std::to_string(read_ahead_mbps));
+
+    // ranges stop at their end even with reads queued past it
+    server_impl->SetFetchReadAhead(FETCH_READ_AHEAD);
+    CreateLocalFile(client_file_path.string(), "");
+    ASSERT_EQ(client->FetchFile(client_file_path.string(), CHUNK_SIZE + 3, 2 * CHUNK_SIZE), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()).substr(CHUNK_SIZE + 3), content.substr(CHUNK_SIZE + 3, 2 * CHUNK_SIZE));
+}
+
+TEST_F(MiniDFSSingleClientTest, MappedFetchMatchesReadPath) {
+    fs::path client_file_path = fs::path(client_mount) / "mapped.bin";
+    std::string content(FETCH_MMAP_MIN_SIZE + 3 * CHUNK_SIZE + 17, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 13 % 251);
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    for (bool mmap : {true, false}) {
+        server_impl->SetFetchMmap(mmap);
+        fs::remove(client_file_path);
+        ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+
+        // a range ending mid-chunk, and a resume from exactly the end of the file
+        CreateLocalFile(client_file_path.string(), "");
+        ASSERT_EQ(client->FetchFile(client_file_path.string(), CHUNK_SIZE + 5, 2 * CHUNK_SIZE + 1), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()).substr(CHUNK_SIZE + 5), content.substr(CHUNK_SIZE + 5, 2 * CHUNK_SIZE + 1));
+        EXPECT_EQ(client->FetchFile(client_file_path.string(), content.size(), 0), grpc::StatusCode::OK);
+    }
+    server_impl->SetFetchMmap(true);
+}
+
+TEST_F(MiniDFSSingleClientTest, NegotiatedChunkSizes) {
+    fs::path client_file_path = fs::path(client_mount) / "chunk_sizes.bin";
+    std::string content(8 * 1024 * 1024 + 11, '\0');
+    for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 31 % 239);
+    CreateLocalFile(client_file_path.string(), content);
+
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    const size_t max_chunk = MaxChunkSize(MAX_MESSAGE_SIZE);
+    // payload size of every chunk a whole-file fetch streams back
+    auto fetch_chunk_sizes = [&](size_t chunk_size, bool adaptive) {
+        minidfs::FetchFileReq request;
+        request.set_client_id(client_id);
+        request.set_file_path(client_file_path.string());
+        request.set_acquire_lock(true);
+        request.set_chunk_size(static_cast<uint32_t>(chunk_size));
+        request.set_max_chunk_size(static_cast<uint32_t>(max_chunk));
+        request.set_adaptive_chunks(adaptive);
+        grpc::ClientContext context;
+        auto reader = stub->FetchFile(&context, request);
+        std::vector<size_t> sizes;
+        size_t total = 0;
+        minidfs::FileBuffer chunk;
+        while (reader->Read(&chunk)) {
+            sizes.push_back(chunk.data().size());
+            total += chunk.data().size();
+        }
+        EXPECT_TRUE(reader->Finish().ok());
+        EXPECT_EQ(total, content.size());
+        return sizes;
+    };
+
+    // oversized requests are clamped under the message limit instead of failing the stream
+    for (size_t chunk_size : {size_t(0), size_t(1024 * 1024), size_t(64 * 1024 * 1024)}) {
+        client->SetChunkSize(chunk_size);
+        ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+        ASSERT_EQ(client->StoreFileResumable(client_file_path.string()), grpc::StatusCode::OK);
+        fs::remove(client_file_path);
+        ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+
+        const size_t expected = NegotiateChunkSize(chunk_size, max_chunk);
+        EXPECT_LE(expected, max_chunk);
+        for (bool mmap : {true, false}) {
+            server_impl->SetFetchMmap(mmap);
+            std::vector<size_t> sizes = fetch_chunk_sizes(chunk_size, false);
+            ASSERT_FALSE(sizes.empty());
+            // every chunk but the last is exactly the negotiated size
+            for (size_t i = 0; i + 1 < sizes.size(); ++i) {
+                ASSERT_EQ(sizes[i], expected);
+            }
+            EXPECT_LE(sizes.back(), expected);
+        }
+    }
+
+    // adaptive chunks stay within bounds and actually move off the starting size
+    server_impl->SetFetchMmap(false);
+    std::vector<size_t> sizes = fetch_chunk_sizes(0, true);
+    ASSERT_GT(sizes.size(), 2u * CHUNK_SAMPLE_WINDOW);
+    std::set<size_t> seen;
+    for (size_t i = 0; i + 1 < sizes.size(); ++i) {
+        EXPECT_GE(sizes[i], static_cast<size_t>(MIN_CHUNK_SIZE));
+        EXPECT_LE(sizes[i], max_chunk);
+        seen.insert(sizes[i]);
+    }
+    EXPECT_EQ(sizes.front(), static_cast<size_t>(CHUNK_SIZE));
+    EXPECT_GT(seen.size(), 1u);
+    server_impl->SetFetchMmap(true);
+
+    // uploads stay under the limit the server reports, not just the client's own; a compressed
+    // chunk names its raw size, which the server checks against that limit
+    std::vector<minidfs::Codec> codecs = SupportedCodecs();
+    if (!codecs.empty()) {
+        server_impl->SetMaxMessageSize(2 * 1024 * 1024);
+        client->SetServerInfoTtl(std::chrono::milliseconds(0));
+        client->SetCompression(codecs.front());
+        client->SetChunkSize(64 * 1024 * 1024);
+        EXPECT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+        EXPECT_EQ(client->StoreFileDelta(client_file_path.string()), grpc::StatusCode::OK);
+        client->SetCompression(minidfs::CODEC_NONE);
+        client->SetServerInfoTtl(std::chrono::milliseconds(SERVER_INFO_TTL_MS));
+        server_impl->SetMaxMessageSize(MAX_MESSAGE_SIZE);
+    }
+    client->SetChunkSize(0);
+}
+
+TEST_F(MiniDFSSingleClientTest, TransfersReuseChunkBuffers) {
+    fs::path client_file_path = fs::path(client_mount) / "pooled.bin";
+    std::string content(64 * CHUNK_SIZE + 9, 'q');
+    CreateLocalFile(client_file_path.string(), content);
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+        ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+    }
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+
+    // allocations stay bounded by the buffers in use at once, not by the chunks moved
+    ChunkPoolStats client_stats = client->GetChunkPoolStats();
+    ChunkPoolStats server_stats = server_impl->GetChunkPoolStats();
+    EXPECT_EQ(client_stats.bytes, 8 * content.size());
+    EXPECT_EQ(server_stats.bytes, 8 * content.size());
+    EXPECT_LE(client_stats.allocations, 4u);
+    EXPECT_LE(server_stats.allocations, 2u * (FETCH_READ_AHEAD + 2));
+    RecordProperty("client_allocations_per_gb", std::to_string(client_stats.AllocationsPerGB()));
+    RecordProperty("server_allocations_per_gb", std::to_string(server_stats.AllocationsPerGB()));
+
+    // the server's counters are also reported to clients
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    grpc::ClientContext context;
+    minidfs::ServerInfoReq request;
+    minidfs::ServerInfo info;
+    ASSERT_TRUE(stub->GetServerInfo(&context, request, &info).ok());
+    ChunkPoolStats reported = server_impl->GetChunkPoolStats();
+    EXPECT_EQ(info.pool_bytes(), reported.bytes);
+    EXPECT_EQ(info.pool_allocations(), reported.allocations);
+    EXPECT_EQ(info.pool_reuses(), reported.reuses);
+    EXPECT_GT(info.pool_reuses(), 0u);
+    EXPECT_DOUBLE_EQ(info.pool_allocations_per_gb(), reported.AllocationsPerGB());
+}
+
+TEST_F(MiniDFSSingleClientTest, HeaderOnceStoreFile) {
+    fs::path dir_path = fs::path(client_mount) / std::string(120, 'd') / std::string(120, 'e');
+    fs::create_directories(dir_path);
+    fs::path client_file_path = dir_path / "header_once.bin";
+    fs::path server_file_path = fs::path(server_mount) / client_file_path;
+    std::string content(5 * CHUNK_SIZE + 3, 'h');
+
+    // either locking mode, and an empty file that is nothing but the header
+    client->SetHeaderOnceStreams(true);
+    for (bool inline_locking : {false, true}) {
+        client->SetInlineLocking(inline_locking);
+        for (const std::string& body : {std::string(), content}) {
+            CreateLocalFile(client_file_path.string(), body);
+            ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+            EXPECT_EQ(ReadLocalFile(server_file_path.string()), body);
+        }
+    }
+
+    // only the header names the file; the chunks after it are bare data
+    minidfs::FileBuffer legacy;
+    legacy.set_client_id(client_id);
+    legacy.set_file_path(client_file_path.string());
+    legacy.set_offset(CHUNK_SIZE);
+    legacy.set_data(std::string(CHUNK_SIZE, 'h'));
+    minidfs::FileBuffer bare;
+    bare.set_data(legacy.data());
+    EXPECT_GE(legacy.ByteSizeLong() - bare.ByteSizeLong(), client_file_path.string().size());
+
+    // a server refuses formats newer than its own rather than storing them wrong
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    grpc::ClientContext context;
+    minidfs::StoreFileRes response;
+    auto writer = stub->StoreFile(&context, &response);
+    minidfs::FileBuffer header;
+    header.mutable_header()->set_version(FILE_STREAM_VERSION + 1);
+    header.mutable_header()->set_client_id(client_id);
+    header.mutable_header()->set_file_path(client_file_path.string());
+    writer->Write(header);
+    writer->WritesDone();
+    EXPECT_EQ(writer->Finish().error_code(), grpc::StatusCode::UNIMPLEMENTED);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+}
+
+TEST_F(MiniDFSSingleClientTest, ChunksCarryVerifiedChecksums) {
+    fs::path client_file_path = fs::path(client_mount) / "checksummed.bin";
+    fs::path server_file_path = fs::path(server_mount) / client_file_path;
+    std::string content(FETCH_MMAP_MIN_SIZE + CHUNK_SIZE + 1, 'c');
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // every fetched chunk is checksummed, whether read or sent from the mapping
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    for (bool mmap : {true, false}) {
+        server_impl->SetFetchMmap(mmap);
+        ASSERT_EQ(client->GetReadLock(client_file_path.string()), grpc::StatusCode::OK);
+        minidfs::FetchFileReq request;
+        request.set_client_id(client_id);
+        request.set_file_path(client_file_path.string());
+        grpc::ClientContext context;
+        auto reader = stub->FetchFile(&context, request);
+        minidfs::FileBuffer chunk;
+        size_t chunks = 0;
+        while (reader->Read(&chunk)) {
+            ASSERT_TRUE(chunk.has_crc32c());
+            EXPECT_EQ(chunk.crc32c(), Crc32c(chunk.data().data(), chunk.data().size()));
+            chunks++;
+        }
+        EXPECT_TRUE(reader->Finish().ok());
+        EXPECT_GT(chunks, 1u);
+    }
+    server_impl->SetFetchMmap(true);
+
+    // a damaged upload chunk fails the stream and leaves the stored file as it was
+    client->SetInlineLocking(true);
+    grpc::ClientContext context;
+    minidfs::StoreFileRes response;
+    auto writer = stub->StoreFile(&context, &response);
+    minidfs::FileBuffer chunk;
+    chunk.set_client_id(client_id);
+    chunk.set_file_path(client_file_path.string());
+    chunk.set_acquire_lock(true);
+    chunk.set_data(std::string(CHUNK_SIZE, 'x'));
+    chunk.set_crc32c(Crc32c(chunk.data().data(), chunk.data().size()) ^ 1);
+    writer->Write(chunk);
+    writer->WritesDone();
+    EXPECT_EQ(writer->Finish().error_code(), grpc::StatusCode::DATA_LOSS);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+
+    fs::remove(client_file_path);
+    ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+}
+
+TEST_F(MiniDFSSingleClientTest, CompressedTransfers) {
+    std::vector<minidfs::Codec> codecs = SupportedCodecs();
+    if (codecs.empty()) GTEST_SKIP() << "built without any codec library";
+
+    fs::path client_file_path = fs::path(client_mount) / "log.csv";
+    fs::path server_file_path = fs::path(server_mount) / client_file_path;
+    std::string content;
+    for (int row = 0; content.size() < 2 * 1024 * 1024; ++row) {
+        content += std::to_string(row) + ",2024-05-0" + std::to_string(row % 9 + 1) + ",GET /api/files,200," + std::to_string(row * 37 % 1000) + "\n";
+    }
+    CreateLocalFile(client_file_path.string(), content);
+
+    for (minidfs::Codec codec : codecs) {
+        client->SetCompression(codec);
+        ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+        ASSERT_EQ(client->StoreFileStriped(client_file_path.string(), 2), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+
+        fs::remove(client_file_path);
+        ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+        ASSERT_EQ(client->FetchFile(client_file_path.string(), CHUNK_SIZE + 9, 3 * CHUNK_SIZE), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()), content);
+    }
+
+    CodecStats client_stats = client->GetCodecStats();
+    CodecStats server_stats = server_impl->GetCodecStats();
+    EXPECT_GT(client_stats.compressed_chunks, 0u);
+    EXPECT_GT(server_stats.decompressed_chunks, 0u);
+    EXPECT_GT(client_stats.Ratio(), 2.0);
+    EXPECT_GT(server_stats.Ratio(), 2.0);
+    RecordProperty("upload_ratio", std::to_string(client_stats.Ratio()));
+    RecordProperty("download_ratio", std::to_string(server_stats.Ratio()));
+
+    // the server reports its side to clients
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    grpc::ClientContext context;
+    minidfs::ServerInfo info;
+    ASSERT_TRUE(stub->GetServerInfo(&context, minidfs::ServerInfoReq(), &info).ok());
+    EXPECT_EQ(info.codec_compressed_chunks(), server_stats.compressed_chunks);
+    EXPECT_EQ(info.codec_decompressed_chunks(), server_stats.decompressed_chunks);
+    EXPECT_EQ(info.codec_raw_bytes(), server_stats.raw_bytes);
+    EXPECT_EQ(info.codec_wire_bytes(), server_stats.wire_bytes);
+    EXPECT_DOUBLE_EQ(info.codec_ratio(), server_stats.Ratio());
+    EXPECT_EQ(info.codec_compress_ns(), server_stats.compress_ns);
+    EXPECT_EQ(info.codec_decompress_ns(), server_stats.decompress_ns);
+    EXPECT_GT(info.codec_compress_ns(), 0u);
+
+    // incompressible data still arrives intact, as raw chunks
+    std::mt19937 rng(3);
+    std::string noise(8 * CHUNK_SIZE, '\0');
+    for (char& c : noise) c = static_cast<char>(rng());
+    CreateLocalFile(client_file_path.string(), noise);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), noise);
+    EXPECT_GT(client->GetCodecStats().skipped_chunks, client_stats.skipped_chunks);
+    client->SetCompression(minidfs::CODEC_NONE);
+}
+
+TEST_F(MiniDFSSingleClientTest, DeltaUploadSendsOnlyChanges) {
+    fs::path client_file_path = fs::path(client_mount) / "delta.bin";
+    fs::path server_file_path = fs::path(server_mount) / client_file_path;
+    std::mt19937 rng(5);
+    std::string content(4 * 1024 * 1024, '\0');
+    for (char& c : content) c = static_cast<char>(rng());
+    CreateLocalFile(client_file_path.string(), content);
+
+    // the server has no copy yet, so it goes up whole
+    ASSERT_EQ(client->StoreFileDelta(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+    EXPECT_EQ(client->GetDeltaStats().full_uploads, 1u);
+    EXPECT_EQ(client->GetDeltaStats().delta_uploads, 0u);
+
+    content.insert(12345, "a few inserted bytes");
+    content.replace(2 * 1024 * 1024, 100, std::string(100, 'x'));
+    content.erase(3 * 1024 * 1024, 777);
+    content += "appended";
+    CreateLocalFile(client_file_path.string(), content);
+    ASSERT_EQ(client->StoreFileDelta(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+    EXPECT_EQ(FileManager::GetFileHash(server_file_path.string()), FileManager::GetFileHash(client_file_path.string()));
+
+    DeltaStats stats = client->GetDeltaStats();
+    EXPECT_EQ(stats.delta_uploads, 1u);
+    EXPECT_EQ(stats.file_bytes, content.size());
+    // the signature is about 20 bytes per 2 KB block, plus a few blocks of literal data
+    EXPECT_LT(stats.wire_bytes, 96u * 1024);
+    RecordProperty("delta_wire_bytes", std::to_string(stats.wire_bytes));
+
+    // nothing changed: signature plus one message of copies
+    ASSERT_EQ(client->StoreFileDelta(client_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), content);
+    EXPECT_LT(client->GetDeltaStats().wire_bytes - stats.wire_bytes, 64u * 1024);
+
+    // small files are not worth a signature
+    fs::path small_file_path = fs::path(client_mount) / "small.txt";
+    CreateLocalFile(small_file_path.string(), "small");
+    ASSERT_EQ(client->StoreFileDelta(small_file_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile((fs::path(server_mount) / small_file_path).string()), "small");
+    EXPECT_EQ(client->GetDeltaStats().full_uploads, 2u);
+}
+
+TEST_F(MiniDFSSingleClientTest, DedupUploadReusesStoredChunks) {
+    server_impl->SetChunkStore(true);
+    fs::path first_path = fs::path(client_mount) / "dedup" / "first.bin";
+    fs::path copy_path = fs::path(client_mount) / "other" / "copy.bin";
+    std::mt19937 rng(23);
+    std::string content(4 * 1024 * 1024, '\0');
+    for (char& c : content) c = static_cast<char>(rng());
+    CreateLocalFile(first_path.string(), content);
+
+    // nothing stored yet, so it goes up whole
+    ASSERT_EQ(client->StoreFileDedup(first_path.string()), grpc::StatusCode::OK);
+    EXPECT_EQ(ReadLocalFile((fs::path(server_mount) / first_path).string()), content);
+    EXPECT_EQ(client->GetDeltaStats().full_uploads, 1u);
+    server_impl->FlushChunkStore();
+    EXPECT_EQ(server_impl->GetChunkStoreStats().files, 1u);
+
+    // an edited copy under another path only sends the chunks around the edits
+    std::string copy = "a new prefix" + content;
+    copy.replace(3 * 1024 * 1024, 100, std::string(100, 'x'));
+    CreateLocalFile(copy_path.string(), copy);
+    ASSERT_EQ(client->StoreFileDedup(copy_path.string()), grpc::StatusCode::OK);
+    fs::path server_copy_path = fs::path(server_mount) / copy_path;
+    EXPECT_EQ(ReadLocalFile(server_copy_path.string()), copy);
+    EXPECT_EQ(FileManager::GetFileHash(server_copy_path.string()), FileManager::GetFileHash(copy_path.string()));
+
+    DeltaStats stats = client->GetDeltaStats();
+    EXPECT_EQ(stats.delta_uploads, 1u);
+    EXPECT_EQ(stats.file_bytes, copy.size());
+    EXPECT_GT(stats.reused_bytes, copy.size() - 4 * CDC_MAX_CHUNK);
+    EXPECT_LT(stats.wire_bytes, 4u * CDC_MAX_CHUNK);
+    RecordProperty("dedup_wire_bytes", std::to_string(stats.wire_bytes));
+
+    server_impl->FlushChunkStore();
+    ChunkStoreStats store_stats = server_impl->GetChunkStoreStats();
+    EXPECT_EQ(store_stats.files, 2u);
+    EXPECT_EQ(store_stats.logical_bytes, content.size() + copy.size());
+    EXPECT_EQ(store_stats.reused_bytes, stats.reused_bytes);
+    EXPECT_GT(store_stats.PotentialRatio(), 1.5);
+    RecordProperty("potential_dedup_ratio", std::to_string(store_stats.PotentialRatio()));
+
+    // removing a file drops only the chunks nobody else uses
+    ASSERT_EQ(client->RemoveFile(first_path.string()), grpc::StatusCode::OK);
+    server_impl->FlushChunkStore();
+    store_stats = server_impl->GetChunkStoreStats();
+    EXPECT_EQ(store_stats.files, 1u);
+    EXPECT_EQ(store_stats.logical_bytes, copy.size());
+    EXPECT_LT(store_stats.unique_bytes, copy.size() + CDC_MAX_CHUNK);
+    server_impl->SetChunkStore(false);
+}
+
+TEST_F(MiniDFSSingleClientTest, ServerInfoIsRefreshedAfterTtl) {
+    std::mt19937 rng(29);
+    std::string content(2 * 1024 * 1024, '\0');
+    for (char& c : content) c = static_cast<char>(rng());
+    std::vector<fs::path> paths;
+    for (const char* name : { "first.bin", "second.bin", "third.bin" }) {
+        paths.push_back(fs::path(client_mount) / "ttl" / name);
+        CreateLocalFile(paths.back().string(), content);
+    }
+
+    // the client learns the chunk index is off, and keeps believing it within the TTL
+    ASSERT_EQ(client->StoreFileDedup(paths[0].string()), grpc::StatusCode::OK);
+    server_impl->SetChunkStore(true);
+    ASSERT_EQ(client->StoreFileDedup(paths[1].string()), grpc::StatusCode::OK);
+    EXPECT_EQ(client->GetDeltaStats().full_uploads, 2u);
+    server_impl->FlushChunkStore();
+
+    client->SetServerInfoTtl(std::chrono::milliseconds(0));
+    ASSERT_EQ(client->StoreFileDedup(paths[2].string()), grpc::StatusCode::OK);
+    EXPECT_EQ(client->GetDeltaStats().delta_uploads, 1u);
+    EXPECT_EQ(ReadLocalFile((fs::path(server_mount) / paths[2]).string()), content);
+    client->SetServerInfoTtl(std::chrono::milliseconds(SERVER_INFO_TTL_MS));
+    server_impl->SetChunkStore(false);
+}
+
+TEST_F(MiniDFSSingleClientTest, StoreFileIsAtomic) {
+    fs::path client_file_path = fs::path(client_mount) / "atomic.txt";
+    fs::path server_file_path = fs::path(server_mount) / fs::path(client_mount) / "atomic.txt";
+    const std::string old_content(3 * CHUNK_SIZE, 'o');
+    CreateLocalFile(client_file_path.string(), old_content);
+    client->SetInlineLocking(true);
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    auto stub = minidfs::MiniDFSService::NewStub(shared_channel);
+    minidfs::FileBuffer chunk;
+    chunk.set_client_id("other-client");
+    chunk.set_file_path(client_file_path.string());
+    chunk.set_acquire_lock(true);
+    chunk.set_data(std::string(CHUNK_SIZE, 'n'));
+
+    // an upload in flight neither blocks readers nor shows them its partial bytes
+    {
+        grpc::ClientContext context;
+        minidfs::StoreFileRes response;
+        auto writer = stub->StoreFile(&context, &response);
+        ASSERT_TRUE(writer->Write(chunk));
+        ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+        EXPECT_EQ(ReadLocalFile(client_file_path.string()), old_content);
+
+        // aborting it leaves the previous version whole
+        context.TryCancel();
+        writer->Finish();
+    }
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), old_content);
+
+    // a complete upload replaces the file outright, with no tail of the longer old version
+    {
+        grpc::ClientContext context;
+        minidfs::StoreFileRes response;
+        auto writer = stub->StoreFile(&context, &response);
+        ASSERT_TRUE(writer->Write(chunk));
+        writer->WritesDone();
+        ASSERT_TRUE(writer->Finish().ok());
+        EXPECT_TRUE(response.success());
+    }
+    EXPECT_EQ(ReadLocalFile(server_file_path.string()), chunk.data());
+
+    // staged files never linger once their streams are done
+    auto staged_files = [&]() {
+        size_t count = 0;
+        for (const auto& entry : fs::directory_iterator(UploadManager::StateDirFor(server_mount))) {
+            if (entry.path().extension() == ".tmp") count++;
+        }
+        return count;
+    };
+    for (int i = 0; i < 100 && staged_files() > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(staged_files(), 0);
+}
+
+TEST_F(MiniDFSSingleClientTest, FetchReleasesReadLock) {
+    fs::path client_file_path = fs::path(client_mount) / "relock.txt";
+    CreateLocalFile(client_file_path.string(), "first");
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+    ASSERT_EQ(client->FetchFile(client_file_path.string()), grpc::StatusCode::OK);
+
+    // a leaked read lock would leave this write queued until it timed out
+    CreateLocalFile(client_file_path.string(), "second");
+    ASSERT_EQ(client->StoreFile(client_file_path.string()), grpc::StatusCode::OK);
+}
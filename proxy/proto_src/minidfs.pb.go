@@ -119,31 +119,784 @@ func (FileUpdateType) EnumDescriptor() ([]byte, []int) {
 	return file_minidfs_proto_rawDescGZIP(), []int{1}
 }
 
+// Per-chunk compression of FileBuffer.data
+type Codec int32
+
+const (
+	Codec_CODEC_NONE    Codec = 0
+	Codec_CODEC_LZ4     Codec = 1
+	Codec_CODEC_ZSTD    Codec = 2
+	Codec_CODEC_DEFLATE Codec = 3
+)
+
+// Enum value maps for Codec.
+var (
+	Codec_name = map[int32]string{
+		0: "CODEC_NONE",
+		1: "CODEC_LZ4",
+		2: "CODEC_ZSTD",
+		3: "CODEC_DEFLATE",
+	}
+	Codec_value = map[string]int32{
+		"CODEC_NONE":    0,
+		"CODEC_LZ4":     1,
+		"CODEC_ZSTD":    2,
+		"CODEC_DEFLATE": 3,
+	}
+)
+
+func (x Codec) Enum() *Codec {
+	p := new(Codec)
+	*p = x
+	return p
+}
+
+func (x Codec) String() string {
+	return protoimpl.X.EnumStringOf(x.Descriptor(), protoreflect.EnumNumber(x))
+}
+
+func (Codec) Descriptor() protoreflect.EnumDescriptor {
+	return file_minidfs_proto_enumTypes[2].Descriptor()
+}
+
+func (Codec) Type() protoreflect.EnumType {
+	return &file_minidfs_proto_enumTypes[2]
+}
+
+func (x Codec) Number() protoreflect.EnumNumber {
+	return protoreflect.EnumNumber(x)
+}
+
+// Deprecated: Use Codec.Descriptor instead.
+func (Codec) EnumDescriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{2}
+}
+
 type FileBuffer struct {
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	ClientId string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	Data     []byte                 `protobuf:"bytes,3,opt,name=data,proto3" json:"data,omitempty"`
+	Offset   uint64                 `protobuf:"varint,4,opt,name=offset,proto3" json:"offset,omitempty"`
+	// Set on the first StoreFile message to take the write lock inside the
+	// stream instead of through a separate GetFileLock call.
+	AcquireLock bool `protobuf:"varint,5,opt,name=acquire_lock,json=acquireLock,proto3" json:"acquire_lock,omitempty"`
+	// Set on the first UploadChunks message; offset must not pass the committed offset.
+	UploadId string `protobuf:"bytes,6,opt,name=upload_id,json=uploadId,proto3" json:"upload_id,omitempty"`
+	// Which stripe of a striped upload this UploadChunks stream carries.
+	Stripe uint32 `protobuf:"varint,7,opt,name=stripe,proto3" json:"stripe,omitempty"`
+	// Set on the first FetchFile chunk: size of the whole file, not just the requested range.
+	FileSize uint64 `protobuf:"varint,8,opt,name=file_size,json=fileSize,proto3" json:"file_size,omitempty"`
+	// Header-once StoreFile streams: the first message carries only this, and every later one
+	// only data. Streams whose first message has no header are the legacy format, which
+	// repeats client_id and file_path on every chunk.
+	Header *StreamHeader `protobuf:"bytes,9,opt,name=header,proto3" json:"header,omitempty"`
+	// CRC-32C of the uncompressed data. Receivers verify it when present; senders that predate
+	// it leave it unset.
+	Crc32C *uint32 `protobuf:"fixed32,10,opt,name=crc32c,proto3,oneof" json:"crc32c,omitempty"`
+	// Set when data is compressed; raw_size is then its length uncompressed. Chunks that would
+	// not shrink go out as CODEC_NONE even on a compressed stream.
+	Codec   Codec  `protobuf:"varint,11,opt,name=codec,proto3,enum=minidfs.Codec" json:"codec,omitempty"`
+	RawSize uint32 `protobuf:"varint,12,opt,name=raw_size,json=rawSize,proto3" json:"raw_size,omitempty"`
+	// Set on the first FetchFile chunk when the stream holds a read lock. Passing it back in
+	// FetchFileReq or FileLockReq shares that lock even while a writer is queued for the file.
+	LockToken     uint64 `protobuf:"varint,13,opt,name=lock_token,json=lockToken,proto3" json:"lock_token,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *FileBuffer) Reset() {
+	*x = FileBuffer{}
+	mi := &file_minidfs_proto_msgTypes[0]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *FileBuffer) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*FileBuffer) ProtoMessage() {}
+
+func (x *FileBuffer) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[0]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use FileBuffer.ProtoReflect.Descriptor instead.
+func (*FileBuffer) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{0}
+}
+
+func (x *FileBuffer) GetClientId() string {
+	if x != nil {
+		return x.ClientId
+	}
+	return ""
+}
+
+func (x *FileBuffer) GetFilePath() string {
+	if x != nil {
+		return x.FilePath
+	}
+	return ""
+}
+
+func (x *FileBuffer) GetData() []byte {
+	if x != nil {
+		return x.Data
+	}
+	return nil
+}
+
+func (x *FileBuffer) GetOffset() uint64 {
+	if x != nil {
+		return x.Offset
+	}
+	return 0
+}
+
+func (x *FileBuffer) GetAcquireLock() bool {
+	if x != nil {
+		return x.AcquireLock
+	}
+	return false
+}
+
+func (x *FileBuffer) GetUploadId() string {
+	if x != nil {
+		return x.UploadId
+	}
+	return ""
+}
+
+func (x *FileBuffer) GetStripe() uint32 {
+	if x != nil {
+		return x.Stripe
+	}
+	return 0
+}
+
+func (x *FileBuffer) GetFileSize() uint64 {
+	if x != nil {
+		return x.FileSize
+	}
+	return 0
+}
+
+func (x *FileBuffer) GetHeader() *StreamHeader {
+	if x != nil {
+		return x.Header
+	}
+	return nil
+}
+
+func (x *FileBuffer) GetCrc32C() uint32 {
+	if x != nil && x.Crc32C != nil {
+		return *x.Crc32C
+	}
+	return 0
+}
+
+func (x *FileBuffer) GetCodec() Codec {
+	if x != nil {
+		return x.Codec
+	}
+	return Codec_CODEC_NONE
+}
+
+func (x *FileBuffer) GetRawSize() uint32 {
+	if x != nil {
+		return x.RawSize
+	}
+	return 0
+}
+
+func (x *FileBuffer) GetLockToken() uint64 {
+	if x != nil {
+		return x.LockToken
+	}
+	return 0
+}
+
+type StreamHeader struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// stream format the sender speaks; the server refuses versions newer than its own
+	Version       uint32 `protobuf:"varint,1,opt,name=version,proto3" json:"version,omitempty"`
+	ClientId      string `protobuf:"bytes,2,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath      string `protobuf:"bytes,3,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	AcquireLock   bool   `protobuf:"varint,4,opt,name=acquire_lock,json=acquireLock,proto3" json:"acquire_lock,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *StreamHeader) Reset() {
+	*x = StreamHeader{}
+	mi := &file_minidfs_proto_msgTypes[1]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *StreamHeader) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*StreamHeader) ProtoMessage() {}
+
+func (x *StreamHeader) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[1]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use StreamHeader.ProtoReflect.Descriptor instead.
+func (*StreamHeader) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{1}
+}
+
+func (x *StreamHeader) GetVersion() uint32 {
+	if x != nil {
+		return x.Version
+	}
+	return 0
+}
+
+func (x *StreamHeader) GetClientId() string {
+	if x != nil {
+		return x.ClientId
+	}
+	return ""
+}
+
+func (x *StreamHeader) GetFilePath() string {
+	if x != nil {
+		return x.FilePath
+	}
+	return ""
+}
+
+func (x *StreamHeader) GetAcquireLock() bool {
+	if x != nil {
+		return x.AcquireLock
+	}
+	return false
+}
+
+type FileSignatureReq struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	ClientId      string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath      string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *FileSignatureReq) Reset() {
+	*x = FileSignatureReq{}
+	mi := &file_minidfs_proto_msgTypes[2]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *FileSignatureReq) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*FileSignatureReq) ProtoMessage() {}
+
+func (x *FileSignatureReq) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[2]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use FileSignatureReq.ProtoReflect.Descriptor instead.
+func (*FileSignatureReq) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{2}
+}
+
+func (x *FileSignatureReq) GetClientId() string {
+	if x != nil {
+		return x.ClientId
+	}
+	return ""
+}
+
+func (x *FileSignatureReq) GetFilePath() string {
+	if x != nil {
+		return x.FilePath
+	}
+	return ""
+}
+
+// rsync-style signature: the file split into block_size blocks (the last one may be short),
+// each with a rolling checksum and the first DELTA_STRONG_SIZE bytes of its SHA-256.
+type FileSignature struct {
+	state     protoimpl.MessageState `protogen:"open.v1"`
+	FileSize  uint64                 `protobuf:"varint,1,opt,name=file_size,json=fileSize,proto3" json:"file_size,omitempty"`
+	BlockSize uint32                 `protobuf:"varint,2,opt,name=block_size,json=blockSize,proto3" json:"block_size,omitempty"`
+	Weak      []uint32               `protobuf:"fixed32,3,rep,packed,name=weak,proto3" json:"weak,omitempty"`
+	// one digest per block, concatenated
+	Strong        []byte `protobuf:"bytes,4,opt,name=strong,proto3" json:"strong,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *FileSignature) Reset() {
+	*x = FileSignature{}
+	mi := &file_minidfs_proto_msgTypes[3]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *FileSignature) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*FileSignature) ProtoMessage() {}
+
+func (x *FileSignature) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[3]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use FileSignature.ProtoReflect.Descriptor instead.
+func (*FileSignature) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{3}
+}
+
+func (x *FileSignature) GetFileSize() uint64 {
+	if x != nil {
+		return x.FileSize
+	}
+	return 0
+}
+
+func (x *FileSignature) GetBlockSize() uint32 {
+	if x != nil {
+		return x.BlockSize
+	}
+	return 0
+}
+
+func (x *FileSignature) GetWeak() []uint32 {
+	if x != nil {
+		return x.Weak
+	}
+	return nil
+}
+
+func (x *FileSignature) GetStrong() []byte {
+	if x != nil {
+		return x.Strong
+	}
+	return nil
+}
+
+// One of: a copy of blocks [block, block + blocks) of the server's copy, a chunk from the
+// server's chunk store named by its hash, or literal bytes.
+type DeltaOp struct {
+	state   protoimpl.MessageState `protogen:"open.v1"`
+	Block   uint64                 `protobuf:"varint,1,opt,name=block,proto3" json:"block,omitempty"`
+	Blocks  uint32                 `protobuf:"varint,2,opt,name=blocks,proto3" json:"blocks,omitempty"`
+	Literal []byte                 `protobuf:"bytes,3,opt,name=literal,proto3" json:"literal,omitempty"`
+	Chunk   string                 `protobuf:"bytes,4,opt,name=chunk,proto3" json:"chunk,omitempty"`
+	// the chunk's length, counted against DELTA_MAX_MESSAGE_OUTPUT
+	ChunkSize     uint32 `protobuf:"varint,5,opt,name=chunk_size,json=chunkSize,proto3" json:"chunk_size,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *DeltaOp) Reset() {
+	*x = DeltaOp{}
+	mi := &file_minidfs_proto_msgTypes[4]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *DeltaOp) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*DeltaOp) ProtoMessage() {}
+
+func (x *DeltaOp) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[4]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use DeltaOp.ProtoReflect.Descriptor instead.
+func (*DeltaOp) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{4}
+}
+
+func (x *DeltaOp) GetBlock() uint64 {
+	if x != nil {
+		return x.Block
+	}
+	return 0
+}
+
+func (x *DeltaOp) GetBlocks() uint32 {
+	if x != nil {
+		return x.Blocks
+	}
+	return 0
+}
+
+func (x *DeltaOp) GetLiteral() []byte {
+	if x != nil {
+		return x.Literal
+	}
+	return nil
+}
+
+func (x *DeltaOp) GetChunk() string {
+	if x != nil {
+		return x.Chunk
+	}
+	return ""
+}
+
+func (x *DeltaOp) GetChunkSize() uint32 {
+	if x != nil {
+		return x.ChunkSize
+	}
+	return 0
+}
+
+type DeltaHeader struct {
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	ClientId string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	// echoed from the FileSignature the delta was computed against; 0 when there is none and
+	// the delta only refers to stored chunks
+	BlockSize     uint32 `protobuf:"varint,3,opt,name=block_size,json=blockSize,proto3" json:"block_size,omitempty"`
+	BaseSize      uint64 `protobuf:"varint,4,opt,name=base_size,json=baseSize,proto3" json:"base_size,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *DeltaHeader) Reset() {
+	*x = DeltaHeader{}
+	mi := &file_minidfs_proto_msgTypes[5]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *DeltaHeader) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*DeltaHeader) ProtoMessage() {}
+
+func (x *DeltaHeader) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[5]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use DeltaHeader.ProtoReflect.Descriptor instead.
+func (*DeltaHeader) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{5}
+}
+
+func (x *DeltaHeader) GetClientId() string {
+	if x != nil {
+		return x.ClientId
+	}
+	return ""
+}
+
+func (x *DeltaHeader) GetFilePath() string {
+	if x != nil {
+		return x.FilePath
+	}
+	return ""
+}
+
+func (x *DeltaHeader) GetBlockSize() uint32 {
+	if x != nil {
+		return x.BlockSize
+	}
+	return 0
+}
+
+func (x *DeltaHeader) GetBaseSize() uint64 {
+	if x != nil {
+		return x.BaseSize
+	}
+	return 0
+}
+
+type DeltaChunk struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// first message only
+	Header *DeltaHeader `protobuf:"bytes,1,opt,name=header,proto3" json:"header,omitempty"`
+	// applied in order; together one message rebuilds at most DELTA_MAX_MESSAGE_OUTPUT bytes
+	Ops []*DeltaOp `protobuf:"bytes,2,rep,name=ops,proto3" json:"ops,omitempty"`
+	// Last message only: SHA-256 of the whole new file. The server refuses to commit a
+	// rebuilt file that does not match it.
+	FileHash      string `protobuf:"bytes,3,opt,name=file_hash,json=fileHash,proto3" json:"file_hash,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *DeltaChunk) Reset() {
+	*x = DeltaChunk{}
+	mi := &file_minidfs_proto_msgTypes[6]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *DeltaChunk) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*DeltaChunk) ProtoMessage() {}
+
+func (x *DeltaChunk) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[6]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use DeltaChunk.ProtoReflect.Descriptor instead.
+func (*DeltaChunk) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{6}
+}
+
+func (x *DeltaChunk) GetHeader() *DeltaHeader {
+	if x != nil {
+		return x.Header
+	}
+	return nil
+}
+
+func (x *DeltaChunk) GetOps() []*DeltaOp {
+	if x != nil {
+		return x.Ops
+	}
+	return nil
+}
+
+func (x *DeltaChunk) GetFileHash() string {
+	if x != nil {
+		return x.FileHash
+	}
+	return ""
+}
+
+type FindChunksReq struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// hex SHA-256 of each chunk
+	Hashes        []string `protobuf:"bytes,1,rep,name=hashes,proto3" json:"hashes,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *FindChunksReq) Reset() {
+	*x = FindChunksReq{}
+	mi := &file_minidfs_proto_msgTypes[7]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *FindChunksReq) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*FindChunksReq) ProtoMessage() {}
+
+func (x *FindChunksReq) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[7]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use FindChunksReq.ProtoReflect.Descriptor instead.
+func (*FindChunksReq) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{7}
+}
+
+func (x *FindChunksReq) GetHashes() []string {
+	if x != nil {
+		return x.Hashes
+	}
+	return nil
+}
+
+type FindChunksRes struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// indexes into hashes of the chunks the server does not have
+	Missing       []uint32 `protobuf:"varint,1,rep,packed,name=missing,proto3" json:"missing,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *FindChunksRes) Reset() {
+	*x = FindChunksRes{}
+	mi := &file_minidfs_proto_msgTypes[8]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *FindChunksRes) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*FindChunksRes) ProtoMessage() {}
+
+func (x *FindChunksRes) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[8]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use FindChunksRes.ProtoReflect.Descriptor instead.
+func (*FindChunksRes) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{8}
+}
+
+func (x *FindChunksRes) GetMissing() []uint32 {
+	if x != nil {
+		return x.Missing
+	}
+	return nil
+}
+
+// What the chunk index keeps for one file: its content-defined chunks, in order.
+type ChunkManifest struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	Size          uint64                 `protobuf:"varint,1,opt,name=size,proto3" json:"size,omitempty"`
+	Chunks        []*ChunkRef            `protobuf:"bytes,2,rep,name=chunks,proto3" json:"chunks,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *ChunkManifest) Reset() {
+	*x = ChunkManifest{}
+	mi := &file_minidfs_proto_msgTypes[9]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *ChunkManifest) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*ChunkManifest) ProtoMessage() {}
+
+func (x *ChunkManifest) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[9]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use ChunkManifest.ProtoReflect.Descriptor instead.
+func (*ChunkManifest) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{9}
+}
+
+func (x *ChunkManifest) GetSize() uint64 {
+	if x != nil {
+		return x.Size
+	}
+	return 0
+}
+
+func (x *ChunkManifest) GetChunks() []*ChunkRef {
+	if x != nil {
+		return x.Chunks
+	}
+	return nil
+}
+
+type ChunkRef struct {
 	state         protoimpl.MessageState `protogen:"open.v1"`
-	ClientId      string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
-	FilePath      string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
-	Data          []byte                 `protobuf:"bytes,3,opt,name=data,proto3" json:"data,omitempty"`
-	Offset        uint64                 `protobuf:"varint,4,opt,name=offset,proto3" json:"offset,omitempty"`
+	Hash          string                 `protobuf:"bytes,1,opt,name=hash,proto3" json:"hash,omitempty"`
+	Size          uint32                 `protobuf:"varint,2,opt,name=size,proto3" json:"size,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
 
-func (x *FileBuffer) Reset() {
-	*x = FileBuffer{}
-	mi := &file_minidfs_proto_msgTypes[0]
+func (x *ChunkRef) Reset() {
+	*x = ChunkRef{}
+	mi := &file_minidfs_proto_msgTypes[10]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
 
-func (x *FileBuffer) String() string {
+func (x *ChunkRef) String() string {
 	return protoimpl.X.MessageStringOf(x)
 }
 
-func (*FileBuffer) ProtoMessage() {}
+func (*ChunkRef) ProtoMessage() {}
 
-func (x *FileBuffer) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[0]
+func (x *ChunkRef) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[10]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -154,53 +907,40 @@ func (x *FileBuffer) ProtoReflect() protoreflect.Message {
 	return mi.MessageOf(x)
 }
 
-// Deprecated: Use FileBuffer.ProtoReflect.Descriptor instead.
-func (*FileBuffer) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{0}
-}
-
-func (x *FileBuffer) GetClientId() string {
-	if x != nil {
-		return x.ClientId
-	}
-	return ""
+// Deprecated: Use ChunkRef.ProtoReflect.Descriptor instead.
+func (*ChunkRef) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{10}
 }
 
-func (x *FileBuffer) GetFilePath() string {
+func (x *ChunkRef) GetHash() string {
 	if x != nil {
-		return x.FilePath
+		return x.Hash
 	}
 	return ""
 }
 
-func (x *FileBuffer) GetData() []byte {
-	if x != nil {
-		return x.Data
-	}
-	return nil
-}
-
-func (x *FileBuffer) GetOffset() uint64 {
+func (x *ChunkRef) GetSize() uint32 {
 	if x != nil {
-		return x.Offset
+		return x.Size
 	}
 	return 0
 }
 
 type FileInfo struct {
-	state         protoimpl.MessageState `protogen:"open.v1"`
-	FilePath      string                 `protobuf:"bytes,1,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
-	Size          uint64                 `protobuf:"varint,2,opt,name=size,proto3" json:"size,omitempty"`
-	Mtime         uint64                 `protobuf:"varint,3,opt,name=mtime,proto3" json:"mtime,omitempty"`
-	IsDir         bool                   `protobuf:"varint,4,opt,name=is_dir,json=isDir,proto3" json:"is_dir,omitempty"`
-	Hash          string                 `protobuf:"bytes,5,opt,name=hash,proto3" json:"hash,omitempty"`
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	FilePath string                 `protobuf:"bytes,1,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	Size     uint64                 `protobuf:"varint,2,opt,name=size,proto3" json:"size,omitempty"`
+	// nanoseconds since the Unix epoch, negative before it
+	Mtime         int64  `protobuf:"varint,3,opt,name=mtime,proto3" json:"mtime,omitempty"`
+	IsDir         bool   `protobuf:"varint,4,opt,name=is_dir,json=isDir,proto3" json:"is_dir,omitempty"`
+	Hash          string `protobuf:"bytes,5,opt,name=hash,proto3" json:"hash,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
 
 func (x *FileInfo) Reset() {
 	*x = FileInfo{}
-	mi := &file_minidfs_proto_msgTypes[1]
+	mi := &file_minidfs_proto_msgTypes[11]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -212,7 +952,7 @@ func (x *FileInfo) String() string {
 func (*FileInfo) ProtoMessage() {}
 
 func (x *FileInfo) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[1]
+	mi := &file_minidfs_proto_msgTypes[11]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -225,7 +965,7 @@ func (x *FileInfo) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use FileInfo.ProtoReflect.Descriptor instead.
 func (*FileInfo) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{1}
+	return file_minidfs_proto_rawDescGZIP(), []int{11}
 }
 
 func (x *FileInfo) GetFilePath() string {
@@ -242,7 +982,7 @@ func (x *FileInfo) GetSize() uint64 {
 	return 0
 }
 
-func (x *FileInfo) GetMtime() uint64 {
+func (x *FileInfo) GetMtime() int64 {
 	if x != nil {
 		return x.Mtime
 	}
@@ -264,15 +1004,17 @@ func (x *FileInfo) GetHash() string {
 }
 
 type ListFilesReq struct {
-	state         protoimpl.MessageState `protogen:"open.v1"`
-	Path          string                 `protobuf:"bytes,1,opt,name=path,proto3" json:"path,omitempty"`
+	state protoimpl.MessageState `protogen:"open.v1"`
+	Path  string                 `protobuf:"bytes,1,opt,name=path,proto3" json:"path,omitempty"`
+	// Entries per ListFilesStream page; 0 picks the server default. Ignored by ListFiles.
+	PageSize      uint32 `protobuf:"varint,2,opt,name=page_size,json=pageSize,proto3" json:"page_size,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
 
 func (x *ListFilesReq) Reset() {
 	*x = ListFilesReq{}
-	mi := &file_minidfs_proto_msgTypes[2]
+	mi := &file_minidfs_proto_msgTypes[12]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -284,7 +1026,7 @@ func (x *ListFilesReq) String() string {
 func (*ListFilesReq) ProtoMessage() {}
 
 func (x *ListFilesReq) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[2]
+	mi := &file_minidfs_proto_msgTypes[12]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -297,7 +1039,7 @@ func (x *ListFilesReq) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use ListFilesReq.ProtoReflect.Descriptor instead.
 func (*ListFilesReq) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{2}
+	return file_minidfs_proto_rawDescGZIP(), []int{12}
 }
 
 func (x *ListFilesReq) GetPath() string {
@@ -307,6 +1049,93 @@ func (x *ListFilesReq) GetPath() string {
 	return ""
 }
 
+func (x *ListFilesReq) GetPageSize() uint32 {
+	if x != nil {
+		return x.PageSize
+	}
+	return 0
+}
+
+type WalkTreeReq struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	Path  string                 `protobuf:"bytes,1,opt,name=path,proto3" json:"path,omitempty"`
+	// 0 walks the whole tree; 1 returns direct children only
+	MaxDepth uint32 `protobuf:"varint,2,opt,name=max_depth,json=maxDepth,proto3" json:"max_depth,omitempty"`
+	// '*'/'?' pattern matched against entry names; directories are still descended
+	NameGlob string `protobuf:"bytes,3,opt,name=name_glob,json=nameGlob,proto3" json:"name_glob,omitempty"`
+	// When non-zero, only files whose mtime (ns since the Unix epoch) is newer are returned
+	ModifiedSince int64 `protobuf:"varint,4,opt,name=modified_since,json=modifiedSince,proto3" json:"modified_since,omitempty"`
+	// Entries per page; 0 picks the server default
+	PageSize      uint32 `protobuf:"varint,5,opt,name=page_size,json=pageSize,proto3" json:"page_size,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *WalkTreeReq) Reset() {
+	*x = WalkTreeReq{}
+	mi := &file_minidfs_proto_msgTypes[13]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *WalkTreeReq) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*WalkTreeReq) ProtoMessage() {}
+
+func (x *WalkTreeReq) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[13]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use WalkTreeReq.ProtoReflect.Descriptor instead.
+func (*WalkTreeReq) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{13}
+}
+
+func (x *WalkTreeReq) GetPath() string {
+	if x != nil {
+		return x.Path
+	}
+	return ""
+}
+
+func (x *WalkTreeReq) GetMaxDepth() uint32 {
+	if x != nil {
+		return x.MaxDepth
+	}
+	return 0
+}
+
+func (x *WalkTreeReq) GetNameGlob() string {
+	if x != nil {
+		return x.NameGlob
+	}
+	return ""
+}
+
+func (x *WalkTreeReq) GetModifiedSince() int64 {
+	if x != nil {
+		return x.ModifiedSince
+	}
+	return 0
+}
+
+func (x *WalkTreeReq) GetPageSize() uint32 {
+	if x != nil {
+		return x.PageSize
+	}
+	return 0
+}
+
 type ListFilesRes struct {
 	state         protoimpl.MessageState `protogen:"open.v1"`
 	Files         []*FileInfo            `protobuf:"bytes,1,rep,name=files,proto3" json:"files,omitempty"`
@@ -316,7 +1145,7 @@ type ListFilesRes struct {
 
 func (x *ListFilesRes) Reset() {
 	*x = ListFilesRes{}
-	mi := &file_minidfs_proto_msgTypes[3]
+	mi := &file_minidfs_proto_msgTypes[14]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -328,7 +1157,7 @@ func (x *ListFilesRes) String() string {
 func (*ListFilesRes) ProtoMessage() {}
 
 func (x *ListFilesRes) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[3]
+	mi := &file_minidfs_proto_msgTypes[14]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -341,7 +1170,7 @@ func (x *ListFilesRes) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use ListFilesRes.ProtoReflect.Descriptor instead.
 func (*ListFilesRes) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{3}
+	return file_minidfs_proto_rawDescGZIP(), []int{14}
 }
 
 func (x *ListFilesRes) GetFiles() []*FileInfo {
@@ -361,59 +1190,299 @@ type StoreFileRes struct {
 
 func (x *StoreFileRes) Reset() {
 	*x = StoreFileRes{}
-	mi := &file_minidfs_proto_msgTypes[4]
+	mi := &file_minidfs_proto_msgTypes[15]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *StoreFileRes) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*StoreFileRes) ProtoMessage() {}
+
+func (x *StoreFileRes) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[15]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use StoreFileRes.ProtoReflect.Descriptor instead.
+func (*StoreFileRes) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{15}
+}
+
+func (x *StoreFileRes) GetMsg() string {
+	if x != nil {
+		return x.Msg
+	}
+	return ""
+}
+
+func (x *StoreFileRes) GetSuccess() bool {
+	if x != nil {
+		return x.Success
+	}
+	return false
+}
+
+type StartUploadReq struct {
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	ClientId string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	// final size of the file, in bytes
+	Size uint64 `protobuf:"varint,3,opt,name=size,proto3" json:"size,omitempty"`
+	// Split the file into this many byte ranges, each sent on its own UploadChunks stream
+	// at the same time; 0 or 1 sends it on one stream.
+	Stripes uint32 `protobuf:"varint,4,opt,name=stripes,proto3" json:"stripes,omitempty"`
+	// Identifies the version of the file being sent (the client uses its mtime); a session
+	// left behind by an earlier attempt is only resumed when size and source_version match.
+	SourceVersion int64 `protobuf:"varint,5,opt,name=source_version,json=sourceVersion,proto3" json:"source_version,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *StartUploadReq) Reset() {
+	*x = StartUploadReq{}
+	mi := &file_minidfs_proto_msgTypes[16]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *StartUploadReq) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*StartUploadReq) ProtoMessage() {}
+
+func (x *StartUploadReq) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[16]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use StartUploadReq.ProtoReflect.Descriptor instead.
+func (*StartUploadReq) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{16}
+}
+
+func (x *StartUploadReq) GetClientId() string {
+	if x != nil {
+		return x.ClientId
+	}
+	return ""
+}
+
+func (x *StartUploadReq) GetFilePath() string {
+	if x != nil {
+		return x.FilePath
+	}
+	return ""
+}
+
+func (x *StartUploadReq) GetSize() uint64 {
+	if x != nil {
+		return x.Size
+	}
+	return 0
+}
+
+func (x *StartUploadReq) GetStripes() uint32 {
+	if x != nil {
+		return x.Stripes
+	}
+	return 0
+}
+
+func (x *StartUploadReq) GetSourceVersion() int64 {
+	if x != nil {
+		return x.SourceVersion
+	}
+	return 0
+}
+
+type UploadStatusReq struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	UploadId      string                 `protobuf:"bytes,1,opt,name=upload_id,json=uploadId,proto3" json:"upload_id,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *UploadStatusReq) Reset() {
+	*x = UploadStatusReq{}
+	mi := &file_minidfs_proto_msgTypes[17]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *UploadStatusReq) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*UploadStatusReq) ProtoMessage() {}
+
+func (x *UploadStatusReq) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[17]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use UploadStatusReq.ProtoReflect.Descriptor instead.
+func (*UploadStatusReq) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{17}
+}
+
+func (x *UploadStatusReq) GetUploadId() string {
+	if x != nil {
+		return x.UploadId
+	}
+	return ""
+}
+
+type UploadStatus struct {
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	UploadId string                 `protobuf:"bytes,1,opt,name=upload_id,json=uploadId,proto3" json:"upload_id,omitempty"`
+	// bytes received so far; resume by sending from here
+	Committed uint64 `protobuf:"varint,2,opt,name=committed,proto3" json:"committed,omitempty"`
+	Size      uint64 `protobuf:"varint,3,opt,name=size,proto3" json:"size,omitempty"`
+	// the upload has been moved into place and the session is gone
+	Complete bool `protobuf:"varint,4,opt,name=complete,proto3" json:"complete,omitempty"`
+	// stripe i covers [i * stripe_size, min(size, (i + 1) * stripe_size))
+	StripeSize uint64 `protobuf:"varint,5,opt,name=stripe_size,json=stripeSize,proto3" json:"stripe_size,omitempty"`
+	// per stripe, the absolute offset to resume it from
+	StripeCommitted []uint64 `protobuf:"varint,6,rep,packed,name=stripe_committed,json=stripeCommitted,proto3" json:"stripe_committed,omitempty"`
+	// Largest chunk payload the server accepts on UploadChunks.
+	MaxChunkSize  uint32 `protobuf:"varint,7,opt,name=max_chunk_size,json=maxChunkSize,proto3" json:"max_chunk_size,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *UploadStatus) Reset() {
+	*x = UploadStatus{}
+	mi := &file_minidfs_proto_msgTypes[18]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
 
-func (x *StoreFileRes) String() string {
-	return protoimpl.X.MessageStringOf(x)
+func (x *UploadStatus) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*UploadStatus) ProtoMessage() {}
+
+func (x *UploadStatus) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[18]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use UploadStatus.ProtoReflect.Descriptor instead.
+func (*UploadStatus) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{18}
+}
+
+func (x *UploadStatus) GetUploadId() string {
+	if x != nil {
+		return x.UploadId
+	}
+	return ""
+}
+
+func (x *UploadStatus) GetCommitted() uint64 {
+	if x != nil {
+		return x.Committed
+	}
+	return 0
+}
+
+func (x *UploadStatus) GetSize() uint64 {
+	if x != nil {
+		return x.Size
+	}
+	return 0
 }
 
-func (*StoreFileRes) ProtoMessage() {}
-
-func (x *StoreFileRes) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[4]
+func (x *UploadStatus) GetComplete() bool {
 	if x != nil {
-		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
-		if ms.LoadMessageInfo() == nil {
-			ms.StoreMessageInfo(mi)
-		}
-		return ms
+		return x.Complete
 	}
-	return mi.MessageOf(x)
+	return false
 }
 
-// Deprecated: Use StoreFileRes.ProtoReflect.Descriptor instead.
-func (*StoreFileRes) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{4}
+func (x *UploadStatus) GetStripeSize() uint64 {
+	if x != nil {
+		return x.StripeSize
+	}
+	return 0
 }
 
-func (x *StoreFileRes) GetMsg() string {
+func (x *UploadStatus) GetStripeCommitted() []uint64 {
 	if x != nil {
-		return x.Msg
+		return x.StripeCommitted
 	}
-	return ""
+	return nil
 }
 
-func (x *StoreFileRes) GetSuccess() bool {
+func (x *UploadStatus) GetMaxChunkSize() uint32 {
 	if x != nil {
-		return x.Success
+		return x.MaxChunkSize
 	}
-	return false
+	return 0
 }
 
 type FetchFileReq struct {
-	state         protoimpl.MessageState `protogen:"open.v1"`
-	ClientId      string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
-	FilePath      string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	ClientId string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	// Take the read lock inside the stream instead of through GetFileLock.
+	AcquireLock bool `protobuf:"varint,3,opt,name=acquire_lock,json=acquireLock,proto3" json:"acquire_lock,omitempty"`
+	// Byte range to stream; length 0 reads to the end of the file.
+	Offset uint64 `protobuf:"varint,4,opt,name=offset,proto3" json:"offset,omitempty"`
+	Length uint64 `protobuf:"varint,5,opt,name=length,proto3" json:"length,omitempty"`
+	// Payload bytes per chunk; 0 takes the server default. The server clamps it to the smaller
+	// of its own limit and max_chunk_size.
+	ChunkSize uint32 `protobuf:"varint,6,opt,name=chunk_size,json=chunkSize,proto3" json:"chunk_size,omitempty"`
+	// Largest chunk the client can receive; 0 assumes gRPC's default message size limit.
+	MaxChunkSize uint32 `protobuf:"varint,7,opt,name=max_chunk_size,json=maxChunkSize,proto3" json:"max_chunk_size,omitempty"`
+	// Let the server resize chunks as it measures how fast they go out.
+	AdaptiveChunks bool `protobuf:"varint,8,opt,name=adaptive_chunks,json=adaptiveChunks,proto3" json:"adaptive_chunks,omitempty"`
+	// Compress chunks with this codec at this level (0 = the codec's default) if the server
+	// supports it; otherwise they come back uncompressed.
+	Codec      Codec `protobuf:"varint,9,opt,name=codec,proto3,enum=minidfs.Codec" json:"codec,omitempty"`
+	CodecLevel int32 `protobuf:"varint,10,opt,name=codec_level,json=codecLevel,proto3" json:"codec_level,omitempty"`
+	// With acquire_lock: the lock_token another stream of this fetch received (see FileBuffer).
+	LockToken     uint64 `protobuf:"varint,11,opt,name=lock_token,json=lockToken,proto3" json:"lock_token,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
 
 func (x *FetchFileReq) Reset() {
 	*x = FetchFileReq{}
-	mi := &file_minidfs_proto_msgTypes[5]
+	mi := &file_minidfs_proto_msgTypes[19]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -425,7 +1494,7 @@ func (x *FetchFileReq) String() string {
 func (*FetchFileReq) ProtoMessage() {}
 
 func (x *FetchFileReq) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[5]
+	mi := &file_minidfs_proto_msgTypes[19]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -438,7 +1507,7 @@ func (x *FetchFileReq) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use FetchFileReq.ProtoReflect.Descriptor instead.
 func (*FetchFileReq) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{5}
+	return file_minidfs_proto_rawDescGZIP(), []int{19}
 }
 
 func (x *FetchFileReq) GetClientId() string {
@@ -455,6 +1524,69 @@ func (x *FetchFileReq) GetFilePath() string {
 	return ""
 }
 
+func (x *FetchFileReq) GetAcquireLock() bool {
+	if x != nil {
+		return x.AcquireLock
+	}
+	return false
+}
+
+func (x *FetchFileReq) GetOffset() uint64 {
+	if x != nil {
+		return x.Offset
+	}
+	return 0
+}
+
+func (x *FetchFileReq) GetLength() uint64 {
+	if x != nil {
+		return x.Length
+	}
+	return 0
+}
+
+func (x *FetchFileReq) GetChunkSize() uint32 {
+	if x != nil {
+		return x.ChunkSize
+	}
+	return 0
+}
+
+func (x *FetchFileReq) GetMaxChunkSize() uint32 {
+	if x != nil {
+		return x.MaxChunkSize
+	}
+	return 0
+}
+
+func (x *FetchFileReq) GetAdaptiveChunks() bool {
+	if x != nil {
+		return x.AdaptiveChunks
+	}
+	return false
+}
+
+func (x *FetchFileReq) GetCodec() Codec {
+	if x != nil {
+		return x.Codec
+	}
+	return Codec_CODEC_NONE
+}
+
+func (x *FetchFileReq) GetCodecLevel() int32 {
+	if x != nil {
+		return x.CodecLevel
+	}
+	return 0
+}
+
+func (x *FetchFileReq) GetLockToken() uint64 {
+	if x != nil {
+		return x.LockToken
+	}
+	return 0
+}
+
 type DeleteFileReq struct {
 	state         protoimpl.MessageState `protogen:"open.v1"`
 	ClientId      string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
@@ -465,7 +1597,7 @@ type DeleteFileReq struct {
 
 func (x *DeleteFileReq) Reset() {
 	*x = DeleteFileReq{}
-	mi := &file_minidfs_proto_msgTypes[6]
+	mi := &file_minidfs_proto_msgTypes[20]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -477,7 +1609,7 @@ func (x *DeleteFileReq) String() string {
 func (*DeleteFileReq) ProtoMessage() {}
 
 func (x *DeleteFileReq) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[6]
+	mi := &file_minidfs_proto_msgTypes[20]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -490,7 +1622,7 @@ func (x *DeleteFileReq) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use DeleteFileReq.ProtoReflect.Descriptor instead.
 func (*DeleteFileReq) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{6}
+	return file_minidfs_proto_rawDescGZIP(), []int{20}
 }
 
 func (x *DeleteFileReq) GetClientId() string {
@@ -517,7 +1649,7 @@ type DeleteFileRes struct {
 
 func (x *DeleteFileRes) Reset() {
 	*x = DeleteFileRes{}
-	mi := &file_minidfs_proto_msgTypes[7]
+	mi := &file_minidfs_proto_msgTypes[21]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -529,7 +1661,7 @@ func (x *DeleteFileRes) String() string {
 func (*DeleteFileRes) ProtoMessage() {}
 
 func (x *DeleteFileRes) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[7]
+	mi := &file_minidfs_proto_msgTypes[21]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -542,7 +1674,7 @@ func (x *DeleteFileRes) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use DeleteFileRes.ProtoReflect.Descriptor instead.
 func (*DeleteFileRes) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{7}
+	return file_minidfs_proto_rawDescGZIP(), []int{21}
 }
 
 func (x *DeleteFileRes) GetMsg() string {
@@ -560,17 +1692,19 @@ func (x *DeleteFileRes) GetSuccess() bool {
 }
 
 type FileLockReq struct {
-	state         protoimpl.MessageState `protogen:"open.v1"`
-	ClientId      string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
-	FilePath      string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
-	Op            FileOpType             `protobuf:"varint,3,opt,name=op,proto3,enum=minidfs.FileOpType" json:"op,omitempty"`
+	state    protoimpl.MessageState `protogen:"open.v1"`
+	ClientId string                 `protobuf:"bytes,1,opt,name=client_id,json=clientId,proto3" json:"client_id,omitempty"`
+	FilePath string                 `protobuf:"bytes,2,opt,name=file_path,json=filePath,proto3" json:"file_path,omitempty"`
+	Op       FileOpType             `protobuf:"varint,3,opt,name=op,proto3,enum=minidfs.FileOpType" json:"op,omitempty"`
+	// READ only: the lock_token of a FetchFile stream this request belongs to (see FileBuffer).
+	LockToken     uint64 `protobuf:"varint,4,opt,name=lock_token,json=lockToken,proto3" json:"lock_token,omitempty"`
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
 
 func (x *FileLockReq) Reset() {
 	*x = FileLockReq{}
-	mi := &file_minidfs_proto_msgTypes[8]
+	mi := &file_minidfs_proto_msgTypes[22]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -582,7 +1716,7 @@ func (x *FileLockReq) String() string {
 func (*FileLockReq) ProtoMessage() {}
 
 func (x *FileLockReq) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[8]
+	mi := &file_minidfs_proto_msgTypes[22]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -595,7 +1729,7 @@ func (x *FileLockReq) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use FileLockReq.ProtoReflect.Descriptor instead.
 func (*FileLockReq) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{8}
+	return file_minidfs_proto_rawDescGZIP(), []int{22}
 }
 
 func (x *FileLockReq) GetClientId() string {
@@ -619,6 +1753,13 @@ func (x *FileLockReq) GetOp() FileOpType {
 	return FileOpType_READ
 }
 
+func (x *FileLockReq) GetLockToken() uint64 {
+	if x != nil {
+		return x.LockToken
+	}
+	return 0
+}
+
 type FileLockRes struct {
 	state         protoimpl.MessageState `protogen:"open.v1"`
 	Success       bool                   `protobuf:"varint,1,opt,name=success,proto3" json:"success,omitempty"`
@@ -628,7 +1769,7 @@ type FileLockRes struct {
 
 func (x *FileLockRes) Reset() {
 	*x = FileLockRes{}
-	mi := &file_minidfs_proto_msgTypes[9]
+	mi := &file_minidfs_proto_msgTypes[23]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -640,7 +1781,7 @@ func (x *FileLockRes) String() string {
 func (*FileLockRes) ProtoMessage() {}
 
 func (x *FileLockRes) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[9]
+	mi := &file_minidfs_proto_msgTypes[23]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -653,7 +1794,7 @@ func (x *FileLockRes) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use FileLockRes.ProtoReflect.Descriptor instead.
 func (*FileLockRes) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{9}
+	return file_minidfs_proto_rawDescGZIP(), []int{23}
 }
 
 func (x *FileLockRes) GetSuccess() bool {
@@ -675,7 +1816,7 @@ type FileUpdate struct {
 
 func (x *FileUpdate) Reset() {
 	*x = FileUpdate{}
-	mi := &file_minidfs_proto_msgTypes[10]
+	mi := &file_minidfs_proto_msgTypes[24]
 	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 	ms.StoreMessageInfo(mi)
 }
@@ -687,7 +1828,7 @@ func (x *FileUpdate) String() string {
 func (*FileUpdate) ProtoMessage() {}
 
 func (x *FileUpdate) ProtoReflect() protoreflect.Message {
-	mi := &file_minidfs_proto_msgTypes[10]
+	mi := &file_minidfs_proto_msgTypes[24]
 	if x != nil {
 		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
 		if ms.LoadMessageInfo() == nil {
@@ -700,7 +1841,7 @@ func (x *FileUpdate) ProtoReflect() protoreflect.Message {
 
 // Deprecated: Use FileUpdate.ProtoReflect.Descriptor instead.
 func (*FileUpdate) Descriptor() ([]byte, []int) {
-	return file_minidfs_proto_rawDescGZIP(), []int{10}
+	return file_minidfs_proto_rawDescGZIP(), []int{24}
 }
 
 func (x *FileUpdate) GetClientId() string {
@@ -731,43 +1872,362 @@ func (x *FileUpdate) GetVersion() uint64 {
 	return 0
 }
 
+type ServerInfoReq struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *ServerInfoReq) Reset() {
+	*x = ServerInfoReq{}
+	mi := &file_minidfs_proto_msgTypes[25]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *ServerInfoReq) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*ServerInfoReq) ProtoMessage() {}
+
+func (x *ServerInfoReq) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[25]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use ServerInfoReq.ProtoReflect.Descriptor instead.
+func (*ServerInfoReq) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{25}
+}
+
+type ServerInfo struct {
+	state protoimpl.MessageState `protogen:"open.v1"`
+	// codecs StoreFile and UploadChunks accept and FetchFile can send
+	Codecs []Codec `protobuf:"varint,1,rep,packed,name=codecs,proto3,enum=minidfs.Codec" json:"codecs,omitempty"`
+	// largest chunk payload the server accepts
+	MaxChunkSize uint32 `protobuf:"varint,2,opt,name=max_chunk_size,json=maxChunkSize,proto3" json:"max_chunk_size,omitempty"`
+	// The server keeps a chunk index (FindChunks answers). Bytes of the files it describes,
+	// bytes of the distinct chunks among them, and their ratio: what storing each chunk once
+	// would save. Uploads are deduplicated but the mount still holds every file whole.
+	ChunkStore          bool    `protobuf:"varint,3,opt,name=chunk_store,json=chunkStore,proto3" json:"chunk_store,omitempty"`
+	LogicalBytes        uint64  `protobuf:"varint,4,opt,name=logical_bytes,json=logicalBytes,proto3" json:"logical_bytes,omitempty"`
+	UniqueBytes         uint64  `protobuf:"varint,5,opt,name=unique_bytes,json=uniqueBytes,proto3" json:"unique_bytes,omitempty"`
+	PotentialDedupRatio float64 `protobuf:"fixed64,6,opt,name=potential_dedup_ratio,json=potentialDedupRatio,proto3" json:"potential_dedup_ratio,omitempty"`
+	// The server's chunk buffer pool: buffers it had to allocate, acquires served from idle
+	// buffers, payload bytes moved through them, and allocations per GB moved.
+	PoolAllocations      uint64  `protobuf:"varint,7,opt,name=pool_allocations,json=poolAllocations,proto3" json:"pool_allocations,omitempty"`
+	PoolReuses           uint64  `protobuf:"varint,8,opt,name=pool_reuses,json=poolReuses,proto3" json:"pool_reuses,omitempty"`
+	PoolBytes            uint64  `protobuf:"varint,9,opt,name=pool_bytes,json=poolBytes,proto3" json:"pool_bytes,omitempty"`
+	PoolAllocationsPerGb float64 `protobuf:"fixed64,10,opt,name=pool_allocations_per_gb,json=poolAllocationsPerGb,proto3" json:"pool_allocations_per_gb,omitempty"`
+	// Codec work over every stream the server has run: raw_bytes and wire_bytes are what it
+	// compressed for FetchFile and what that came to, compress_ns and decompress_ns the CPU
+	// time inside the codecs (decompressing uploads for the latter).
+	CodecCompressedChunks   uint64  `protobuf:"varint,11,opt,name=codec_compressed_chunks,json=codecCompressedChunks,proto3" json:"codec_compressed_chunks,omitempty"`
+	CodecSkippedChunks      uint64  `protobuf:"varint,12,opt,name=codec_skipped_chunks,json=codecSkippedChunks,proto3" json:"codec_skipped_chunks,omitempty"`
+	CodecRawBytes           uint64  `protobuf:"varint,13,opt,name=codec_raw_bytes,json=codecRawBytes,proto3" json:"codec_raw_bytes,omitempty"`
+	CodecWireBytes          uint64  `protobuf:"varint,14,opt,name=codec_wire_bytes,json=codecWireBytes,proto3" json:"codec_wire_bytes,omitempty"`
+	CodecRatio              float64 `protobuf:"fixed64,15,opt,name=codec_ratio,json=codecRatio,proto3" json:"codec_ratio,omitempty"`
+	CodecCompressNs         uint64  `protobuf:"varint,16,opt,name=codec_compress_ns,json=codecCompressNs,proto3" json:"codec_compress_ns,omitempty"`
+	CodecDecompressedChunks uint64  `protobuf:"varint,17,opt,name=codec_decompressed_chunks,json=codecDecompressedChunks,proto3" json:"codec_decompressed_chunks,omitempty"`
+	CodecDecompressNs       uint64  `protobuf:"varint,18,opt,name=codec_decompress_ns,json=codecDecompressNs,proto3" json:"codec_decompress_ns,omitempty"`
+	unknownFields           protoimpl.UnknownFields
+	sizeCache               protoimpl.SizeCache
+}
+
+func (x *ServerInfo) Reset() {
+	*x = ServerInfo{}
+	mi := &file_minidfs_proto_msgTypes[26]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *ServerInfo) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*ServerInfo) ProtoMessage() {}
+
+func (x *ServerInfo) ProtoReflect() protoreflect.Message {
+	mi := &file_minidfs_proto_msgTypes[26]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use ServerInfo.ProtoReflect.Descriptor instead.
+func (*ServerInfo) Descriptor() ([]byte, []int) {
+	return file_minidfs_proto_rawDescGZIP(), []int{26}
+}
+
+func (x *ServerInfo) GetCodecs() []Codec {
+	if x != nil {
+		return x.Codecs
+	}
+	return nil
+}
+
+func (x *ServerInfo) GetMaxChunkSize() uint32 {
+	if x != nil {
+		return x.MaxChunkSize
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetChunkStore() bool {
+	if x != nil {
+		return x.ChunkStore
+	}
+	return false
+}
+
+func (x *ServerInfo) GetLogicalBytes() uint64 {
+	if x != nil {
+		return x.LogicalBytes
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetUniqueBytes() uint64 {
+	if x != nil {
+		return x.UniqueBytes
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetPotentialDedupRatio() float64 {
+	if x != nil {
+		return x.PotentialDedupRatio
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetPoolAllocations() uint64 {
+	if x != nil {
+		return x.PoolAllocations
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetPoolReuses() uint64 {
+	if x != nil {
+		return x.PoolReuses
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetPoolBytes() uint64 {
+	if x != nil {
+		return x.PoolBytes
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetPoolAllocationsPerGb() float64 {
+	if x != nil {
+		return x.PoolAllocationsPerGb
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecCompressedChunks() uint64 {
+	if x != nil {
+		return x.CodecCompressedChunks
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecSkippedChunks() uint64 {
+	if x != nil {
+		return x.CodecSkippedChunks
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecRawBytes() uint64 {
+	if x != nil {
+		return x.CodecRawBytes
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecWireBytes() uint64 {
+	if x != nil {
+		return x.CodecWireBytes
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecRatio() float64 {
+	if x != nil {
+		return x.CodecRatio
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecCompressNs() uint64 {
+	if x != nil {
+		return x.CodecCompressNs
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecDecompressedChunks() uint64 {
+	if x != nil {
+		return x.CodecDecompressedChunks
+	}
+	return 0
+}
+
+func (x *ServerInfo) GetCodecDecompressNs() uint64 {
+	if x != nil {
+		return x.CodecDecompressNs
+	}
+	return 0
+}
+
 var File_minidfs_proto protoreflect.FileDescriptor
 
 const file_minidfs_proto_rawDesc = "" +
 	"\n" +
-	"\rminidfs.proto\x12\aminidfs\"r\n" +
+	"\rminidfs.proto\x12\aminidfs\"\x9e\x03\n" +
 	"\n" +
 	"FileBuffer\x12\x1b\n" +
 	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
 	"\tfile_path\x18\x02 \x01(\tR\bfilePath\x12\x12\n" +
 	"\x04data\x18\x03 \x01(\fR\x04data\x12\x16\n" +
-	"\x06offset\x18\x04 \x01(\x04R\x06offset\"|\n" +
+	"\x06offset\x18\x04 \x01(\x04R\x06offset\x12!\n" +
+	"\facquire_lock\x18\x05 \x01(\bR\vacquireLock\x12\x1b\n" +
+	"\tupload_id\x18\x06 \x01(\tR\buploadId\x12\x16\n" +
+	"\x06stripe\x18\a \x01(\rR\x06stripe\x12\x1b\n" +
+	"\tfile_size\x18\b \x01(\x04R\bfileSize\x12-\n" +
+	"\x06header\x18\t \x01(\v2\x15.minidfs.StreamHeaderR\x06header\x12\x1b\n" +
+	"\x06crc32c\x18\n" +
+	" \x01(\aH\x00R\x06crc32c\x88\x01\x01\x12$\n" +
+	"\x05codec\x18\v \x01(\x0e2\x0e.minidfs.CodecR\x05codec\x12\x19\n" +
+	"\braw_size\x18\f \x01(\rR\arawSize\x12\x1d\n" +
+	"\n" +
+	"lock_token\x18\r \x01(\x04R\tlockTokenB\t\n" +
+	"\a_crc32c\"\x85\x01\n" +
+	"\fStreamHeader\x12\x18\n" +
+	"\aversion\x18\x01 \x01(\rR\aversion\x12\x1b\n" +
+	"\tclient_id\x18\x02 \x01(\tR\bclientId\x12\x1b\n" +
+	"\tfile_path\x18\x03 \x01(\tR\bfilePath\x12!\n" +
+	"\facquire_lock\x18\x04 \x01(\bR\vacquireLock\"L\n" +
+	"\x10FileSignatureReq\x12\x1b\n" +
+	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
+	"\tfile_path\x18\x02 \x01(\tR\bfilePath\"w\n" +
+	"\rFileSignature\x12\x1b\n" +
+	"\tfile_size\x18\x01 \x01(\x04R\bfileSize\x12\x1d\n" +
+	"\n" +
+	"block_size\x18\x02 \x01(\rR\tblockSize\x12\x12\n" +
+	"\x04weak\x18\x03 \x03(\aR\x04weak\x12\x16\n" +
+	"\x06strong\x18\x04 \x01(\fR\x06strong\"\x86\x01\n" +
+	"\aDeltaOp\x12\x14\n" +
+	"\x05block\x18\x01 \x01(\x04R\x05block\x12\x16\n" +
+	"\x06blocks\x18\x02 \x01(\rR\x06blocks\x12\x18\n" +
+	"\aliteral\x18\x03 \x01(\fR\aliteral\x12\x14\n" +
+	"\x05chunk\x18\x04 \x01(\tR\x05chunk\x12\x1d\n" +
+	"\n" +
+	"chunk_size\x18\x05 \x01(\rR\tchunkSize\"\x83\x01\n" +
+	"\vDeltaHeader\x12\x1b\n" +
+	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
+	"\tfile_path\x18\x02 \x01(\tR\bfilePath\x12\x1d\n" +
+	"\n" +
+	"block_size\x18\x03 \x01(\rR\tblockSize\x12\x1b\n" +
+	"\tbase_size\x18\x04 \x01(\x04R\bbaseSize\"{\n" +
+	"\n" +
+	"DeltaChunk\x12,\n" +
+	"\x06header\x18\x01 \x01(\v2\x14.minidfs.DeltaHeaderR\x06header\x12\"\n" +
+	"\x03ops\x18\x02 \x03(\v2\x10.minidfs.DeltaOpR\x03ops\x12\x1b\n" +
+	"\tfile_hash\x18\x03 \x01(\tR\bfileHash\"'\n" +
+	"\rFindChunksReq\x12\x16\n" +
+	"\x06hashes\x18\x01 \x03(\tR\x06hashes\")\n" +
+	"\rFindChunksRes\x12\x18\n" +
+	"\amissing\x18\x01 \x03(\rR\amissing\"N\n" +
+	"\rChunkManifest\x12\x12\n" +
+	"\x04size\x18\x01 \x01(\x04R\x04size\x12)\n" +
+	"\x06chunks\x18\x02 \x03(\v2\x11.minidfs.ChunkRefR\x06chunks\"2\n" +
+	"\bChunkRef\x12\x12\n" +
+	"\x04hash\x18\x01 \x01(\tR\x04hash\x12\x12\n" +
+	"\x04size\x18\x02 \x01(\rR\x04size\"|\n" +
 	"\bFileInfo\x12\x1b\n" +
 	"\tfile_path\x18\x01 \x01(\tR\bfilePath\x12\x12\n" +
 	"\x04size\x18\x02 \x01(\x04R\x04size\x12\x14\n" +
-	"\x05mtime\x18\x03 \x01(\x04R\x05mtime\x12\x15\n" +
+	"\x05mtime\x18\x03 \x01(\x03R\x05mtime\x12\x15\n" +
 	"\x06is_dir\x18\x04 \x01(\bR\x05isDir\x12\x12\n" +
-	"\x04hash\x18\x05 \x01(\tR\x04hash\"\"\n" +
+	"\x04hash\x18\x05 \x01(\tR\x04hash\"?\n" +
 	"\fListFilesReq\x12\x12\n" +
-	"\x04path\x18\x01 \x01(\tR\x04path\"7\n" +
+	"\x04path\x18\x01 \x01(\tR\x04path\x12\x1b\n" +
+	"\tpage_size\x18\x02 \x01(\rR\bpageSize\"\x9f\x01\n" +
+	"\vWalkTreeReq\x12\x12\n" +
+	"\x04path\x18\x01 \x01(\tR\x04path\x12\x1b\n" +
+	"\tmax_depth\x18\x02 \x01(\rR\bmaxDepth\x12\x1b\n" +
+	"\tname_glob\x18\x03 \x01(\tR\bnameGlob\x12%\n" +
+	"\x0emodified_since\x18\x04 \x01(\x03R\rmodifiedSince\x12\x1b\n" +
+	"\tpage_size\x18\x05 \x01(\rR\bpageSize\"7\n" +
 	"\fListFilesRes\x12'\n" +
 	"\x05files\x18\x01 \x03(\v2\x11.minidfs.FileInfoR\x05files\":\n" +
 	"\fStoreFileRes\x12\x10\n" +
 	"\x03msg\x18\x01 \x01(\tR\x03msg\x12\x18\n" +
-	"\asuccess\x18\x02 \x01(\bR\asuccess\"H\n" +
+	"\asuccess\x18\x02 \x01(\bR\asuccess\"\x9f\x01\n" +
+	"\x0eStartUploadReq\x12\x1b\n" +
+	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
+	"\tfile_path\x18\x02 \x01(\tR\bfilePath\x12\x12\n" +
+	"\x04size\x18\x03 \x01(\x04R\x04size\x12\x18\n" +
+	"\astripes\x18\x04 \x01(\rR\astripes\x12%\n" +
+	"\x0esource_version\x18\x05 \x01(\x03R\rsourceVersion\".\n" +
+	"\x0fUploadStatusReq\x12\x1b\n" +
+	"\tupload_id\x18\x01 \x01(\tR\buploadId\"\xeb\x01\n" +
+	"\fUploadStatus\x12\x1b\n" +
+	"\tupload_id\x18\x01 \x01(\tR\buploadId\x12\x1c\n" +
+	"\tcommitted\x18\x02 \x01(\x04R\tcommitted\x12\x12\n" +
+	"\x04size\x18\x03 \x01(\x04R\x04size\x12\x1a\n" +
+	"\bcomplete\x18\x04 \x01(\bR\bcomplete\x12\x1f\n" +
+	"\vstripe_size\x18\x05 \x01(\x04R\n" +
+	"stripeSize\x12)\n" +
+	"\x10stripe_committed\x18\x06 \x03(\x04R\x0fstripeCommitted\x12$\n" +
+	"\x0emax_chunk_size\x18\a \x01(\rR\fmaxChunkSize\"\xef\x02\n" +
 	"\fFetchFileReq\x12\x1b\n" +
 	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
-	"\tfile_path\x18\x02 \x01(\tR\bfilePath\"I\n" +
+	"\tfile_path\x18\x02 \x01(\tR\bfilePath\x12!\n" +
+	"\facquire_lock\x18\x03 \x01(\bR\vacquireLock\x12\x16\n" +
+	"\x06offset\x18\x04 \x01(\x04R\x06offset\x12\x16\n" +
+	"\x06length\x18\x05 \x01(\x04R\x06length\x12\x1d\n" +
+	"\n" +
+	"chunk_size\x18\x06 \x01(\rR\tchunkSize\x12$\n" +
+	"\x0emax_chunk_size\x18\a \x01(\rR\fmaxChunkSize\x12'\n" +
+	"\x0fadaptive_chunks\x18\b \x01(\bR\x0eadaptiveChunks\x12$\n" +
+	"\x05codec\x18\t \x01(\x0e2\x0e.minidfs.CodecR\x05codec\x12\x1f\n" +
+	"\vcodec_level\x18\n" +
+	" \x01(\x05R\n" +
+	"codecLevel\x12\x1d\n" +
+	"\n" +
+	"lock_token\x18\v \x01(\x04R\tlockToken\"I\n" +
 	"\rDeleteFileReq\x12\x1b\n" +
 	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
 	"\tfile_path\x18\x02 \x01(\tR\bfilePath\";\n" +
 	"\rDeleteFileRes\x12\x10\n" +
 	"\x03msg\x18\x01 \x01(\tR\x03msg\x12\x18\n" +
-	"\asuccess\x18\x02 \x01(\bR\asuccess\"l\n" +
+	"\asuccess\x18\x02 \x01(\bR\asuccess\"\x8b\x01\n" +
 	"\vFileLockReq\x12\x1b\n" +
 	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12\x1b\n" +
 	"\tfile_path\x18\x02 \x01(\tR\bfilePath\x12#\n" +
-	"\x02op\x18\x03 \x01(\x0e2\x13.minidfs.FileOpTypeR\x02op\"'\n" +
+	"\x02op\x18\x03 \x01(\x0e2\x13.minidfs.FileOpTypeR\x02op\x12\x1d\n" +
+	"\n" +
+	"lock_token\x18\x04 \x01(\x04R\tlockToken\"'\n" +
 	"\vFileLockRes\x12\x18\n" +
 	"\asuccess\x18\x01 \x01(\bR\asuccess\"\xa0\x01\n" +
 	"\n" +
@@ -775,7 +2235,33 @@ const file_minidfs_proto_rawDesc = "" +
 	"\tclient_id\x18\x01 \x01(\tR\bclientId\x12+\n" +
 	"\x04type\x18\x02 \x01(\x0e2\x17.minidfs.FileUpdateTypeR\x04type\x12.\n" +
 	"\tfile_info\x18\x03 \x01(\v2\x11.minidfs.FileInfoR\bfileInfo\x12\x18\n" +
-	"\aversion\x18\x04 \x01(\x04R\aversion**\n" +
+	"\aversion\x18\x04 \x01(\x04R\aversion\"\x0f\n" +
+	"\rServerInfoReq\"\x8e\x06\n" +
+	"\n" +
+	"ServerInfo\x12&\n" +
+	"\x06codecs\x18\x01 \x03(\x0e2\x0e.minidfs.CodecR\x06codecs\x12$\n" +
+	"\x0emax_chunk_size\x18\x02 \x01(\rR\fmaxChunkSize\x12\x1f\n" +
+	"\vchunk_store\x18\x03 \x01(\bR\n" +
+	"chunkStore\x12#\n" +
+	"\rlogical_bytes\x18\x04 \x01(\x04R\flogicalBytes\x12!\n" +
+	"\funique_bytes\x18\x05 \x01(\x04R\vuniqueBytes\x122\n" +
+	"\x15potential_dedup_ratio\x18\x06 \x01(\x01R\x13potentialDedupRatio\x12)\n" +
+	"\x10pool_allocations\x18\a \x01(\x04R\x0fpoolAllocations\x12\x1f\n" +
+	"\vpool_reuses\x18\b \x01(\x04R\n" +
+	"poolReuses\x12\x1d\n" +
+	"\n" +
+	"pool_bytes\x18\t \x01(\x04R\tpoolBytes\x125\n" +
+	"\x17pool_allocations_per_gb\x18\n" +
+	" \x01(\x01R\x14poolAllocationsPerGb\x126\n" +
+	"\x17codec_compressed_chunks\x18\v \x01(\x04R\x15codecCompressedChunks\x120\n" +
+	"\x14codec_skipped_chunks\x18\f \x01(\x04R\x12codecSkippedChunks\x12&\n" +
+	"\x0fcodec_raw_bytes\x18\r \x01(\x04R\rcodecRawBytes\x12(\n" +
+	"\x10codec_wire_bytes\x18\x0e \x01(\x04R\x0ecodecWireBytes\x12\x1f\n" +
+	"\vcodec_ratio\x18\x0f \x01(\x01R\n" +
+	"codecRatio\x12*\n" +
+	"\x11codec_compress_ns\x18\x10 \x01(\x04R\x0fcodecCompressNs\x12:\n" +
+	"\x19codec_decompressed_chunks\x18\x11 \x01(\x04R\x17codecDecompressedChunks\x12.\n" +
+	"\x13codec_decompress_ns\x18\x12 \x01(\x04R\x11codecDecompressNs**\n" +
 	"\n" +
 	"FileOpType\x12\b\n" +
 	"\x04READ\x10\x00\x12\t\n" +
@@ -784,15 +2270,32 @@ const file_minidfs_proto_rawDesc = "" +
 	"\x0eFileUpdateType\x12\v\n" +
 	"\aCREATED\x10\x00\x12\f\n" +
 	"\bMODIFIED\x10\x01\x12\v\n" +
-	"\aDELETED\x10\x022\xfc\x02\n" +
+	"\aDELETED\x10\x02*I\n" +
+	"\x05Codec\x12\x0e\n" +
+	"\n" +
+	"CODEC_NONE\x10\x00\x12\r\n" +
+	"\tCODEC_LZ4\x10\x01\x12\x0e\n" +
+	"\n" +
+	"CODEC_ZSTD\x10\x02\x12\x11\n" +
+	"\rCODEC_DEFLATE\x10\x032\xbe\a\n" +
 	"\x0eMiniDFSService\x129\n" +
-	"\tListFiles\x12\x15.minidfs.ListFilesReq\x1a\x15.minidfs.ListFilesRes\x129\n" +
-	"\tStoreFile\x12\x13.minidfs.FileBuffer\x1a\x15.minidfs.StoreFileRes(\x01\x129\n" +
+	"\tListFiles\x12\x15.minidfs.ListFilesReq\x1a\x15.minidfs.ListFilesRes\x12A\n" +
+	"\x0fListFilesStream\x12\x15.minidfs.ListFilesReq\x1a\x15.minidfs.ListFilesRes0\x01\x129\n" +
+	"\bWalkTree\x12\x14.minidfs.WalkTreeReq\x1a\x15.minidfs.ListFilesRes0\x01\x129\n" +
+	"\tStoreFile\x12\x13.minidfs.FileBuffer\x1a\x15.minidfs.StoreFileRes(\x01\x12E\n" +
+	"\x10GetFileSignature\x12\x19.minidfs.FileSignatureReq\x1a\x16.minidfs.FileSignature\x12<\n" +
+	"\n" +
+	"FindChunks\x12\x16.minidfs.FindChunksReq\x1a\x16.minidfs.FindChunksRes\x12>\n" +
+	"\x0eStoreFileDelta\x12\x13.minidfs.DeltaChunk\x1a\x15.minidfs.StoreFileRes(\x01\x12=\n" +
+	"\vStartUpload\x12\x17.minidfs.StartUploadReq\x1a\x15.minidfs.UploadStatus\x12B\n" +
+	"\x0fGetUploadStatus\x12\x18.minidfs.UploadStatusReq\x1a\x15.minidfs.UploadStatus\x12<\n" +
+	"\fUploadChunks\x12\x13.minidfs.FileBuffer\x1a\x15.minidfs.UploadStatus(\x01\x129\n" +
 	"\tFetchFile\x12\x15.minidfs.FetchFileReq\x1a\x13.minidfs.FileBuffer0\x01\x129\n" +
 	"\vGetFileLock\x12\x14.minidfs.FileLockReq\x1a\x14.minidfs.FileLockRes\x12<\n" +
 	"\n" +
 	"RemoveFile\x12\x16.minidfs.DeleteFileReq\x1a\x16.minidfs.DeleteFileRes\x12@\n" +
-	"\x12FileUpdateCallback\x12\x13.minidfs.FileUpdate\x1a\x13.minidfs.FileUpdate0\x01B\vZ\t.;minidfsb\x06proto3"
+	"\x12FileUpdateCallback\x12\x13.minidfs.FileUpdate\x1a\x13.minidfs.FileUpdate0\x01\x12<\n" +
+	"\rGetServerInfo\x12\x16.minidfs.ServerInfoReq\x1a\x13.minidfs.ServerInfoB\vZ\t.;minidfsb\x06proto3"
 
 var (
 	file_minidfs_proto_rawDescOnce sync.Once
@@ -806,45 +2309,87 @@ func file_minidfs_proto_rawDescGZIP() []byte {
 	return file_minidfs_proto_rawDescData
 }
 
-var file_minidfs_proto_enumTypes = make([]protoimpl.EnumInfo, 2)
-var file_minidfs_proto_msgTypes = make([]protoimpl.MessageInfo, 11)
+var file_minidfs_proto_enumTypes = make([]protoimpl.EnumInfo, 3)
+var file_minidfs_proto_msgTypes = make([]protoimpl.MessageInfo, 27)
 var file_minidfs_proto_goTypes = []any{
-	(FileOpType)(0),       // 0: minidfs.FileOpType
-	(FileUpdateType)(0),   // 1: minidfs.FileUpdateType
-	(*FileBuffer)(nil),    // 2: minidfs.FileBuffer
-	(*FileInfo)(nil),      // 3: minidfs.FileInfo
-	(*ListFilesReq)(nil),  // 4: minidfs.ListFilesReq
-	(*ListFilesRes)(nil),  // 5: minidfs.ListFilesRes
-	(*StoreFileRes)(nil),  // 6: minidfs.StoreFileRes
-	(*FetchFileReq)(nil),  // 7: minidfs.FetchFileReq
-	(*DeleteFileReq)(nil), // 8: minidfs.DeleteFileReq
-	(*DeleteFileRes)(nil), // 9: minidfs.DeleteFileRes
-	(*FileLockReq)(nil),   // 10: minidfs.FileLockReq
-	(*FileLockRes)(nil),   // 11: minidfs.FileLockRes
-	(*FileUpdate)(nil),    // 12: minidfs.FileUpdate
+	(FileOpType)(0),          // 0: minidfs.FileOpType
+	(FileUpdateType)(0),      // 1: minidfs.FileUpdateType
+	(Codec)(0),               // 2: minidfs.Codec
+	(*FileBuffer)(nil),       // 3: minidfs.FileBuffer
+	(*StreamHeader)(nil),     // 4: minidfs.StreamHeader
+	(*FileSignatureReq)(nil), // 5: minidfs.FileSignatureReq
+	(*FileSignature)(nil),    // 6: minidfs.FileSignature
+	(*DeltaOp)(nil),          // 7: minidfs.DeltaOp
+	(*DeltaHeader)(nil),      // 8: minidfs.DeltaHeader
+	(*DeltaChunk)(nil),       // 9: minidfs.DeltaChunk
+	(*FindChunksReq)(nil),    // 10: minidfs.FindChunksReq
+	(*FindChunksRes)(nil),    // 11: minidfs.FindChunksRes
+	(*ChunkManifest)(nil),    // 12: minidfs.ChunkManifest
+	(*ChunkRef)(nil),         // 13: minidfs.ChunkRef
+	(*FileInfo)(nil),         // 14: minidfs.FileInfo
+	(*ListFilesReq)(nil),     // 15: minidfs.ListFilesReq
+	(*WalkTreeReq)(nil),      // 16: minidfs.WalkTreeReq
+	(*ListFilesRes)(nil),     // 17: minidfs.ListFilesRes
+	(*StoreFileRes)(nil),     // 18: minidfs.StoreFileRes
+	(*StartUploadReq)(nil),   // 19: minidfs.StartUploadReq
+	(*UploadStatusReq)(nil),  // 20: minidfs.UploadStatusReq
+	(*UploadStatus)(nil),     // 21: minidfs.UploadStatus
+	(*FetchFileReq)(nil),     // 22: minidfs.FetchFileReq
+	(*DeleteFileReq)(nil),    // 23: minidfs.DeleteFileReq
+	(*DeleteFileRes)(nil),    // 24: minidfs.DeleteFileRes
+	(*FileLockReq)(nil),      // 25: minidfs.FileLockReq
+	(*FileLockRes)(nil),      // 26: minidfs.FileLockRes
+	(*FileUpdate)(nil),       // 27: minidfs.FileUpdate
+	(*ServerInfoReq)(nil),    // 28: minidfs.ServerInfoReq
+	(*ServerInfo)(nil),       // 29: minidfs.ServerInfo
 }
 var file_minidfs_proto_depIdxs = []int32{
-	3,  // 0: minidfs.ListFilesRes.files:type_name -> minidfs.FileInfo
-	0,  // 1: minidfs.FileLockReq.op:type_name -> minidfs.FileOpType
-	1,  // 2: minidfs.FileUpdate.type:type_name -> minidfs.FileUpdateType
-	3,  // 3: minidfs.FileUpdate.file_info:type_name -> minidfs.FileInfo
-	4,  // 4: minidfs.MiniDFSService.ListFiles:input_type -> minidfs.ListFilesReq
-	2,  // 5: minidfs.MiniDFSService.StoreFile:input_type -> minidfs.FileBuffer
-	7,  // 6: minidfs.MiniDFSService.FetchFile:input_type -> minidfs.FetchFileReq
-	10, // 7: minidfs.MiniDFSService.GetFileLock:input_type -> minidfs.FileLockReq
-	8,  // 8: minidfs.MiniDFSService.RemoveFile:input_type -> minidfs.DeleteFileReq
-	12, // 9: minidfs.MiniDFSService.FileUpdateCallback:input_type -> minidfs.FileUpdate
-	5,  // 10: minidfs.MiniDFSService.ListFiles:output_type -> minidfs.ListFilesRes
-	6,  // 11: minidfs.MiniDFSService.StoreFile:output_type -> minidfs.StoreFileRes
-	2,  // 12: minidfs.MiniDFSService.FetchFile:output_type -> minidfs.FileBuffer
-	11, // 13: minidfs.MiniDFSService.GetFileLock:output_type -> minidfs.FileLockRes
-	9,  // 14: minidfs.MiniDFSService.RemoveFile:output_type -> minidfs.DeleteFileRes
-	12, // 15: minidfs.MiniDFSService.FileUpdateCallback:output_type -> minidfs.FileUpdate
-	10, // [10:16] is the sub-list for method output_type
-	4,  // [4:10] is the sub-list for method input_type
-	4,  // [4:4] is the sub-list for extension type_name
-	4,  // [4:4] is the sub-list for extension extendee
-	0,  // [0:4] is the sub-list for field type_name
+	4,  // 0: minidfs.FileBuffer.header:type_name -> minidfs.StreamHeader
+	2,  // 1: minidfs.FileBuffer.codec:type_name -> minidfs.Codec
+	8,  // 2: minidfs.DeltaChunk.header:type_name -> minidfs.DeltaHeader
+	7,  // 3: minidfs.DeltaChunk.ops:type_name -> minidfs.DeltaOp
+	13, // 4: minidfs.ChunkManifest.chunks:type_name -> minidfs.ChunkRef
+	14, // 5: minidfs.ListFilesRes.files:type_name -> minidfs.FileInfo
+	2,  // 6: minidfs.FetchFileReq.codec:type_name -> minidfs.Codec
+	0,  // 7: minidfs.FileLockReq.op:type_name -> minidfs.FileOpType
+	1,  // 8: minidfs.FileUpdate.type:type_name -> minidfs.FileUpdateType
+	14, // 9: minidfs.FileUpdate.file_info:type_name -> minidfs.FileInfo
+	2,  // 10: minidfs.ServerInfo.codecs:type_name -> minidfs.Codec
+	15, // 11: minidfs.MiniDFSService.ListFiles:input_type -> minidfs.ListFilesReq
+	15, // 12: minidfs.MiniDFSService.ListFilesStream:input_type -> minidfs.ListFilesReq
+	16, // 13: minidfs.MiniDFSService.WalkTree:input_type -> minidfs.WalkTreeReq
+	3,  // 14: minidfs.MiniDFSService.StoreFile:input_type -> minidfs.FileBuffer
+	5,  // 15: minidfs.MiniDFSService.GetFileSignature:input_type -> minidfs.FileSignatureReq
+	10, // 16: minidfs.MiniDFSService.FindChunks:input_type -> minidfs.FindChunksReq
+	9,  // 17: minidfs.MiniDFSService.StoreFileDelta:input_type -> minidfs.DeltaChunk
+	19, // 18: minidfs.MiniDFSService.StartUpload:input_type -> minidfs.StartUploadReq
+	20, // 19: minidfs.MiniDFSService.GetUploadStatus:input_type -> minidfs.UploadStatusReq
+	3,  // 20: minidfs.MiniDFSService.UploadChunks:input_type -> minidfs.FileBuffer
+	22, // 21: minidfs.MiniDFSService.FetchFile:input_type -> minidfs.FetchFileReq
+	25, // 22: minidfs.MiniDFSService.GetFileLock:input_type -> minidfs.FileLockReq
+	23, // 23: minidfs.MiniDFSService.RemoveFile:input_type -> minidfs.DeleteFileReq
+	27, // 24: minidfs.MiniDFSService.FileUpdateCallback:input_type -> minidfs.FileUpdate
+	28, // 25: minidfs.MiniDFSService.GetServerInfo:input_type -> minidfs.ServerInfoReq
+	17, // 26: minidfs.MiniDFSService.ListFiles:output_type -> minidfs.ListFilesRes
+	17, // 27: minidfs.MiniDFSService.ListFilesStream:output_type -> minidfs.ListFilesRes
+	17, // 28: minidfs.MiniDFSService.WalkTree:output_type -> minidfs.ListFilesRes
+	18, // 29: minidfs.MiniDFSService.StoreFile:output_type -> minidfs.StoreFileRes
+	6,  // 30: minidfs.MiniDFSService.GetFileSignature:output_type -> minidfs.FileSignature
+	11, // 31: minidfs.MiniDFSService.FindChunks:output_type -> minidfs.FindChunksRes
+	18, // 32: minidfs.MiniDFSService.StoreFileDelta:output_type -> minidfs.StoreFileRes
+	21, // 33: minidfs.MiniDFSService.StartUpload:output_type -> minidfs.UploadStatus
+	21, // 34: minidfs.MiniDFSService.GetUploadStatus:output_type -> minidfs.UploadStatus
+	21, // 35: minidfs.MiniDFSService.UploadChunks:output_type -> minidfs.UploadStatus
+	3,  // 36: minidfs.MiniDFSService.FetchFile:output_type -> minidfs.FileBuffer
+	26, // 37: minidfs.MiniDFSService.GetFileLock:output_type -> minidfs.FileLockRes
+	24, // 38: minidfs.MiniDFSService.RemoveFile:output_type -> minidfs.DeleteFileRes
+	27, // 39: minidfs.MiniDFSService.FileUpdateCallback:output_type -> minidfs.FileUpdate
+	29, // 40: minidfs.MiniDFSService.GetServerInfo:output_type -> minidfs.ServerInfo
+	26, // [26:41] is the sub-list for method output_type
+	11, // [11:26] is the sub-list for method input_type
+	11, // [11:11] is the sub-list for extension type_name
+	11, // [11:11] is the sub-list for extension extendee
+	0,  // [0:11] is the sub-list for field type_name
 }
 
 func init() { file_minidfs_proto_init() }
@@ -852,13 +2397,14 @@ func file_minidfs_proto_init() {
 	if File_minidfs_proto != nil {
 		return
 	}
+	file_minidfs_proto_msgTypes[0].OneofWrappers = []any{}
 	type x struct{}
 	out := protoimpl.TypeBuilder{
 		File: protoimpl.DescBuilder{
 			GoPackagePath: reflect.TypeOf(x{}).PkgPath(),
 			RawDescriptor: unsafe.Slice(unsafe.StringData(file_minidfs_proto_rawDesc), len(file_minidfs_proto_rawDesc)),
-			NumEnums:      2,
-			NumMessages:   11,
+			NumEnums:      3,
+			NumMessages:   27,
 			NumExtensions: 0,
 			NumServices:   1,
 		},
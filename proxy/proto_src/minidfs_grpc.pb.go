@@ -20,11 +20,20 @@ const _ = grpc.SupportPackageIsVersion9
 
 const (
 	MiniDFSService_ListFiles_FullMethodName          = "/minidfs.MiniDFSService/ListFiles"
+	MiniDFSService_ListFilesStream_FullMethodName    = "/minidfs.MiniDFSService/ListFilesStream"
+	MiniDFSService_WalkTree_FullMethodName           = "/minidfs.MiniDFSService/WalkTree"
 	MiniDFSService_StoreFile_FullMethodName          = "/minidfs.MiniDFSService/StoreFile"
+	MiniDFSService_GetFileSignature_FullMethodName   = "/minidfs.MiniDFSService/GetFileSignature"
+	MiniDFSService_FindChunks_FullMethodName         = "/minidfs.MiniDFSService/FindChunks"
+	MiniDFSService_StoreFileDelta_FullMethodName     = "/minidfs.MiniDFSService/StoreFileDelta"
+	MiniDFSService_StartUpload_FullMethodName        = "/minidfs.MiniDFSService/StartUpload"
+	MiniDFSService_GetUploadStatus_FullMethodName    = "/minidfs.MiniDFSService/GetUploadStatus"
+	MiniDFSService_UploadChunks_FullMethodName       = "/minidfs.MiniDFSService/UploadChunks"
 	MiniDFSService_FetchFile_FullMethodName          = "/minidfs.MiniDFSService/FetchFile"
 	MiniDFSService_GetFileLock_FullMethodName        = "/minidfs.MiniDFSService/GetFileLock"
 	MiniDFSService_RemoveFile_FullMethodName         = "/minidfs.MiniDFSService/RemoveFile"
 	MiniDFSService_FileUpdateCallback_FullMethodName = "/minidfs.MiniDFSService/FileUpdateCallback"
+	MiniDFSService_GetServerInfo_FullMethodName      = "/minidfs.MiniDFSService/GetServerInfo"
 )
 
 // MiniDFSServiceClient is the client API for MiniDFSService service.
@@ -35,8 +44,25 @@ const (
 type MiniDFSServiceClient interface {
 	// List files in a directory
 	ListFiles(ctx context.Context, in *ListFilesReq, opts ...grpc.CallOption) (*ListFilesRes, error)
+	// List files in a directory as a stream of pages, read as they are sent
+	ListFilesStream(ctx context.Context, in *ListFilesReq, opts ...grpc.CallOption) (grpc.ServerStreamingClient[ListFilesRes], error)
+	// Walk a directory tree on the server, streaming matching entries from every level
+	WalkTree(ctx context.Context, in *WalkTreeReq, opts ...grpc.CallOption) (grpc.ServerStreamingClient[ListFilesRes], error)
 	// Store files on the server
 	StoreFile(ctx context.Context, opts ...grpc.CallOption) (grpc.ClientStreamingClient[FileBuffer, StoreFileRes], error)
+	// Block signatures of the server's copy of a file, for computing a delta against it
+	GetFileSignature(ctx context.Context, in *FileSignatureReq, opts ...grpc.CallOption) (*FileSignature, error)
+	// Which of these chunks the server's chunk store lacks
+	FindChunks(ctx context.Context, in *FindChunksReq, opts ...grpc.CallOption) (*FindChunksRes, error)
+	// Store a file as a delta against the server's copy: literal bytes plus references to
+	// its blocks. The file is rebuilt in a staging file and moved into place atomically.
+	StoreFileDelta(ctx context.Context, opts ...grpc.CallOption) (grpc.ClientStreamingClient[DeltaChunk, StoreFileRes], error)
+	// Open (or look up) a resumable upload session for a file
+	StartUpload(ctx context.Context, in *StartUploadReq, opts ...grpc.CallOption) (*UploadStatus, error)
+	// How much of a resumable upload the server has durably received
+	GetUploadStatus(ctx context.Context, in *UploadStatusReq, opts ...grpc.CallOption) (*UploadStatus, error)
+	// Append chunks to a resumable upload; the file is committed once the last byte arrives
+	UploadChunks(ctx context.Context, opts ...grpc.CallOption) (grpc.ClientStreamingClient[FileBuffer, UploadStatus], error)
 	// Fetch files from the server
 	FetchFile(ctx context.Context, in *FetchFileReq, opts ...grpc.CallOption) (grpc.ServerStreamingClient[FileBuffer], error)
 	// Get a file lock
@@ -45,6 +71,8 @@ type MiniDFSServiceClient interface {
 	RemoveFile(ctx context.Context, in *DeleteFileReq, opts ...grpc.CallOption) (*DeleteFileRes, error)
 	// Callback for file updates
 	FileUpdateCallback(ctx context.Context, in *FileUpdate, opts ...grpc.CallOption) (grpc.ServerStreamingClient[FileUpdate], error)
+	// What this server supports, for clients to negotiate transfers against
+	GetServerInfo(ctx context.Context, in *ServerInfoReq, opts ...grpc.CallOption) (*ServerInfo, error)
 }
 
 type miniDFSServiceClient struct {
@@ -65,9 +93,47 @@ func (c *miniDFSServiceClient) ListFiles(ctx context.Context, in *ListFilesReq,
 	return out, nil
 }
 
+func (c *miniDFSServiceClient) ListFilesStream(ctx context.Context, in *ListFilesReq, opts ...grpc.CallOption) (grpc.ServerStreamingClient[ListFilesRes], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[0], MiniDFSService_ListFilesStream_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[ListFilesReq, ListFilesRes]{ClientStream: stream}
+	if err := x.ClientStream.SendMsg(in); err != nil {
+		return nil, err
+	}
+	if err := x.ClientStream.CloseSend(); err != nil {
+		return nil, err
+	}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_ListFilesStreamClient = grpc.ServerStreamingClient[ListFilesRes]
+
+func (c *miniDFSServiceClient) WalkTree(ctx context.Context, in *WalkTreeReq, opts ...grpc.CallOption) (grpc.ServerStreamingClient[ListFilesRes], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[1], MiniDFSService_WalkTree_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[WalkTreeReq, ListFilesRes]{ClientStream: stream}
+	if err := x.ClientStream.SendMsg(in); err != nil {
+		return nil, err
+	}
+	if err := x.ClientStream.CloseSend(); err != nil {
+		return nil, err
+	}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_WalkTreeClient = grpc.ServerStreamingClient[ListFilesRes]
+
 func (c *miniDFSServiceClient) StoreFile(ctx context.Context, opts ...grpc.CallOption) (grpc.ClientStreamingClient[FileBuffer, StoreFileRes], error) {
 	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
-	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[0], MiniDFSService_StoreFile_FullMethodName, cOpts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[2], MiniDFSService_StoreFile_FullMethodName, cOpts...)
 	if err != nil {
 		return nil, err
 	}
@@ -78,9 +144,75 @@ func (c *miniDFSServiceClient) StoreFile(ctx context.Context, opts ...grpc.CallO
 // This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
 type MiniDFSService_StoreFileClient = grpc.ClientStreamingClient[FileBuffer, StoreFileRes]
 
+func (c *miniDFSServiceClient) GetFileSignature(ctx context.Context, in *FileSignatureReq, opts ...grpc.CallOption) (*FileSignature, error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	out := new(FileSignature)
+	err := c.cc.Invoke(ctx, MiniDFSService_GetFileSignature_FullMethodName, in, out, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
+func (c *miniDFSServiceClient) FindChunks(ctx context.Context, in *FindChunksReq, opts ...grpc.CallOption) (*FindChunksRes, error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	out := new(FindChunksRes)
+	err := c.cc.Invoke(ctx, MiniDFSService_FindChunks_FullMethodName, in, out, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
+func (c *miniDFSServiceClient) StoreFileDelta(ctx context.Context, opts ...grpc.CallOption) (grpc.ClientStreamingClient[DeltaChunk, StoreFileRes], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[3], MiniDFSService_StoreFileDelta_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[DeltaChunk, StoreFileRes]{ClientStream: stream}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_StoreFileDeltaClient = grpc.ClientStreamingClient[DeltaChunk, StoreFileRes]
+
+func (c *miniDFSServiceClient) StartUpload(ctx context.Context, in *StartUploadReq, opts ...grpc.CallOption) (*UploadStatus, error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	out := new(UploadStatus)
+	err := c.cc.Invoke(ctx, MiniDFSService_StartUpload_FullMethodName, in, out, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
+func (c *miniDFSServiceClient) GetUploadStatus(ctx context.Context, in *UploadStatusReq, opts ...grpc.CallOption) (*UploadStatus, error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	out := new(UploadStatus)
+	err := c.cc.Invoke(ctx, MiniDFSService_GetUploadStatus_FullMethodName, in, out, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
+func (c *miniDFSServiceClient) UploadChunks(ctx context.Context, opts ...grpc.CallOption) (grpc.ClientStreamingClient[FileBuffer, UploadStatus], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[4], MiniDFSService_UploadChunks_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[FileBuffer, UploadStatus]{ClientStream: stream}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_UploadChunksClient = grpc.ClientStreamingClient[FileBuffer, UploadStatus]
+
 func (c *miniDFSServiceClient) FetchFile(ctx context.Context, in *FetchFileReq, opts ...grpc.CallOption) (grpc.ServerStreamingClient[FileBuffer], error) {
 	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
-	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[1], MiniDFSService_FetchFile_FullMethodName, cOpts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[5], MiniDFSService_FetchFile_FullMethodName, cOpts...)
 	if err != nil {
 		return nil, err
 	}
@@ -119,7 +251,7 @@ func (c *miniDFSServiceClient) RemoveFile(ctx context.Context, in *DeleteFileReq
 
 func (c *miniDFSServiceClient) FileUpdateCallback(ctx context.Context, in *FileUpdate, opts ...grpc.CallOption) (grpc.ServerStreamingClient[FileUpdate], error) {
 	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
-	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[2], MiniDFSService_FileUpdateCallback_FullMethodName, cOpts...)
+	stream, err := c.cc.NewStream(ctx, &MiniDFSService_ServiceDesc.Streams[6], MiniDFSService_FileUpdateCallback_FullMethodName, cOpts...)
 	if err != nil {
 		return nil, err
 	}
@@ -136,6 +268,16 @@ func (c *miniDFSServiceClient) FileUpdateCallback(ctx context.Context, in *FileU
 // This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
 type MiniDFSService_FileUpdateCallbackClient = grpc.ServerStreamingClient[FileUpdate]
 
+func (c *miniDFSServiceClient) GetServerInfo(ctx context.Context, in *ServerInfoReq, opts ...grpc.CallOption) (*ServerInfo, error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	out := new(ServerInfo)
+	err := c.cc.Invoke(ctx, MiniDFSService_GetServerInfo_FullMethodName, in, out, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
 // MiniDFSServiceServer is the server API for MiniDFSService service.
 // All implementations must embed UnimplementedMiniDFSServiceServer
 // for forward compatibility.
@@ -144,8 +286,25 @@ type MiniDFSService_FileUpdateCallbackClient = grpc.ServerStreamingClient[FileUp
 type MiniDFSServiceServer interface {
 	// List files in a directory
 	ListFiles(context.Context, *ListFilesReq) (*ListFilesRes, error)
+	// List files in a directory as a stream of pages, read as they are sent
+	ListFilesStream(*ListFilesReq, grpc.ServerStreamingServer[ListFilesRes]) error
+	// Walk a directory tree on the server, streaming matching entries from every level
+	WalkTree(*WalkTreeReq, grpc.ServerStreamingServer[ListFilesRes]) error
 	// Store files on the server
 	StoreFile(grpc.ClientStreamingServer[FileBuffer, StoreFileRes]) error
+	// Block signatures of the server's copy of a file, for computing a delta against it
+	GetFileSignature(context.Context, *FileSignatureReq) (*FileSignature, error)
+	// Which of these chunks the server's chunk store lacks
+	FindChunks(context.Context, *FindChunksReq) (*FindChunksRes, error)
+	// Store a file as a delta against the server's copy: literal bytes plus references to
+	// its blocks. The file is rebuilt in a staging file and moved into place atomically.
+	StoreFileDelta(grpc.ClientStreamingServer[DeltaChunk, StoreFileRes]) error
+	// Open (or look up) a resumable upload session for a file
+	StartUpload(context.Context, *StartUploadReq) (*UploadStatus, error)
+	// How much of a resumable upload the server has durably received
+	GetUploadStatus(context.Context, *UploadStatusReq) (*UploadStatus, error)
+	// Append chunks to a resumable upload; the file is committed once the last byte arrives
+	UploadChunks(grpc.ClientStreamingServer[FileBuffer, UploadStatus]) error
 	// Fetch files from the server
 	FetchFile(*FetchFileReq, grpc.ServerStreamingServer[FileBuffer]) error
 	// Get a file lock
@@ -154,6 +313,8 @@ type MiniDFSServiceServer interface {
 	RemoveFile(context.Context, *DeleteFileReq) (*DeleteFileRes, error)
 	// Callback for file updates
 	FileUpdateCallback(*FileUpdate, grpc.ServerStreamingServer[FileUpdate]) error
+	// What this server supports, for clients to negotiate transfers against
+	GetServerInfo(context.Context, *ServerInfoReq) (*ServerInfo, error)
 	mustEmbedUnimplementedMiniDFSServiceServer()
 }
 
@@ -167,9 +328,33 @@ type UnimplementedMiniDFSServiceServer struct{}
 func (UnimplementedMiniDFSServiceServer) ListFiles(context.Context, *ListFilesReq) (*ListFilesRes, error) {
 	return nil, status.Error(codes.Unimplemented, "method ListFiles not implemented")
 }
+func (UnimplementedMiniDFSServiceServer) ListFilesStream(*ListFilesReq, grpc.ServerStreamingServer[ListFilesRes]) error {
+	return status.Error(codes.Unimplemented, "method ListFilesStream not implemented")
+}
+func (UnimplementedMiniDFSServiceServer) WalkTree(*WalkTreeReq, grpc.ServerStreamingServer[ListFilesRes]) error {
+	return status.Error(codes.Unimplemented, "method WalkTree not implemented")
+}
 func (UnimplementedMiniDFSServiceServer) StoreFile(grpc.ClientStreamingServer[FileBuffer, StoreFileRes]) error {
 	return status.Error(codes.Unimplemented, "method StoreFile not implemented")
 }
+func (UnimplementedMiniDFSServiceServer) GetFileSignature(context.Context, *FileSignatureReq) (*FileSignature, error) {
+	return nil, status.Error(codes.Unimplemented, "method GetFileSignature not implemented")
+}
+func (UnimplementedMiniDFSServiceServer) FindChunks(context.Context, *FindChunksReq) (*FindChunksRes, error) {
+	return nil, status.Error(codes.Unimplemented, "method FindChunks not implemented")
+}
+func (UnimplementedMiniDFSServiceServer) StoreFileDelta(grpc.ClientStreamingServer[DeltaChunk, StoreFileRes]) error {
+	return status.Error(codes.Unimplemented, "method StoreFileDelta not implemented")
+}
+func (UnimplementedMiniDFSServiceServer) StartUpload(context.Context, *StartUploadReq) (*UploadStatus, error) {
+	return nil, status.Error(codes.Unimplemented, "method StartUpload not implemented")
+}
+func (UnimplementedMiniDFSServiceServer) GetUploadStatus(context.Context, *UploadStatusReq) (*UploadStatus, error) {
+	return nil, status.Error(codes.Unimplemented, "method GetUploadStatus not implemented")
+}
+func (UnimplementedMiniDFSServiceServer) UploadChunks(grpc.ClientStreamingServer[FileBuffer, UploadStatus]) error {
+	return status.Error(codes.Unimplemented, "method UploadChunks not implemented")
+}
 func (UnimplementedMiniDFSServiceServer) FetchFile(*FetchFileReq, grpc.ServerStreamingServer[FileBuffer]) error {
 	return status.Error(codes.Unimplemented, "method FetchFile not implemented")
 }
@@ -182,6 +367,9 @@ func (UnimplementedMiniDFSServiceServer) RemoveFile(context.Context, *DeleteFile
 func (UnimplementedMiniDFSServiceServer) FileUpdateCallback(*FileUpdate, grpc.ServerStreamingServer[FileUpdate]) error {
 	return status.Error(codes.Unimplemented, "method FileUpdateCallback not implemented")
 }
+func (UnimplementedMiniDFSServiceServer) GetServerInfo(context.Context, *ServerInfoReq) (*ServerInfo, error) {
+	return nil, status.Error(codes.Unimplemented, "method GetServerInfo not implemented")
+}
 func (UnimplementedMiniDFSServiceServer) mustEmbedUnimplementedMiniDFSServiceServer() {}
 func (UnimplementedMiniDFSServiceServer) testEmbeddedByValue()                        {}
 
@@ -221,6 +409,28 @@ func _MiniDFSService_ListFiles_Handler(srv interface{}, ctx context.Context, dec
 	return interceptor(ctx, in, info, handler)
 }
 
+func _MiniDFSService_ListFilesStream_Handler(srv interface{}, stream grpc.ServerStream) error {
+	m := new(ListFilesReq)
+	if err := stream.RecvMsg(m); err != nil {
+		return err
+	}
+	return srv.(MiniDFSServiceServer).ListFilesStream(m, &grpc.GenericServerStream[ListFilesReq, ListFilesRes]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_ListFilesStreamServer = grpc.ServerStreamingServer[ListFilesRes]
+
+func _MiniDFSService_WalkTree_Handler(srv interface{}, stream grpc.ServerStream) error {
+	m := new(WalkTreeReq)
+	if err := stream.RecvMsg(m); err != nil {
+		return err
+	}
+	return srv.(MiniDFSServiceServer).WalkTree(m, &grpc.GenericServerStream[WalkTreeReq, ListFilesRes]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_WalkTreeServer = grpc.ServerStreamingServer[ListFilesRes]
+
 func _MiniDFSService_StoreFile_Handler(srv interface{}, stream grpc.ServerStream) error {
 	return srv.(MiniDFSServiceServer).StoreFile(&grpc.GenericServerStream[FileBuffer, StoreFileRes]{ServerStream: stream})
 }
@@ -228,6 +438,92 @@ func _MiniDFSService_StoreFile_Handler(srv interface{}, stream grpc.ServerStream
 // This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
 type MiniDFSService_StoreFileServer = grpc.ClientStreamingServer[FileBuffer, StoreFileRes]
 
+func _MiniDFSService_GetFileSignature_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(FileSignatureReq)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(MiniDFSServiceServer).GetFileSignature(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: MiniDFSService_GetFileSignature_FullMethodName,
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(MiniDFSServiceServer).GetFileSignature(ctx, req.(*FileSignatureReq))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
+func _MiniDFSService_FindChunks_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(FindChunksReq)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(MiniDFSServiceServer).FindChunks(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: MiniDFSService_FindChunks_FullMethodName,
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(MiniDFSServiceServer).FindChunks(ctx, req.(*FindChunksReq))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
+func _MiniDFSService_StoreFileDelta_Handler(srv interface{}, stream grpc.ServerStream) error {
+	return srv.(MiniDFSServiceServer).StoreFileDelta(&grpc.GenericServerStream[DeltaChunk, StoreFileRes]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_StoreFileDeltaServer = grpc.ClientStreamingServer[DeltaChunk, StoreFileRes]
+
+func _MiniDFSService_StartUpload_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(StartUploadReq)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(MiniDFSServiceServer).StartUpload(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: MiniDFSService_StartUpload_FullMethodName,
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(MiniDFSServiceServer).StartUpload(ctx, req.(*StartUploadReq))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
+func _MiniDFSService_GetUploadStatus_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(UploadStatusReq)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(MiniDFSServiceServer).GetUploadStatus(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: MiniDFSService_GetUploadStatus_FullMethodName,
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(MiniDFSServiceServer).GetUploadStatus(ctx, req.(*UploadStatusReq))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
+func _MiniDFSService_UploadChunks_Handler(srv interface{}, stream grpc.ServerStream) error {
+	return srv.(MiniDFSServiceServer).UploadChunks(&grpc.GenericServerStream[FileBuffer, UploadStatus]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type MiniDFSService_UploadChunksServer = grpc.ClientStreamingServer[FileBuffer, UploadStatus]
+
 func _MiniDFSService_FetchFile_Handler(srv interface{}, stream grpc.ServerStream) error {
 	m := new(FetchFileReq)
 	if err := stream.RecvMsg(m); err != nil {
@@ -286,6 +582,24 @@ func _MiniDFSService_FileUpdateCallback_Handler(srv interface{}, stream grpc.Ser
 // This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
 type MiniDFSService_FileUpdateCallbackServer = grpc.ServerStreamingServer[FileUpdate]
 
+func _MiniDFSService_GetServerInfo_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(ServerInfoReq)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(MiniDFSServiceServer).GetServerInfo(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: MiniDFSService_GetServerInfo_FullMethodName,
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(MiniDFSServiceServer).GetServerInfo(ctx, req.(*ServerInfoReq))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
 // MiniDFSService_ServiceDesc is the grpc.ServiceDesc for MiniDFSService service.
 // It's only intended for direct use with grpc.RegisterService,
 // and not to be introspected or modified (even as a copy)
@@ -297,6 +611,22 @@ var MiniDFSService_ServiceDesc = grpc.ServiceDesc{
 			MethodName: "ListFiles",
 			Handler:    _MiniDFSService_ListFiles_Handler,
 		},
+		{
+			MethodName: "GetFileSignature",
+			Handler:    _MiniDFSService_GetFileSignature_Handler,
+		},
+		{
+			MethodName: "FindChunks",
+			Handler:    _MiniDFSService_FindChunks_Handler,
+		},
+		{
+			MethodName: "StartUpload",
+			Handler:    _MiniDFSService_StartUpload_Handler,
+		},
+		{
+			MethodName: "GetUploadStatus",
+			Handler:    _MiniDFSService_GetUploadStatus_Handler,
+		},
 		{
 			MethodName: "GetFileLock",
 			Handler:    _MiniDFSService_GetFileLock_Handler,
@@ -305,13 +635,37 @@ var MiniDFSService_ServiceDesc = grpc.ServiceDesc{
 			MethodName: "RemoveFile",
 			Handler:    _MiniDFSService_RemoveFile_Handler,
 		},
+		{
+			MethodName: "GetServerInfo",
+			Handler:    _MiniDFSService_GetServerInfo_Handler,
+		},
 	},
 	Streams: []grpc.StreamDesc{
+		{
+			StreamName:    "ListFilesStream",
+			Handler:       _MiniDFSService_ListFilesStream_Handler,
+			ServerStreams: true,
+		},
+		{
+			StreamName:    "WalkTree",
+			Handler:       _MiniDFSService_WalkTree_Handler,
+			ServerStreams: true,
+		},
 		{
 			StreamName:    "StoreFile",
 			Handler:       _MiniDFSService_StoreFile_Handler,
 			ClientStreams: true,
 		},
+		{
+			StreamName:    "StoreFileDelta",
+			Handler:       _MiniDFSService_StoreFileDelta_Handler,
+			ClientStreams: true,
+		},
+		{
+			StreamName:    "UploadChunks",
+			Handler:       _MiniDFSService_UploadChunks_Handler,
+			ClientStreams: true,
+		},
 		{
 			StreamName:    "FetchFile",
 			Handler:       _MiniDFSService_FetchFile_Handler,